@@ -0,0 +1,114 @@
+/**
+ *  \file
+ *  \brief Declarative filter for browse and resolve results
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_BROWSEFILTER_HPP_
+#define SRC_AVAHI_BROWSEFILTER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "Types.hpp"
+#include "Views.hpp"
+
+namespace Avahi {
+
+/** Filter which is applied to the raw D-Bus signals of a browser or
+ *  resolver, before any strings are copied or any handler is invoked.
+ *  Items which do not match are dropped silently.
+ *
+ *  All configured conditions must match.  An empty filter (default
+ *  constructed) accepts everything and costs a single check.
+ *
+ *  \code
+ *  client.async_createServiceBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "_http._tcp", "", {},
+ *      Avahi::BrowseFilter().interfaces({2, 3}).namePrefix("Orbiter"),
+ *      [](std::shared_ptr<Avahi::ServiceBrowser> const &browser, Glib::Error const &error) { ... });
+ *  \endcode
+ *
+ *  \sa Client::async_createServiceBrowser(), Client::async_createRecordBrowser(),
+ *      ServiceResolver::setFilter()
+ */
+class BrowseFilter
+{
+public:   // methods
+	/** Accepts only items on one of \a interfaces (OS specific indexes). */
+	BrowseFilter &interfaces(std::vector<Interface> interfaces);
+	/** Accepts only items with one of \a protocols (AVAHI_PROTO_INET or
+	 *  AVAHI_PROTO_INET6). */
+	BrowseFilter &protocols(std::vector<Protocol> protocols);
+	/** Accepts only names starting with \a prefix (case-sensitive, compared
+	 *  with the name as reported by Avahi). */
+	BrowseFilter &namePrefix(std::string prefix);
+	/** Accepts only names matching \a pattern, where '*' matches any
+	 *  sequence and '?' matches a single character (case-sensitive). */
+	BrowseFilter &nameGlob(std::string pattern);
+	/** Accepts only TXT data containing \a key (as "key" or "key=value";
+	 *  the key is compared case-insensitively, see RFC 6763, 6.4). */
+	BrowseFilter &txtHasKey(std::string key);
+	/** Accepts only TXT data containing "key=value" (the value is compared
+	 *  case-sensitively). */
+	BrowseFilter &txtEquals(std::string key, std::string value);
+
+	/** Whether no condition has been configured. */
+	bool empty() const { return m_empty; }
+	/** Whether a TXT condition has been configured.  TXT conditions are
+	 *  only checked where TXT data is available (resolvers and TXT
+	 *  records). */
+	bool hasTxtConditions() const { return !m_txt.empty(); }
+
+	/** Checks the interface, protocol and name conditions. */
+	bool matchItem(Interface interface, Protocol protocol, StringView name) const;
+
+	/** Checks the TXT conditions against \a strings (e.g. a TxtView or a
+	 *  TxtDataView).  Only the first occurrence of a key is considered (see
+	 *  RFC 6763, 6.4).  No allocations are made. */
+	template <typename TxtStrings>
+	bool matchTxt(TxtStrings const &strings) const
+	{
+		for (auto const &condition : m_txt)
+		{
+			bool found = false;
+			for (ByteView string : strings)
+			{
+				if (!condition.matchKey(string))
+					continue;
+
+				found = condition.matchValue(string);
+				break;  // later occurrences are ignored
+			}
+			if (!found)
+				return false;
+		}
+		return true;
+	}
+
+private:  // types
+	struct TxtCondition
+	{
+		std::string key;
+		std::string value;
+		bool hasValue;
+
+		/** Whether \a string ("key[=value]") has #key. */
+		bool matchKey(ByteView string) const;
+		/** Whether \a string (having #key) satisfies the condition. */
+		bool matchValue(ByteView string) const;
+	};
+
+private:  // members
+	bool m_empty = true;
+	std::vector<Interface> m_interfaces;
+	std::vector<Protocol> m_protocols;
+	std::string m_namePrefix;
+	std::string m_nameGlob;
+	bool m_hasNameGlob = false;
+	std::vector<TxtCondition> m_txt;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_BROWSEFILTER_HPP_ */
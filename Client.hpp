@@ -17,19 +17,35 @@
 #ifndef SRC_AVAHI_CLIENT_HPP_
 #define SRC_AVAHI_CLIENT_HPP_
 
+#include <array>
+#include <climits>                     // INT_MAX
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
+#include <giomm/asyncresult.h>
+#include <giomm/cancellable.h>
 #include <glibmm/refptr.h>
+#include <sigc++/connection.h>
 #include <sigc++/functors/slot.h>
 #include <sigc++/signal.h>
 
 #include <avahi-common/defs.h>         // ::AvahiServerState
 
+#include "Intern.hpp"
+#include "Metrics.hpp"
 #include "Types.hpp"
 
 extern "C" {
 	/** "Forward declaration" which avoids including the full <glib.h> file. */
 	typedef unsigned int    guint;
+	typedef unsigned long   gulong;
 }
 
 namespace Gio {
@@ -41,22 +57,105 @@ namespace DBus {
 namespace Glib {
 	class Error;
 	class ustring;
+	class VariantContainerBase;
 }  // namespace Glib
 
 namespace Avahi {
 
+class BrowseFilter;
 class EntryGroup;
 class RecordBrowser;
 class ServiceBrowser;
 class ServiceResolver;
+class SharedBrowser;
 
-/** Asynchronous D-Bus client for Avahi daemon. */
+/** Asynchronous D-Bus client for Avahi daemon.
+ *
+ *  All async_*() methods return a Gio::Cancellable which can be used for
+ *  aborting the operation.  The completion handler of a cancelled operation
+ *  is invoked with a Gio::Error with code Gio::Error::CANCELLED.
+ */
 class Client
 {
 	friend EntryGroup;
 	friend RecordBrowser;
 	friend ServiceBrowser;
 	friend ServiceResolver;
+	friend SharedBrowser;
+
+public:   // types
+	/** D-Bus methods for which an individual timeout can be configured via
+	 *  setTimeout(). */
+	enum class Operation
+	{
+		GetState,
+		GetHostName,
+		SetHostName,
+		ReconfirmRecord,
+		EntryGroupNew,
+		RecordBrowserPrepare,
+		ServiceBrowserPrepare,
+		ServiceResolverPrepare,
+		/** "Start" method of browsers and resolvers. */
+		Start,
+		/** "Free" method of entry groups, browsers and resolvers. */
+		Free,
+		AddService,
+		AddServiceSubtype,
+		Commit,
+		Reset,
+		UpdateServiceTxt,
+		Count  /**< Number of operations (not an operation). */
+	};
+
+	/** D-Bus signal types for which metrics are collected. */
+	enum class Signal
+	{
+		ServerStateChanged,
+		EntryGroupStateChanged,
+		ItemNew,
+		ItemRemove,
+		Found,
+		Failure,
+		AllForNow,
+		CacheExhausted,
+		/** Any other signal of an entry group, browser or resolver. */
+		Other,
+		Count  /**< Number of signal types (not a signal type). */
+	};
+
+	/** Priority classes of outgoing D-Bus calls (see setCallWindow()), in
+	 *  descending order. */
+	enum class Priority
+	{
+		/** Entry groups, host name and server state. */
+		Publish,
+		/** Service resolvers. */
+		Resolve,
+		/** ReconfirmRecord. */
+		Reconfirm,
+		/** Record and service browsers. */
+		Browse,
+		Count  /**< Number of priority classes (not a priority class). */
+	};
+
+	/** Snapshot of all metrics (see getMetrics()). */
+	struct Metrics
+	{
+		/** Indexed by Operation. */
+		std::array<CallMetrics, static_cast<std::size_t>(Operation::Count)> calls;
+		/** Indexed by Priority. */
+		std::array<QueueMetrics, static_cast<std::size_t>(Priority::Count)> queues;
+		/** Indexed by Signal. */
+		std::array<SignalMetrics, static_cast<std::size_t>(Signal::Count)> signals;
+		/** All live proxy objects. */
+		std::vector<ObjectMetrics> objects;
+	};
+
+	/** Default timeout [ms] for D-Bus method calls (same as libdbus). */
+	static constexpr int DefaultTimeout  = 25000;
+	/** Timeout value [ms] for waiting infinitely. */
+	static constexpr int InfiniteTimeout = INT_MAX;
 
 public:   // slots
 	/** Type for handler to invoke when connection to Avahi daemon has been established. */
@@ -65,6 +164,11 @@ public:   // slots
 	using SlotDisconnected          = sigc::signal<void()>;
 	/** Type for handler to invoke when Avahi server state has changed. */
 	using SlotServerStateChanged    = sigc::signal<void(::AvahiServerState state, Glib::ustring const &error)>;
+	/** Type for handler to invoke when the bootstrap queries have completed. */
+	using SlotBootstrapped          = sigc::signal<void()>;
+
+	/** Type for handler which periodically receives the current metrics. */
+	using SlotMetrics               = sigc::slot<void(Metrics const &metrics)>;
 
 	/** Completion type for async_getServerState. */
 	using SlotGetServerState        = sigc::slot<void(::AvahiServerState state, Glib::Error const &error)>;
@@ -74,6 +178,10 @@ public:   // slots
 	using SlotSetHostName           = sigc::slot<void(Glib::Error const &error)>;
 	/** Completion type for async_reconfirmRecord. */
 	using SlotReconfirmRecord       = sigc::slot<void(Glib::Error const &error)>;
+	/** Completion type for async_reconfirmService and async_reconfirmHost.
+	 *  \a records is the number of distinct records which have been
+	 *  reconfirmed. */
+	using SlotReconfirm             = sigc::slot<void(std::size_t records, Glib::Error const &error)>;
 	/** Completion type for async_createEntryGroup. */
 	using SlotCreateEntryGroup      = sigc::slot<void(std::shared_ptr<EntryGroup> const &group, Glib::Error const &error)>;
 	/** Completion type for async_createRecordBrowser(). */
@@ -99,6 +207,12 @@ public:   // slots
 	 */
 	SlotServerStateChanged on_serverStateChanged;
 
+	/** Handler to invoke when the replies to the bootstrap queries (see
+	 *  setBootstrap()) have been received, i.e. getServerState() and
+	 *  getHostName() return valid values (unless a query has failed).
+	 */
+	SlotBootstrapped on_bootstrapped;
+
 public:   // methods
 	Client();
 	~Client();
@@ -107,6 +221,189 @@ public:   // methods
 	Client& operator=(Client const &other) = delete;
 	Client& operator=(Client &&other) = delete;
 
+	/** Sets the timeout for all D-Bus method calls for which no individual
+	 *  timeout has been set via setTimeout().
+	 *
+	 *  \param[in]  timeout_msec  Timeout in milliseconds (or InfiniteTimeout).
+	 *
+	 *  \note If a call times out, its completion handler receives a
+	 *        Gio::Error with code Gio::Error::TIMED_OUT.
+	 */
+	void setDefaultTimeout(int timeout_msec);
+
+	/** Sets the timeout for a specific D-Bus method.
+	 *
+	 *  \param[in]  operation     D-Bus method.
+	 *  \param[in]  timeout_msec  Timeout in milliseconds (or InfiniteTimeout).
+	 *                            A value <= 0 reverts to the default timeout.
+	 */
+	void setTimeout(Operation operation, int timeout_msec);
+
+	/** Returns the effective timeout [ms] for a specific D-Bus method. */
+	int getTimeout(Operation operation) const;
+
+	/** Enables/disables the persistent session mode (disabled by default).
+	 *
+	 *  Without persistent session, all entry groups, browsers and resolvers
+	 *  become inoperative when the Avahi daemon vanishes (e.g. on restart)
+	 *  and have to be re-created by the application.
+	 *
+	 *  With persistent session, all live objects are re-created on the
+	 *  restarted daemon as soon as it re-appears (before #on_connected is
+	 *  invoked).  The according "*Prepare"/"EntryGroupNew" calls are sent at
+	 *  once, entry groups re-add their entries and are re-committed (if they
+	 *  have been committed before).  Browsers report all items again via
+	 *  on_itemNew (but items which are gone after the restart are not
+	 *  reported via on_itemRemove).
+	 */
+	void setPersistentSession(bool enable);
+
+	/** Sets how long [ms] an unused daemon side browser is kept after its
+	 *  last RecordBrowser/ServiceBrowser handle has been destroyed (0 by
+	 *  default: freed at once).  A browser with identical parameters which
+	 *  is created within this time re-uses it (see
+	 *  async_createServiceBrowser()), which absorbs churn of short-lived
+	 *  browsers.
+	 */
+	void setBrowserLinger(unsigned int linger_msec);
+
+	/** Configures how the daemon side objects of destroyed entry groups,
+	 *  browsers and resolvers are freed.
+	 *
+	 *  Destroying a proxy object only stops routing its signals; the
+	 *  according "Free" call is queued and sent from an idle handler, so
+	 *  tearing down many objects does not block the main loop and the
+	 *  daemon is not flooded with calls.
+	 *
+	 *  \param[in]  batchSize    Maximum number of "Free" calls sent per
+	 *                           main loop iteration (default 32).
+	 *  \param[in]  maxInFlight  Maximum number of unanswered "Free" calls
+	 *                           (default 128).  Further calls are sent when
+	 *                           replies arrive.
+	 *
+	 *  Values of 0 are treated as 1.
+	 */
+	void setReleaseBatching(std::size_t batchSize, std::size_t maxInFlight);
+
+	/** Limits the number of unanswered D-Bus calls to the Avahi daemon
+	 *  (unlimited by default).
+	 *
+	 *  Calls exceeding the window are queued per Priority class and sent
+	 *  when replies arrive: always from the highest non-empty class first,
+	 *  within a class round-robin between the daemon side objects (calls on
+	 *  the server object share a single queue), in order per object.  So a
+	 *  burst of resolver or browser requests cannot delay publishing by more
+	 *  than the round trip of a single call.  Queue depths and waiting
+	 *  times are reported via #Metrics::queues.
+	 *
+	 *  Queued calls are sent at once when the Avahi daemon vanishes (they
+	 *  fail) and are dropped without completion when the Client is
+	 *  destroyed.  The timeout of a call (see setTimeout()) includes the
+	 *  time spent in the queue: a call which is still queued when its
+	 *  timeout expires fails with G_IO_ERROR_TIMED_OUT without being sent.
+	 *  A cancelled call leaves the queue at once and fails with
+	 *  G_IO_ERROR_CANCELLED.
+	 *
+	 *  \param[in]  maxInFlight  Maximum number of unanswered calls; 0
+	 *                           disables the limit.
+	 */
+	void setCallWindow(std::size_t maxInFlight);
+
+	/** Sets the maximum number of idle entry groups kept for re-use (0 by
+	 *  default).
+	 *
+	 *  Entry groups which are handed back via recycleEntryGroup() are reset
+	 *  (instead of being freed) and returned by the next
+	 *  async_createEntryGroup(), which saves the "Free" and "EntryGroupNew"
+	 *  round trips when services are re-published often.  Reducing the
+	 *  size frees the surplus groups.
+	 */
+	void setEntryGroupPool(std::size_t maxSize);
+
+	/** Hands back an entry group which is not needed anymore (see
+	 *  setEntryGroupPool()).  Its handlers are disconnected and it is reset.
+	 *  If the pool is full, \a group is not attached to a daemon side object
+	 *  or still referenced elsewhere, this is the same as dropping
+	 *  \a group.
+	 */
+	void recycleEntryGroup(std::shared_ptr<EntryGroup> group);
+
+	/** Enables/disables the bootstrap mode (disabled by default).
+	 *
+	 *  In bootstrap mode, "GetState" and "GetHostName" are sent at once when
+	 *  the Avahi daemon appears (before #on_connected is invoked), so the
+	 *  application does not need to query them one after the other.  The
+	 *  results are cached (the server state is kept up to date via the
+	 *  "StateChanged" signal, the host name is re-queried after a host name
+	 *  change or collision) and can be read via getServerState() and
+	 *  getHostName().  #on_bootstrapped is invoked when both replies have
+	 *  arrived.
+	 *
+	 *  Additionally, async_createEntryGroup(), async_createRecordBrowser(),
+	 *  async_createServiceBrowser() and async_createServiceResolver() may
+	 *  be called before the daemon has appeared.  These requests are queued
+	 *  and sent in one burst (right after the bootstrap queries) as soon as
+	 *  the daemon appears.  Cancelling a queued request completes it with
+	 *  Gio::Error::CANCELLED.  Queued requests are dropped without completion
+	 *  when the Client is destroyed.
+	 */
+	void setBootstrap(bool enable);
+
+	/** Returns the cached server state (see setBootstrap()), std::nullopt
+	 *  while unknown (e.g. not connected). */
+	std::optional<::AvahiServerState> getServerState() const { return m_serverState; }
+
+	/** Returns the cached host name (see setBootstrap()), std::nullopt while
+	 *  unknown (e.g. not connected or during a host name change). */
+	std::optional<std::string> const &getHostName() const { return m_hostName; }
+
+	/** Detaches all live entry groups, browsers and resolvers from their
+	 *  daemon side objects and frees these (via the queue described in
+	 *  setReleaseBatching()).  The proxy objects become inoperative (also in
+	 *  persistent session mode) and have to be re-created by the
+	 *  application.  Pending reconfirmations fail.
+	 */
+	void releaseAll();
+
+	/** Returns a snapshot of all counters and histograms.
+	 *
+	 *  Call round trip times (#Metrics::calls) cover the Avahi daemon and the
+	 *  bus, signal handler times (#Metrics::signals) cover decoding and the
+	 *  application's handlers.
+	 *
+	 *  \note Must be called from the thread running the Client's main
+	 *        context.
+	 */
+	Metrics getMetrics() const;
+
+	/** Clears all counters and histograms (except the number of pending
+	 *  calls). */
+	void resetMetrics();
+
+	/** Invokes \a slot periodically with the current metrics (e.g. for
+	 *  exporting them to a monitoring system).
+	 *
+	 *  \param[in]  interval_msec  Export interval; 0 disables exporting.
+	 *  \param[in]  slot           Export handler.
+	 */
+	void setMetricsExport(unsigned int interval_msec, SlotMetrics const &slot);
+
+	/** Returns the D-Bus method name of \a operation. */
+	static char const *getOperationName(Operation operation);
+
+	/** Returns the name of \a signal. */
+	static char const *getSignalName(Signal signal);
+
+	/** Returns the name of \a priority. */
+	static char const *getPriorityName(Priority priority);
+
+	/** Interns a service type, domain or host name (see InternTable).  The
+	 *  returned Atom is valid as long as this Client. */
+	Atom intern(std::string_view string) { return m_interns.intern(string); }
+
+	/** Returns the table of all strings interned via intern(). */
+	InternTable const &getInternTable() const { return m_interns; }
+
 	/** Asynchronous getter for the current server state.  Usually this should
 	 *  be called once after the Client has been constructed and the
 	 *  #on_serverStateChanged handler has been registered in order to get the
@@ -117,7 +414,7 @@ public:   // methods
 	 *                          this handler will NOT be called from within this
 	 *                          function.
 	 */
-	void async_getServerState(SlotGetServerState const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_getServerState(SlotGetServerState const &completion);
 
 	/** Asynchronous getter for the Avahi host name.  The Avahi daemon uses the
 	 *  name provided by gethostname(2) as initial host name after startup.
@@ -127,7 +424,7 @@ public:   // methods
 	 *                          that this handler will NOT be called from within
 	 *                          this function.
 	 */
-	void async_getHostName(SlotGetHostName const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_getHostName(SlotGetHostName const &completion);
 
 	/** Asynchronous setter for the Avahi host name. Setting the hostname may be
 	 *  required if the name has changed after Avahi daemon startup.
@@ -141,7 +438,7 @@ public:   // methods
 	 *  \note The Avahi daemon will respond with an error if called with the
 	 *  same hostname as already set.
 	 */
-	void async_setHostName(Glib::ustring const &name, SlotSetHostName const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_setHostName(Glib::ustring const &name, SlotSetHostName const &completion);
 
 	/** Starts asynchronous reconfirmation of a mDNS entry.
 	 *
@@ -167,7 +464,44 @@ public:   // methods
 	 *  record, the according service type PTR record will also be reconfirmed.
 	 *  But this applies not the service subtype PTR records.
 	 */
-	void async_reconfirmRecord(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType type, RecordData const &data, SlotReconfirmRecord const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_reconfirmRecord(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType type, RecordData const &data, SlotReconfirmRecord const &completion);
+
+	/** Reconfirms all cached records of a service.
+	 *
+	 *  The service type PTR, SRV and TXT records of the service are looked
+	 *  up concurrently via record browsers (on all interfaces).  Each record
+	 *  is reconfirmed as soon as it has been found, so ReconfirmRecord calls
+	 *  are pipelined with browsing.  Records reported on several browsers
+	 *  are reconfirmed only once.  Browsing stops when the Avahi daemon has
+	 *  reported all cached records.
+	 *
+	 *  \param[in]  name        Service name (e.g. "My Printer").
+	 *  \param[in]  type        Service type (e.g. "_ipp._tcp").
+	 *  \param[in]  domain      Domain.  An empty string means ".local".
+	 *  \param[in]  completion  Asynchronous completion handler which is
+	 *                          invoked once after all records have been
+	 *                          reconfirmed.  It receives the first error
+	 *                          which occurred (other records are still
+	 *                          reconfirmed).  It is guaranteed that this
+	 *                          handler will NOT be called from within this
+	 *                          function.
+	 *
+	 *  \note Service subtype PTR records are not covered (their names are
+	 *        not known); use async_reconfirmRecord() for these.
+	 */
+	Glib::RefPtr<Gio::Cancellable> async_reconfirmService(ServiceName const &name, ServiceType const &type,
+	                                                       Domain const &domain, SlotReconfirm const &completion);
+
+	/** Reconfirms all cached records of a host.
+	 *
+	 *  Same as async_reconfirmService(), but for all records named \a host
+	 *  (A, AAAA, HINFO, ...) and the reverse lookup PTR records of all found
+	 *  addresses which point to \a host.
+	 *
+	 *  \param[in]  host        Fully qualified host name (e.g. "myhost.local").
+	 *  \param[in]  completion  See async_reconfirmService().
+	 */
+	Glib::RefPtr<Gio::Cancellable> async_reconfirmHost(Host const &host, SlotReconfirm const &completion);
 
 	/** Asynchronous builder for an Avahi entry group.  An entry group is
 	 *  used for publishing services.
@@ -180,7 +514,7 @@ public:   // methods
 	 *  \note Carefully read instructions in %<avahi git%>/avahi-common/defs.h
 	 *  about which server states are suitable for creating entry groups.
 	 */
-	void async_createEntryGroup(SlotCreateEntryGroup const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_createEntryGroup(SlotCreateEntryGroup const &completion);
 
 	/** Asynchronous builder for an Avahi record browser.  A record browser is
 	 *  used for enumerating arbitrary mDNS records from Avahi's internal
@@ -202,12 +536,26 @@ public:   // methods
 	 *  the the newly created service browser.  It is guaranteed that this
 	 *  handler will NOT be called from within this function.
 	 *
+	 *  \note Record browsers with identical parameters share a single daemon
+	 *        side object (see async_createServiceBrowser()).
+	 *
 	 *  \sa avahi_record_browser_new()
 	 */
-	void async_createRecordBrowser(Interface interface, Protocol protocol,
-	                               RecordName const &name, RecordClass clazz,
-	                               RecordType type, ::AvahiLookupFlags flags,
-	                               SlotCreateRecordBrowser const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_createRecordBrowser(Interface interface, Protocol protocol,
+	                                                         RecordName const &name, RecordClass clazz,
+	                                                         RecordType type, ::AvahiLookupFlags flags,
+	                                                         SlotCreateRecordBrowser const &completion);
+
+	/** Same as above, but the items reported by the returned browser are
+	 *  filtered by \a filter (interface, protocol and record name; TXT
+	 *  conditions are checked for TXT records only).  Browsers with
+	 *  different filters still share the daemon side object.
+	 */
+	Glib::RefPtr<Gio::Cancellable> async_createRecordBrowser(Interface interface, Protocol protocol,
+	                                                         RecordName const &name, RecordClass clazz,
+	                                                         RecordType type, ::AvahiLookupFlags flags,
+	                                                         BrowseFilter const &filter,
+	                                                         SlotCreateRecordBrowser const &completion);
 
 	/** Asynchronous builder for an Avahi service browser.  A service browser is
 	 *  used for finding Avahi services on the network.
@@ -227,12 +575,35 @@ public:   // methods
 	 *  the the newly created service browser.  It is guaranteed that this
 	 *  handler will NOT be called from within this function.
 	 *
+	 *  \note All service browsers with identical parameters (interface,
+	 *        protocol, type, domain and flags) share a single daemon side
+	 *        object.  A browser which is created while an identical one is
+	 *        alive receives all currently known services via on_itemNew
+	 *        (followed by on_cacheExhausted/on_allForNow if these have
+	 *        already been received) right after \a completion has
+	 *        returned.  The daemon side object is freed when the last
+	 *        browser has been destroyed (see setBrowserLinger()).  Without
+	 *        linger, a single browser does not record the known services;
+	 *        an identical browser created later gets its own daemon side
+	 *        object then.
+	 *
 	 *  \sa avahi_service_browser_new()
 	 */
-	void async_createServiceBrowser(Interface interface, Protocol protocol,
-	                                ServiceType const &type, Domain const &domain,
-	                                ::AvahiLookupFlags flags,
-	                                SlotCreateServiceBrowser const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_createServiceBrowser(Interface interface, Protocol protocol,
+	                                                          ServiceType const &type, Domain const &domain,
+	                                                          ::AvahiLookupFlags flags,
+	                                                          SlotCreateServiceBrowser const &completion);
+
+	/** Same as above, but the items reported by the returned browser are
+	 *  filtered by \a filter (interface, protocol and service name; TXT
+	 *  conditions are not applicable, see ServiceResolver::setFilter()).
+	 *  Browsers with different filters still share the daemon side object.
+	 */
+	Glib::RefPtr<Gio::Cancellable> async_createServiceBrowser(Interface interface, Protocol protocol,
+	                                                          ServiceType const &type, Domain const &domain,
+	                                                          ::AvahiLookupFlags flags,
+	                                                          BrowseFilter const &filter,
+	                                                          SlotCreateServiceBrowser const &completion);
 
 	/** Asynchronous builder for an Avahi service resolver.  A service resolver
 	 *  is used to resolve the hostname/address/port/txt of services found by
@@ -264,19 +635,278 @@ public:   // methods
 	 *
 	 *  \sa avahi_service_resolver_new()
 	 */
-	void async_createServiceResolver(Interface interface, Protocol protocol,
-	                                 ServiceName const &name, ServiceType const &type,
-	                                 Domain const &domain, Protocol aprotocol,
-	                                 ::AvahiLookupFlags flags,
-	                                 SlotCreateServiceResolver const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_createServiceResolver(Interface interface, Protocol protocol,
+	                                                           ServiceName const &name, ServiceType const &type,
+	                                                           Domain const &domain, Protocol aprotocol,
+	                                                           ::AvahiLookupFlags flags,
+	                                                           SlotCreateServiceResolver const &completion);
+
+private:  // types
+	/** Type for handler which receives the D-Bus signals of a single proxy
+	 *  object (entry group, browser, resolver). */
+	using SlotSignal = sigc::slot<void(std::string_view signalName, Glib::VariantContainerBase const &parameters)>;
+	/** Type for handler which is invoked on a proxy object when the Avahi
+	 *  daemon has vanished (\a available == false) or, in persistent session
+	 *  mode, has re-appeared (\a available == true). */
+	using SlotSession = sigc::slot<void(bool available)>;
+	/** Type for handler which receives the object path of a re-created
+	 *  daemon side object (or the error why it could not be re-created). */
+	using SlotRebind = sigc::slot<void(Glib::ustring const &objectPath, Glib::Error const &error)>;
+	/** Completion type for acquireBrowser(). */
+	using SlotAcquireBrowser = sigc::slot<void(std::shared_ptr<SharedBrowser> const &browser, Glib::Error const &error)>;
+
+	struct CallCounters
+	{
+		std::uint64_t calls = 0;
+		std::uint64_t failures = 0;
+		std::uint64_t pending = 0;
+		Histogram latency;
+	};
+
+	struct SignalCounters
+	{
+		std::uint64_t received = 0;
+		std::uint64_t unrouted = 0;
+		std::uint64_t parseErrors = 0;
+		Histogram handlerTime;
+	};
+
+	struct ObjectCounters
+	{
+		std::string interfaceName;
+		std::uint64_t signals = 0;
+		std::uint64_t parseErrors = 0;
+	};
+
+	/** State of a pending async_reconfirmService()/async_reconfirmHost(). */
+	class Reconfirm;
+
+	/** Signal routing entry of a live proxy object. */
+	struct Route
+	{
+		/** Referenced by the key in #m_objects. */
+		std::string objectPath;
+		/** D-Bus interface of the daemon side object (for releaseAll()). */
+		char const *interfaceName;
+		SlotSignal slot;
+		ObjectCounters counters;
+	};
+
+	/** Request which waits for the Avahi daemon (see setBootstrap()). */
+	struct Deferred
+	{
+		Glib::RefPtr<Gio::Cancellable> cancellable;
+		gulong cancelHandler;
+		/** Sends the request. */
+		sigc::slot<void()> start;
+		/** Completes the request with an error. */
+		sigc::slot<void(Glib::Error const &error)> fail;
+	};
+
+	/** Queued calls of a single Priority class (see setCallWindow()). */
+	struct CallQueue;
+
+	/** Queued "Free" call (see releaseObject()). */
+	struct Release
+	{
+		std::string objectPath;
+		char const *interfaceName;
+	};
 
 private:  // methods
 	Glib::RefPtr<Gio::DBus::Connection> const &getConnection();
 
+	/** Invokes a method of the Avahi daemon using the configured timeout for
+	 *  \a operation (queued if the call window is full, see
+	 *  setCallWindow()). */
+	void call(Operation operation, Glib::ustring const &objectPath,
+	          char const *interfaceName, char const *methodName,
+	          Glib::VariantContainerBase const &parameters,
+	          Gio::SlotAsyncReady const &slot,
+	          Glib::RefPtr<Gio::Cancellable> const &cancellable = {});
+	/** Sends a call via \a connection (bypassing the call window). */
+	void sendCall(Operation operation, Glib::RefPtr<Gio::DBus::Connection> const &connection,
+	              Glib::ustring const &objectPath,
+	              char const *interfaceName, char const *methodName,
+	              Glib::VariantContainerBase const &parameters,
+	              Gio::SlotAsyncReady const &slot,
+	              Glib::RefPtr<Gio::Cancellable> const &cancellable,
+	              int timeout_msec = 0);
+	/** Sends queued calls while the call window has free slots (all of
+	 *  them if \a all is set). */
+	void drainCalls(bool all = false);
+	/** Removes cancelled calls and calls whose timeout has expired from the
+	 *  queues and completes them. */
+	void expireCalls();
+	bool onCallCancelled();
+	bool onCallTimer();
+	/** Ensures that expireCalls() runs not later than at \a deadline
+	 *  (monotonic time). */
+	void scheduleCallTimer(std::int64_t deadline);
+	/** Completes a call with G_IO_ERROR_TIMED_OUT without sending it. */
+	void failCall(Operation operation, Glib::RefPtr<Gio::DBus::Connection> const &connection,
+	              Gio::SlotAsyncReady const &slot);
+	/** Returns the priority class of a call. */
+	static Priority getPriority(Operation operation, char const *interfaceName);
+
+	/** Routes all D-Bus signals for \a objectPath (implementing
+	 *  \a interfaceName) to \a slot.  Must be called before the Avahi object
+	 *  is started. */
+	void registerObject(Glib::ustring const &objectPath, char const *interfaceName, SlotSignal const &slot);
+	/** Stops routing D-Bus signals for \a objectPath. */
+	void unregisterObject(Glib::ustring const &objectPath);
+	/** Stops routing D-Bus signals for \a objectPath and queues freeing
+	 *  the daemon side object (called by the proxy objects on
+	 *  destruction). */
+	void releaseObject(Glib::ustring const &objectPath, char const *interfaceName);
+	/** Installs the idle handler for sending queued "Free" calls (if
+	 *  required and not already done). */
+	void scheduleReleases();
+	/** Idle handler, sends up to #m_releaseBatchSize queued "Free" calls. */
+	bool flushReleases();
+
+	/** Sends "GetState" and "GetHostName" for filling the caches. */
+	void bootstrap();
+	/** Sends "GetHostName" for filling the host name cache. */
+	void queryHostName();
+	/** Invokes \a start at once if connected.  Otherwise (in bootstrap
+	 *  mode) queues it until the daemon appears; \a fail is invoked if
+	 *  \a cancellable is cancelled before. */
+	void whenConnected(Glib::RefPtr<Gio::Cancellable> const &cancellable,
+	                   sigc::slot<void()> const &start,
+	                   sigc::slot<void(Glib::Error const &error)> const &fail);
+	/** Idle handler, completes all cancelled queued requests. */
+	bool failCancelled();
+	/** Looks up the proxy object for \a objectPath and forwards the signal. */
+	void dispatchSignal(std::string_view objectPath, char const *interfaceName,
+	                    std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	/** Counts a parse error for the signal currently being dispatched
+	 *  (called by the proxy objects). */
+	void parseError();
+	/** Updates the call metrics when a call has completed. */
+	void completeCall(Operation operation, std::int64_t started, Glib::RefPtr<Gio::AsyncResult> const &result);
+
+	/** Returns the shared daemon side browser for \a parameters, creating
+	 *  (preparing) it if there is none yet.  \a completion is never invoked
+	 *  from within this function.
+	 *
+	 *  \param[in]  operation       "*Prepare" operation.
+	 *  \param[in]  methodName      Name of the D-Bus method for \a operation.
+	 *  \param[in]  interfaceName   D-Bus interface of the browser.
+	 *  \param[in]  parameters      Parameters of \a methodName.
+	 *  \param[in]  cancellable     Cancels only this request (other requests
+	 *                              for the same browser are not affected).
+	 *  \param[in]  completion      Receives the browser or an error.
+	 */
+	void acquireBrowser(Operation operation, char const *methodName, char const *interfaceName,
+	                    Glib::VariantContainerBase const &parameters,
+	                    Glib::RefPtr<Gio::Cancellable> const &cancellable,
+	                    SlotAcquireBrowser const &completion);
+	/** Called by a browser handle on destruction (after unsubscribing),
+	 *  lets \a browser linger if it is unused now. */
+	void releaseBrowser(std::shared_ptr<SharedBrowser> const &browser);
+
+	/** Registers a proxy object for being notified about vanishing and
+	 *  re-appearing of the Avahi daemon. */
+	void registerSession(void const *object, SlotSession const &slot);
+	/** Reverts registerSession(). */
+	void unregisterSession(void const *object);
+	/** Re-creates the daemon side object of a proxy object after restart of
+	 *  the Avahi daemon.
+	 *
+	 *  \param[in]  operation       "*Prepare" or "EntryGroupNew" operation.
+	 *  \param[in]  methodName      Name of the D-Bus method for \a operation.
+	 *  \param[in]  parameters      Parameters originally used for creation.
+	 *  \param[in]  interfaceName   D-Bus interface of the created object
+	 *                              (used for freeing it if \a owner has
+	 *                              been destroyed in the meantime).
+	 *  \param[in]  owner           The proxy object.
+	 *  \param[in]  rebind          Invoked with the new object path or an
+	 *                              error (only if \a owner is still alive).
+	 */
+	void restoreObject(Operation operation, char const *methodName,
+	                   Glib::VariantContainerBase const &parameters,
+	                   char const *interfaceName,
+	                   std::weak_ptr<void const> const &owner,
+	                   SlotRebind const &rebind);
+
 private:  // members
 	guint m_watchHandle;
 	Glib::RefPtr<Gio::DBus::Connection> m_connection;
 	guint m_stateChanged;
+	/** One signal subscription per Avahi object interface.  Routing to the
+	 *  individual proxy objects is done via #m_objects, so the number of
+	 *  D-Bus match rules does not grow with the number of objects. */
+	std::vector<guint> m_objectSignals;
+	/** Signal handlers of all live proxy objects, keyed by object path.
+	 *  Looking up the (borrowed) path of a received signal does not
+	 *  allocate. */
+	std::unordered_map<std::string_view, std::unique_ptr<Route>> m_objects;
+	/** Session handlers of all live proxy objects. */
+	std::unordered_map<void const *, SlotSession> m_sessions;
+	bool m_persistentSession;
+	int m_defaultTimeout;
+	/** Individual timeouts per operation, <= 0 means "use default". */
+	std::array<int, static_cast<std::size_t>(Operation::Count)> m_timeouts;
+
+	std::array<CallCounters, static_cast<std::size_t>(Operation::Count)> m_callMetrics;
+	std::array<SignalCounters, static_cast<std::size_t>(Signal::Count)> m_signalMetrics;
+	/** Object and signal type currently being dispatched (for parseError()). */
+	ObjectCounters *m_dispatchObject;
+	Signal m_dispatchSignal;
+	sigc::connection m_metricsExport;
+
+	InternTable m_interns;
+
+	/** Daemon side browsers by interface and serialized "*Prepare"
+	 *  parameters (owned by the browser handles). */
+	std::unordered_map<std::string, std::weak_ptr<SharedBrowser>> m_browsers;
+	unsigned int m_browserLinger;
+	/** Unused browsers which are kept for #m_browserLinger ms. */
+	std::unordered_map<SharedBrowser const *, std::shared_ptr<SharedBrowser>> m_lingeringBrowsers;
+
+	bool m_bootstrap;
+	std::optional<::AvahiServerState> m_serverState;
+	std::optional<std::string> m_hostName;
+	/** Number of outstanding bootstrap queries. */
+	unsigned int m_bootstrapPending;
+	/** Incremented whenever the daemon vanishes, replies to queries of an
+	 *  earlier daemon instance are dropped (the bus connection stays the
+	 *  same). */
+	unsigned int m_sessionGeneration;
+	/** Requests which have been issued before the daemon has appeared. */
+	std::vector<Deferred> m_deferred;
+	sigc::connection m_deferredCancel;
+
+	/** See setCallWindow(), 0 means unlimited. */
+	std::size_t m_callWindow;
+	/** Number of unanswered calls. */
+	std::size_t m_callsInFlight;
+	/** Expires with this object.  Call completions only hold a weak
+	 *  reference, as replies may arrive after destruction. */
+	std::shared_ptr<Client *> m_lifetime;
+	/** Indexed by Priority. */
+	std::array<std::unique_ptr<CallQueue>, static_cast<std::size_t>(Priority::Count)> m_callQueues;
+	/** Idle handler for removing cancelled calls from the queues. */
+	sigc::connection m_callCancel;
+	/** Timer for the earliest timeout of a queued call. */
+	sigc::connection m_callTimer;
+	std::int64_t m_callTimerDeadline;
+
+	/** Idle entry groups (see setEntryGroupPool()). */
+	std::vector<std::shared_ptr<EntryGroup>> m_entryGroupPool;
+	std::size_t m_entryGroupPoolSize;
+
+	/** "Free" calls which have not been sent yet (in order of release). */
+	std::deque<Release> m_releases;
+	std::size_t m_releaseBatchSize;
+	std::size_t m_releaseMaxInFlight;
+	std::size_t m_releasesInFlight;
+	sigc::connection m_releaseFlush;
+
+	/** Pending bulk reconfirmations (destroyed first, as they own record
+	 *  browsers). */
+	std::unordered_map<Reconfirm const *, std::shared_ptr<Reconfirm>> m_reconfirms;
 };
 
 } /* namespace Avahi */
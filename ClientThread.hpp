@@ -0,0 +1,138 @@
+/**
+ *  \file
+ *  \brief Avahi client running on a dedicated worker thread
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_CLIENTTHREAD_HPP_
+#define SRC_AVAHI_CLIENTTHREAD_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <glibmm/main.h>
+#include <glibmm/refptr.h>
+
+#include "Client.hpp"
+
+namespace Avahi {
+
+/** Runs a Client (and all its entry groups, browsers and resolvers) on a
+ *  private GMainContext and thread.
+ *
+ *  Subscribing to and decoding of D-Bus signals, as well as all handlers
+ *  connected to the proxy objects, run on the worker thread.  Results are
+ *  handed over to the application via post(), which appends them to a
+ *  lock-free queue.  The queue is drained on a target GMainContext (or by a
+ *  custom executor) in a single dispatch, limited by a configurable time
+ *  budget, so large discovery bursts do not block the application's
+ *  main loop.
+ *
+ *  \code
+ *  Avahi::ClientThread worker;  // delivers to the caller's thread default context
+ *
+ *  worker.invoke([&worker](Avahi::Client &client)
+ *  {
+ *      client.async_createServiceBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "_http._tcp", "", {},
+ *          [&worker](std::shared_ptr<Avahi::ServiceBrowser> const &browser, Glib::Error const &error)
+ *          {
+ *              // runs on the worker thread; keep 'browser' alive there
+ *              browser->on_itemsChanged.connect([&worker](auto const &added, auto const &removed)
+ *              {
+ *                  worker.post([added, removed] { ... });  // runs on the target context
+ *              });
+ *          });
+ *  });
+ *  \endcode
+ *
+ *  \note The Client and all proxy objects must only be used on the worker
+ *        thread (i.e. from within invoke() or from their own handlers).
+ *        Views passed to handlers must be copied before being posted.
+ *        Proxy objects must be released on the worker thread before the
+ *        ClientThread is destroyed.
+ */
+class ClientThread
+{
+public:   // types
+	/** Work item executed on the worker thread. */
+	using Task  = std::function<void(Client &client)>;
+	/** Work item executed on the target context / by the executor. */
+	using Work  = std::function<void()>;
+
+public:   // slots
+	/** Type for a custom executor.  It is invoked (from an arbitrary thread)
+	 *  when work has been queued while no dispatch was pending, and must
+	 *  arrange for dispatch() to be called on the consuming thread. */
+	using SlotWakeup = std::function<void()>;
+
+public:   // methods
+	/** Starts the worker thread.
+	 *
+	 *  \param[in]  target  Context on which posted work is executed.  If
+	 *                      empty, the thread default context of the calling
+	 *                      thread is used.
+	 */
+	explicit ClientThread(Glib::RefPtr<Glib::MainContext> const &target = {});
+
+	/** Starts the worker thread, delivering posted work via a custom
+	 *  executor (see #SlotWakeup). */
+	explicit ClientThread(SlotWakeup const &wakeup);
+
+	/** Destroys the Client and stops the worker thread.  Work which has not
+	 *  been executed yet is discarded.  Must not be called from the worker
+	 *  thread. */
+	~ClientThread();
+	ClientThread(ClientThread const &other) = delete;
+	ClientThread(ClientThread &&other) = delete;
+	ClientThread& operator=(ClientThread const &other) = delete;
+	ClientThread& operator=(ClientThread &&other) = delete;
+
+	/** Executes \a task on the worker thread (thread-safe).  If called on the
+	 *  worker thread, \a task is executed immediately. */
+	void invoke(Task task);
+
+	/** Queues \a work for execution on the target context, or by the
+	 *  executor (thread-safe, lock-free). */
+	void post(Work work);
+
+	/** Executes queued work, until the queue is empty or the dispatch budget
+	 *  is exhausted (in which case another dispatch is requested).  Only
+	 *  needs to be called explicitly when using a custom executor.
+	 *
+	 *  \return Number of executed work items.
+	 */
+	std::size_t dispatch();
+
+	/** Limits the time spent per dispatch() (default: 5 ms, 0 = unlimited).
+	 *  Thread-safe. */
+	void setDispatchBudget(unsigned int budget_usec);
+
+	/** Returns the private context of the worker thread. */
+	Glib::RefPtr<Glib::MainContext> const &getContext() const { return m_context; }
+
+	/** Returns true if called on the worker thread. */
+	bool isWorkerThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+private:  // types
+	/** Lock-free multi producer single consumer queue plus wakeup state
+	 *  (shared with pending wakeup sources on the target context). */
+	class Mailbox;
+
+private:  // methods
+	void run();
+
+private:  // members
+	Glib::RefPtr<Glib::MainContext> m_context;
+	Glib::RefPtr<Glib::MainLoop> m_loop;
+	std::shared_ptr<Mailbox> m_mailbox;
+	/** Only accessed on the worker thread. */
+	std::unique_ptr<Client> m_client;
+	std::thread m_thread;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_CLIENTTHREAD_HPP_ */
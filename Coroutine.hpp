@@ -0,0 +1,597 @@
+/**
+ *  \file
+ *  \brief C++20 coroutine front-end for the asynchronous Avahi operations
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  This header is optional and requires C++20.  It provides awaitable
+ *  variants of the async_*() methods of Client and EntryGroup:
+ *
+ *  \code
+ *  Avahi::Coro::Task<> publish(Avahi::Client &client)
+ *  {
+ *      auto group = co_await Avahi::Coro::createEntryGroup(client);
+ *      co_await Avahi::Coro::addService(*group, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {},
+ *                                       "myService", "_http._tcp", "", "", 80, {});
+ *      co_await Avahi::Coro::commit(*group);
+ *  }
+ *
+ *  Avahi::Coro::spawn(publish(client));
+ *  \endcode
+ *
+ *  Errors are reported by throwing the Glib::Error which would have been
+ *  passed to the completion handler.  As the completion handlers are invoked
+ *  from the GMainContext which issued the D-Bus call, a coroutine is always
+ *  resumed on the same GMainContext.  The completion state (result, error)
+ *  is stored in the awaiter, i.e. inside the coroutine frame.
+ *
+ *  \note A Task must not be destroyed while it is suspended in an Avahi
+ *        operation.  Use spawn() for fire-and-forget tasks; they destroy
+ *        themselves on completion.
+ */
+
+#ifndef SRC_AVAHI_COROUTINE_HPP_
+#define SRC_AVAHI_COROUTINE_HPP_
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "Coroutine.hpp requires C++20 coroutine support"
+#endif
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <giomm/cancellable.h>
+#include <glibmm/error.h>
+#include <glibmm/refptr.h>
+#include <glibmm/ustring.h>
+
+#include "Client.hpp"
+#include "EntryGroup.hpp"
+#include "RecordBrowser.hpp"
+#include "ServiceBrowser.hpp"
+#include "ServiceResolver.hpp"
+
+/** \brief Coroutine front-end for the Avahi D-Bus client library */
+namespace Avahi::Coro {
+
+template <typename T = void>
+class Task;
+
+namespace Detail {
+
+/** Common part of the promise types of Task. */
+class TaskPromiseBase
+{
+public:   // types
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+		{
+			auto &promise = handle.promise();
+
+			if (promise.m_detached)
+			{
+				handle.destroy();
+				return std::noop_coroutine();
+			}
+			return promise.m_continuation ? promise.m_continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+public:   // methods
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+
+	void unhandled_exception()
+	{
+		/* Like for std::thread, there is nobody who could handle an
+		 * exception of a detached task. */
+		if (m_detached)
+			std::terminate();
+		m_exception = std::current_exception();
+	}
+
+	void rethrow() const
+	{
+		if (m_exception)
+			std::rethrow_exception(m_exception);
+	}
+
+public:   // members
+	std::coroutine_handle<> m_continuation;
+	std::exception_ptr m_exception;
+	bool m_detached = false;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:   // methods
+	Task<T> get_return_object() noexcept;
+
+	template <typename U>
+	void return_value(U &&value) { m_value.emplace(std::forward<U>(value)); }
+
+	T result()
+	{
+		rethrow();
+		return std::move(*m_value);
+	}
+
+private:  // members
+	std::optional<T> m_value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:   // methods
+	Task<void> get_return_object() noexcept;
+
+	void return_void() const noexcept {}
+	void result() const { rethrow(); }
+};
+
+/** Awaiter for an operation whose completion receives (value, error). */
+template <typename Value, typename Start>
+class OperationAwaiter
+{
+public:   // methods
+	explicit OperationAwaiter(Start start)
+	: m_start(std::move(start))
+	{}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		/* the completion is never invoked from within the async_*() method */
+		m_cancellable = m_start([this, handle](Value const &value, Glib::Error const &error)
+		{
+			if (error)
+				m_error = error;
+			else
+				m_value = value;
+			handle.resume();
+		});
+	}
+
+	Value await_resume()
+	{
+		if (m_error)
+			throw *m_error;
+		return std::move(*m_value);
+	}
+
+private:  // members
+	Start m_start;
+	Glib::RefPtr<Gio::Cancellable> m_cancellable;
+	std::optional<Value> m_value;
+	std::optional<Glib::Error> m_error;
+};
+
+/** Awaiter for an operation whose completion receives only an error. */
+template <typename Start>
+class VoidOperationAwaiter
+{
+public:   // methods
+	explicit VoidOperationAwaiter(Start start)
+	: m_start(std::move(start))
+	{}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle)
+	{
+		m_cancellable = m_start([this, handle](Glib::Error const &error)
+		{
+			if (error)
+				m_error = error;
+			handle.resume();
+		});
+	}
+
+	void await_resume()
+	{
+		if (m_error)
+			throw *m_error;
+	}
+
+private:  // members
+	Start m_start;
+	Glib::RefPtr<Gio::Cancellable> m_cancellable;
+	std::optional<Glib::Error> m_error;
+};
+
+template <typename Value, typename Start>
+OperationAwaiter<Value, Start> makeAwaiter(Start start)
+{
+	return OperationAwaiter<Value, Start>(std::move(start));
+}
+
+template <typename Start>
+VoidOperationAwaiter<Start> makeVoidAwaiter(Start start)
+{
+	return VoidOperationAwaiter<Start>(std::move(start));
+}
+
+} /* namespace Detail */
+
+/** Lazily started coroutine which produces a value of type \a T.  A task
+ *  starts running when it is awaited (or passed to spawn()). */
+template <typename T>
+class [[nodiscard]] Task
+{
+public:   // types
+	using promise_type = Detail::TaskPromise<T>;
+
+public:   // methods
+	explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+	: m_handle(handle)
+	{}
+
+	Task(Task &&other) noexcept
+	: m_handle(std::exchange(other.m_handle, {}))
+	{}
+
+	Task &operator=(Task &&other) noexcept
+	{
+		if (this != &other)
+		{
+			if (m_handle)
+				m_handle.destroy();
+			m_handle = std::exchange(other.m_handle, {});
+		}
+		return *this;
+	}
+
+	~Task()
+	{
+		if (m_handle)
+			m_handle.destroy();
+	}
+
+	Task(Task const &other) = delete;
+	Task& operator=(Task const &other) = delete;
+
+	bool await_ready() const noexcept { return false; }
+
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+	{
+		m_handle.promise().m_continuation = continuation;
+		return m_handle;
+	}
+
+	T await_resume() { return m_handle.promise().result(); }
+
+	/** Starts the task without waiting for its result.  The coroutine frame
+	 *  is freed when the task has finished. */
+	void detach() &&
+	{
+		auto handle = std::exchange(m_handle, {});
+
+		handle.promise().m_detached = true;
+		handle.resume();
+	}
+
+private:  // members
+	std::coroutine_handle<promise_type> m_handle;
+};
+
+template <typename T>
+Task<T> Detail::TaskPromise<T>::get_return_object() noexcept
+{
+	return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> Detail::TaskPromise<void>::get_return_object() noexcept
+{
+	return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/** Starts a fire-and-forget task.  The task must handle all exceptions
+ *  itself; an escaping exception terminates the program. */
+inline void spawn(Task<void> task)
+{
+	std::move(task).detach();
+}
+
+namespace Detail {
+
+/** Shared state of when_all(). */
+struct WhenAllState
+{
+	std::size_t pending;
+	std::coroutine_handle<> parent;
+	std::exception_ptr exception;
+
+	/** Called by each sub task when it has finished. */
+	void finish()
+	{
+		if (--pending == 0)
+			parent.resume();
+	}
+};
+
+template <typename T, typename Result>
+Task<void> whenAllItem(Task<T> task, WhenAllState &state, Result &result)
+{
+	try
+	{
+		if constexpr (std::is_void_v<T>)
+			co_await std::move(task);
+		else
+			result.emplace(co_await std::move(task));
+	}
+	catch (...)
+	{
+		if (!state.exception)
+			state.exception = std::current_exception();
+	}
+	state.finish();
+}
+
+/** Awaiter which starts all sub tasks and resumes after the last one has
+ *  finished. */
+template <typename Starter>
+class WhenAllAwaiter
+{
+public:   // methods
+	WhenAllAwaiter(WhenAllState &state, Starter starter)
+	: m_state(state)
+	, m_starter(std::move(starter))
+	{}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool await_suspend(std::coroutine_handle<> parent)
+	{
+		m_state.parent = parent;
+		m_starter();
+
+		/* one extra count avoids resuming from within await_suspend() if
+		 * all sub tasks complete synchronously */
+		return --m_state.pending != 0;
+	}
+
+	void await_resume() const
+	{
+		if (m_state.exception)
+			std::rethrow_exception(m_state.exception);
+	}
+
+private:  // members
+	WhenAllState &m_state;
+	Starter m_starter;
+};
+
+struct Unit {};
+
+} /* namespace Detail */
+
+/** Runs all \a tasks concurrently and returns their results (in the same
+ *  order).  If any task throws, the first exception is re-thrown after all
+ *  tasks have finished. */
+template <typename T>
+Task<std::vector<T>> when_all(std::vector<Task<T>> tasks)
+{
+	Detail::WhenAllState state{tasks.size() + 1, {}, {}};
+	std::vector<std::optional<T>> results(tasks.size());
+
+	co_await Detail::WhenAllAwaiter(state, [&]
+	{
+		for (std::size_t index = 0; index < tasks.size(); index++)
+			Detail::whenAllItem(std::move(tasks[index]), state, results[index]).detach();
+	});
+
+	std::vector<T> values;
+	values.reserve(results.size());
+	for (auto &result : results)
+		values.push_back(std::move(*result));
+	co_return values;
+}
+
+/** Runs all \a tasks concurrently and waits until all have finished.  If any
+ *  task throws, the first exception is re-thrown after all tasks have
+ *  finished. */
+inline Task<void> when_all(std::vector<Task<void>> tasks)
+{
+	Detail::WhenAllState state{tasks.size() + 1, {}, {}};
+	std::optional<Detail::Unit> unused;
+
+	co_await Detail::WhenAllAwaiter(state, [&]
+	{
+		for (auto &task : tasks)
+			Detail::whenAllItem(std::move(task), state, unused).detach();
+	});
+}
+
+/** Runs tasks of different (non-void) types concurrently and returns all
+ *  results as tuple. */
+template <typename... T>
+Task<std::tuple<T...>> when_all(Task<T>... tasks)
+{
+	Detail::WhenAllState state{sizeof...(T) + 1, {}, {}};
+	std::tuple<std::optional<T>...> results;
+
+	co_await Detail::WhenAllAwaiter(state, [&]
+	{
+		std::apply([&](auto &...result)
+		{
+			(Detail::whenAllItem(std::move(tasks), state, result).detach(), ...);
+		}, results);
+	});
+
+	co_return std::apply([](auto &...result)
+	{
+		return std::tuple<T...>(std::move(*result)...);
+	}, results);
+}
+
+/*
+ * Client operations
+ */
+
+/** Awaitable variant of Client::async_getServerState(). */
+inline auto getServerState(Client &client)
+{
+	return Detail::makeAwaiter<::AvahiServerState>([&client](auto const &completion)
+	{
+		return client.async_getServerState(completion);
+	});
+}
+
+/** Awaitable variant of Client::async_getHostName(). */
+inline auto getHostName(Client &client)
+{
+	return Detail::makeAwaiter<Glib::ustring>([&client](auto const &completion)
+	{
+		return client.async_getHostName(completion);
+	});
+}
+
+/** Awaitable variant of Client::async_setHostName(). */
+inline auto setHostName(Client &client, Glib::ustring name)
+{
+	return Detail::makeVoidAwaiter([&client, name = std::move(name)](auto const &completion)
+	{
+		return client.async_setHostName(name, completion);
+	});
+}
+
+/** Awaitable variant of Client::async_reconfirmRecord(). */
+inline auto reconfirmRecord(Client &client, Interface interface, Protocol protocol,
+                            RecordName name, RecordClass clazz, RecordType type,
+                            RecordData data)
+{
+	return Detail::makeVoidAwaiter([=, &client](auto const &completion)
+	{
+		return client.async_reconfirmRecord(interface, protocol, name, clazz, type, data, completion);
+	});
+}
+
+/** Awaitable variant of Client::async_createEntryGroup(). */
+inline auto createEntryGroup(Client &client)
+{
+	return Detail::makeAwaiter<std::shared_ptr<EntryGroup>>([&client](auto const &completion)
+	{
+		return client.async_createEntryGroup(completion);
+	});
+}
+
+/** Awaitable variant of Client::async_createRecordBrowser(). */
+inline auto createRecordBrowser(Client &client, Interface interface, Protocol protocol,
+                                RecordName name, RecordClass clazz, RecordType type,
+                                ::AvahiLookupFlags flags)
+{
+	return Detail::makeAwaiter<std::shared_ptr<RecordBrowser>>([=, &client](auto const &completion)
+	{
+		return client.async_createRecordBrowser(interface, protocol, name, clazz, type, flags, completion);
+	});
+}
+
+/** Awaitable variant of Client::async_createServiceBrowser(). */
+inline auto createServiceBrowser(Client &client, Interface interface, Protocol protocol,
+                                 ServiceType type, Domain domain,
+                                 ::AvahiLookupFlags flags)
+{
+	return Detail::makeAwaiter<std::shared_ptr<ServiceBrowser>>([=, &client](auto const &completion)
+	{
+		return client.async_createServiceBrowser(interface, protocol, type, domain, flags, completion);
+	});
+}
+
+/** Awaitable variant of Client::async_createServiceResolver(). */
+inline auto createServiceResolver(Client &client, Interface interface, Protocol protocol,
+                                  ServiceName name, ServiceType type, Domain domain,
+                                  Protocol aprotocol, ::AvahiLookupFlags flags)
+{
+	return Detail::makeAwaiter<std::shared_ptr<ServiceResolver>>([=, &client](auto const &completion)
+	{
+		return client.async_createServiceResolver(interface, protocol, name, type, domain, aprotocol, flags, completion);
+	});
+}
+
+/*
+ * EntryGroup operations
+ */
+
+/** Awaitable variant of EntryGroup::async_addService(). */
+inline auto addService(EntryGroup &group, Interface interface, Protocol protocol,
+                       ::AvahiPublishFlags flags, ServiceName name, ServiceType type,
+                       Domain domain, Host host, Port port, TxtRecord txt)
+{
+	return Detail::makeVoidAwaiter([=, &group](auto const &completion)
+	{
+		return group.async_addService(interface, protocol, flags, name, type, domain, host, port, txt, completion);
+	});
+}
+
+/** Awaitable variant of EntryGroup::async_addServiceSubtype(). */
+inline auto addServiceSubtype(EntryGroup &group, Interface interface, Protocol protocol,
+                              ::AvahiPublishFlags flags, ServiceName name, ServiceType type,
+                              Domain domain, EntryGroup::Subtype subtype)
+{
+	return Detail::makeVoidAwaiter([=, &group](auto const &completion)
+	{
+		return group.async_addServiceSubtype(interface, protocol, flags, name, type, domain, subtype, completion);
+	});
+}
+
+/** Awaitable variant of EntryGroup::async_commit(). */
+inline auto commit(EntryGroup &group)
+{
+	return Detail::makeVoidAwaiter([&group](auto const &completion)
+	{
+		return group.async_commit(completion);
+	});
+}
+
+/** Awaitable variant of EntryGroup::Transaction::async_commit().  Throws the
+ *  first error of the transaction (see EntryGroup::Transaction::SlotCommit). */
+inline auto commit(EntryGroup::Transaction &transaction)
+{
+	return Detail::makeVoidAwaiter([&transaction](auto const &completion)
+	{
+		return transaction.async_commit([completion](Glib::Error const &error, std::vector<Glib::Error> const & /*entryErrors*/)
+		{
+			completion(error);
+		});
+	});
+}
+
+/** Awaitable variant of EntryGroup::async_reset(). */
+inline auto reset(EntryGroup &group)
+{
+	return Detail::makeVoidAwaiter([&group](auto const &completion)
+	{
+		return group.async_reset(completion);
+	});
+}
+
+/** Awaitable variant of EntryGroup::async_updateServiceTxt(). */
+inline auto updateServiceTxt(EntryGroup &group, Interface interface, Protocol protocol,
+                             ::AvahiPublishFlags flags, ServiceName name, ServiceType type,
+                             Domain domain, TxtRecord txt)
+{
+	return Detail::makeVoidAwaiter([=, &group](auto const &completion)
+	{
+		return group.async_updateServiceTxt(interface, protocol, flags, name, type, domain, txt, completion);
+	});
+}
+
+} /* namespace Avahi::Coro */
+
+#endif /* SRC_AVAHI_COROUTINE_HPP_ */
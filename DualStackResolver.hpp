@@ -0,0 +1,136 @@
+/**
+ *  \file
+ *  \brief Parallel IPv4/IPv6 resolving of a single service
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_DUALSTACKRESOLVER_HPP_
+#define SRC_AVAHI_DUALSTACKRESOLVER_HPP_
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include <avahi-common/defs.h>         // ::AvahiLookupFlags, ::AvahiLookupResultFlags
+
+#include "ServiceResolver.hpp"
+#include "TxtRecord.hpp"
+#include "Types.hpp"
+
+namespace Avahi {
+
+class Client;
+
+/** Resolves a single service via an IPv4 (A) and an IPv6 (AAAA) resolver in
+ *  parallel, instead of a single resolver with AVAHI_PROTO_UNSPEC (which
+ *  reports only one, arbitrary address).
+ *
+ *  The first usable address is reported at once (allowing the application
+ *  to start connecting), the other family is still collected.  All known
+ *  addresses are kept in a candidate list, in order of arrival (so the
+ *  family which has answered first comes first).  Both resolvers are kept
+ *  alive, so later changes (e.g. a new address) are reported as well.
+ *
+ *  \note The Client must outlive this object.  This object must not be
+ *        destroyed from within one of its handlers.
+ */
+class DualStackResolver
+{
+public:   // types
+	/** A single address of the service. */
+	struct Candidate
+	{
+		/** Interface on which the address has been resolved. */
+		Interface interface;
+		/** Protocol used for transport of mDNS queries. */
+		Protocol protocol;
+		/** AVAHI_PROTO_INET or AVAHI_PROTO_INET6. */
+		ServiceResolver::AProtocol aprotocol;
+		ServiceResolver::Address address;
+		/** Whether #address is link-local (169.254.0.0/16 or fe80::/10),
+		 *  i.e. only reachable via #interface. */
+		bool linkLocal;
+		/** #address with the interface index appended as scope for IPv6
+		 *  link-local addresses ("fe80::1%3", as accepted by getaddrinfo()),
+		 *  otherwise the same as #address. */
+		std::string scopedAddress;
+		Host host;
+		Port port;
+		::AvahiLookupResultFlags flags;
+	};
+
+public:   // slots
+	/** Type for handler to invoke when an error message shall be printed to
+	 *  the application's log file. */
+	using SlotErrorLog  = sigc::signal<void(char const *error)>;
+	/** Type for handler to invoke when a new address has been resolved (or
+	 *  address/host/port of a known candidate have changed).  \a first is
+	 *  set for the first candidate. */
+	using SlotCandidate = sigc::signal<void(Candidate const &candidate, bool first)>;
+	/** Type for handler to invoke when both families have delivered their
+	 *  first result (or have failed) and there is at least one candidate. */
+	using SlotComplete  = sigc::signal<void()>;
+	/** Type for handler to invoke when resolving has failed for both
+	 *  families (no candidate at all). */
+	using SlotFailure   = sigc::signal<void(Error const &error)>;
+
+	/** Handler to invoke when an error message shall be printed to the
+	 *  application's log file. */
+	SlotErrorLog on_errorLog;
+	/** Handler to invoke when a new address has been resolved. */
+	SlotCandidate on_candidate;
+	/** Handler to invoke when both families have delivered their first
+	 *  result (or one of them has failed). */
+	SlotComplete on_complete;
+	/** Handler to invoke when resolving has failed for both families. */
+	SlotFailure on_failure;
+
+public:   // methods
+	/** Starts resolving at once.  See Client::async_createServiceResolver()
+	 *  for a description of the parameters. */
+	DualStackResolver(Client &client, Interface interface, Protocol protocol,
+	                  ServiceName const &name, ServiceType const &type, Domain const &domain,
+	                  ::AvahiLookupFlags flags = {});
+	~DualStackResolver();
+	DualStackResolver(DualStackResolver const &other) = delete;
+	DualStackResolver(DualStackResolver &&other) = delete;
+	DualStackResolver& operator=(DualStackResolver const &other) = delete;
+	DualStackResolver& operator=(DualStackResolver &&other) = delete;
+
+	/** Current addresses, in order of arrival.  There is one candidate per
+	 *  interface and address family; a new address (e.g. after a DHCP
+	 *  renew) replaces the previous one. */
+	std::vector<Candidate> const &candidates() const { return m_candidates; }
+	/** TXT data of the latest result (of either family). */
+	TxtRecord const &txt() const { return m_txt; }
+	/** Whether both families have delivered their first result (or have
+	 *  failed). */
+	bool complete() const;
+
+private:  // types
+	/** Resolver for a single address family. */
+	struct Lookup;
+
+private:  // methods
+	void onFound(ServiceResolver::FoundView const &found);
+	static Candidate makeCandidate(ServiceResolver::FoundView const &found);
+	void onDone(Lookup &lookup, Error const &error);
+
+private:  // members
+	Client &m_client;
+	/** INET, INET6 */
+	std::array<std::shared_ptr<Lookup>, 2> m_lookups;
+	std::vector<Candidate> m_candidates;
+	TxtRecord m_txt;
+	Error m_firstError;
+	bool m_complete;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_DUALSTACKRESOLVER_HPP_ */
@@ -8,18 +8,26 @@
 #ifndef SRC_AVAHI_ENTRYGROUP_HPP_
 #define SRC_AVAHI_ENTRYGROUP_HPP_
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <giomm/cancellable.h>
+#include <glibmm/refptr.h>
 #include <glibmm/ustring.h>
+#include <glibmm/variant.h>
 #include <sigc++/functors/slot.h>
 #include <sigc++/signal.h>
 
 #include <avahi-common/defs.h>         // ::AvahiPublishFlags, ::AvahiEntryGroupState
 
+#include "Client.hpp"
+#include "TxtRecord.hpp"
 #include "Types.hpp"
-
-extern "C" {
-	/** "Forward declaration" which avoids including the full <glib.h> file. */
-	typedef unsigned int    guint;
-}
+#include "Views.hpp"
 
 namespace Glib {
 	class Error;
@@ -28,12 +36,15 @@ namespace Glib {
 
 namespace Avahi {
 
-class Client;
-
 /** Proxy for an Avahi entry group.  An entry group is required for publishing
  *  services.  An object of this class cannot be created directly.  Use
- *  Client::async_createEntryGroup() instead. */
-class EntryGroup
+ *  Client::async_createEntryGroup() instead.
+ *
+ *  All async_*() methods return a Gio::Cancellable which can be used for
+ *  aborting the operation (see Client).  The timeouts are taken from the
+ *  owning Client.
+ */
+class EntryGroup : public std::enable_shared_from_this<EntryGroup>
 {
 	/* Use passkey idiom as constructor of EntryGroup cannot be made private
 	 * (due to use of std::make_shared()). */
@@ -44,6 +55,159 @@ public:   // types
 	/** Avahi service subtype type (e.g. "_orbiter._sub._http._tcp"). */
 	using Subtype   = Glib::ustring;
 
+	/** Complete definition of a service (see async_publish()).  See
+	 *  async_addService() for a description of the members. */
+	struct ServiceDefinition
+	{
+		Interface interface;
+		Protocol protocol;
+		::AvahiPublishFlags flags;
+		ServiceName name;
+		ServiceType type;
+		Domain domain;
+		Host host;
+		Port port;
+		TxtRecord txt;
+		/** See async_addServiceSubtype(). */
+		std::vector<Subtype> subtypes;
+	};
+
+	/** Builder for publishing several entries with a single completion.
+	 *
+	 *  All collected D-Bus calls (including the final "Commit") are sent at
+	 *  once without waiting for the individual responses.  As D-Bus
+	 *  preserves the message order, Avahi daemon processes them in the order
+	 *  they have been added.  Use EntryGroup::createTransaction() for
+	 *  creating a transaction.
+	 *
+	 *  \code
+	 *  group->createTransaction()
+	 *      .addService(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {}, "myService", "_http._tcp", "", "", 80, {})
+	 *      .addServiceSubtype(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {}, "myService", "_http._tcp", "", "_my._sub._http._tcp")
+	 *      .async_commit([](Glib::Error const &error, std::vector<Glib::Error> const &entryErrors) { ... });
+	 *  \endcode
+	 */
+	class Transaction
+	{
+		friend EntryGroup;
+
+	public:   // slots
+		/** Completion type for async_commit.  \a error is the first error
+		 *  which occurred (either for one of the entries or for "Commit").
+		 *  \a entryErrors contains one (possibly empty) error per added
+		 *  entry, in the order the entries have been added. */
+		using SlotCommit = sigc::slot<void(Glib::Error const &error, std::vector<Glib::Error> const &entryErrors)>;
+
+	public:   // methods
+		/** Adds a service.  See EntryGroup::async_addService() for a
+		 *  description of the parameters. */
+		Transaction &addService(Interface interface, Protocol protocol,
+		                        ::AvahiPublishFlags flags,
+		                        ServiceName const &name, ServiceType const &type,
+		                        Domain const &domain, Host const &host, Port port,
+		                        TxtRecord const &txt);
+
+		/** Adds a service subtype.  See EntryGroup::async_addServiceSubtype()
+		 *  for a description of the parameters. */
+		Transaction &addServiceSubtype(Interface interface, Protocol protocol,
+		                               ::AvahiPublishFlags flags,
+		                               ServiceName const &name, ServiceType const &type,
+		                               Domain const &domain, Subtype const &subtype);
+
+		/** Updates the TXT data of an existing service.  See
+		 *  EntryGroup::async_updateServiceTxt() for a description of the
+		 *  parameters. */
+		Transaction &updateServiceTxt(Interface interface, Protocol protocol,
+		                              ::AvahiPublishFlags flags,
+		                              ServiceName const &name, ServiceType const &type,
+		                              Domain const &domain, TxtRecord const &txt);
+
+		/** Number of collected entries. */
+		std::size_t size() const { return m_entries.size(); }
+
+		/** Sends all collected entries followed by a "Commit" call.
+		 *
+		 *  \param[out] completion  Asynchronous completion handler which
+		 *                          receives the aggregated result after all
+		 *                          responses have been received.  It is
+		 *                          guaranteed that this handler will NOT be
+		 *                          called from within this function.
+		 *
+		 *  \note As "Commit" is pipelined with the entries, the entry group
+		 *        is committed even if adding one of the entries has failed.
+		 *        Call EntryGroup::async_reset() in this case.
+		 */
+		Glib::RefPtr<Gio::Cancellable> async_commit(SlotCommit const &completion);
+
+	private:  // types
+		struct Entry
+		{
+			Client::Operation operation;
+			char const *method;
+			Glib::VariantContainerBase parameters;
+		};
+
+	private:  // methods
+		explicit Transaction(EntryGroup &group);
+
+	private:  // members
+		EntryGroup &m_group;
+		std::vector<Entry> m_entries;
+	};
+
+	/** Repeated TXT updates of a single service (e.g. for telemetry data).
+	 *  Use EntryGroup::prepareTxtUpdate() for creating it.
+	 *
+	 *  The identity of the service (interface, protocol, flags, name, type,
+	 *  domain) is converted to D-Bus parameters only once.  Updates with
+	 *  unchanged TXT data are not sent at all.
+	 *
+	 *  \code
+	 *  auto update = group->prepareTxtUpdate(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {}, "myService", "_http._tcp", "");
+	 *  ...
+	 *  update.async_update(txt, [](Glib::Error const &error) { ... });
+	 *  \endcode
+	 */
+	class PreparedTxtUpdate
+	{
+		friend EntryGroup;
+
+	public:   // slots
+		/** Completion type for async_update. */
+		using SlotUpdate = sigc::slot<void(Glib::Error const &error)>;
+
+	public:   // methods
+		/** Updates the TXT data of the service.  See
+		 *  EntryGroup::async_updateServiceTxt() for a description of the
+		 *  parameters.
+		 *
+		 *  If \a txt is equal to the data of the last update (via this
+		 *  object, which has not failed) and no other TXT data of this
+		 *  entry group has been published or reset since then, no D-Bus call
+		 *  is sent and \a completion is invoked from an idle handler.
+		 */
+		Glib::RefPtr<Gio::Cancellable> async_update(TxtRecord const &txt, SlotUpdate const &completion);
+
+	private:  // types
+		struct State
+		{
+			/** Pre-built parameters "iiusss" of "UpdateServiceTxt". */
+			std::array<Glib::VariantBase, 6> identity;
+			/** TXT data of the last update being sent or succeeded. */
+			std::optional<TxtRecord> lastTxt;
+			/** EntryGroup::m_txtGeneration at the time of the last update. */
+			unsigned int generation = 0;
+		};
+
+	private:  // methods
+		PreparedTxtUpdate(EntryGroup &group, std::shared_ptr<State> const &state);
+
+	private:  // members
+		EntryGroup &m_group;
+		/** Shared with the completion handlers of pending updates. */
+		std::shared_ptr<State> m_state;
+	};
+
 public:   // slots
 	/** Type for handler to invoke when an error message shall be printed to
 	 *  the application's log file. */
@@ -74,6 +238,8 @@ public:   // slots
 	using SlotReset             = sigc::slot<void(Glib::Error const &error)>;
 	/** Completion type for async_updateServiceTxt. */
 	using SlotUpdateServiceTxt  = sigc::slot<void(Glib::Error const &error)>;
+	/** Completion type for async_publish. */
+	using SlotPublish           = sigc::slot<void(Glib::Error const &error)>;
 
 public:   // methods
 	/** Do not call this directly. Use Client::async_createEntryGroup() instead. */
@@ -84,6 +250,10 @@ public:   // methods
 	EntryGroup& operator=(EntryGroup const &other) = delete;
 	EntryGroup& operator=(EntryGroup &&other) = delete;
 
+	/** Creates a builder for publishing several entries with a single
+	 *  completion.  The transaction must not outlive this entry group. */
+	Transaction createTransaction();
+
 	/** Asynchronous method for adding a service to an entry group.
 	 *
 	 *  \param[in]  interface   (OS specific) interface index where the service
@@ -104,7 +274,8 @@ public:   // methods
 	 *                          the local host name will be used.
 	 *  \param[in]  port        The TCP/UDP port number of this service.
 	 *  \param[in]  txt         The TXT data for this service.  An internal copy
-	 *                          of this data will be created.
+	 *                          of this data will be created.  A #Txt is
+	 *                          converted implicitly.
 	 *  \param[out] completion  Asynchronous completion handler which receives
 	 *                          the result of this operation.  It is guaranteed
 	 *                          that this handler will NOT be called from within
@@ -114,11 +285,11 @@ public:   // methods
 	 *  \note Carefully read instructions in %<avahi git%>/avahi-common/defs.h
 	 *        on about when services can be added to an entry group.
 	 */
-	void async_addService(Interface interface, Protocol protocol,
-	                      ::AvahiPublishFlags flags,
-	                      ServiceName const &name, ServiceType const &type,
-	                      Domain const &domain, Host const &host, Port port,
-	                      Txt const &txt, SlotAddService const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_addService(Interface interface, Protocol protocol,
+	                                                ::AvahiPublishFlags flags,
+	                                                ServiceName const &name, ServiceType const &type,
+	                                                Domain const &domain, Host const &host, Port port,
+	                                                TxtRecord const &txt, SlotAddService const &completion);
 
 	/** Asynchronous method for adding a service to an entry group.
 	 *
@@ -145,11 +316,11 @@ public:   // methods
 	 *
 	 *  \sa avahi_entry_group_add_service_subtype()
 	 */
-	void async_addServiceSubtype(Interface interface, Protocol protocol,
-	                             ::AvahiPublishFlags flags,
-	                             ServiceName const &name, ServiceType const &type,
-	                             Domain const &domain, Subtype const &subtype,
-	                             SlotAddServiceSubtype const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_addServiceSubtype(Interface interface, Protocol protocol,
+	                                                       ::AvahiPublishFlags flags,
+	                                                       ServiceName const &name, ServiceType const &type,
+	                                                       Domain const &domain, Subtype const &subtype,
+	                                                       SlotAddServiceSubtype const &completion);
 
 	/** Asynchronous method for committing an EntryGroup. The entries in the
 	 *  entry group are now registered on the network.
@@ -163,7 +334,7 @@ public:   // methods
 	 *  \note After calling async_reset() or async_updateServiceTxt(), no
 	 *        further call to async_commit() is required.
 	 */
-	void async_commit(SlotCommit const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_commit(SlotCommit const &completion);
 
 	/** Asynchronous method for resetting an EntryGroup. All entries will be
 	 *  removed immediately.
@@ -173,7 +344,7 @@ public:   // methods
 	 *                          that this handler will NOT be called from within
 	 *                          this function.
 	 */
-	void async_reset(SlotReset const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_reset(SlotReset const &completion);
 
 	/** Asynchronous method for efficient update of service TXT data for
 	 *  already existing services.
@@ -192,7 +363,8 @@ public:   // methods
 	 *  \param[in]  domain      The domain of this servce.  Use the same value
 	 *                          as in async_addService().
 	 *  \param[in]  txt         The new TXT data for this service.  An internal
-	 *                          copy of this data will be created.
+	 *                          copy of this data will be created.  A #Txt is
+	 *                          converted implicitly.
 	 *  \param[out] completion  Asynchronous completion handler which receives
 	 *                          the result of this operation.  It is guaranteed
 	 *                          that this handler will NOT be called from within
@@ -201,16 +373,81 @@ public:   // methods
 	 *  \note No further call to async_commit() is required.
 	 *  \sa avahi_entry_group_update_service_txt_strlst()
 	 */
-	void async_updateServiceTxt(Interface interface, Protocol protocol,
-	                            ::AvahiPublishFlags flags,
-	                            ServiceName const &name, ServiceType const &type,
-	                            Domain const &domain, Txt const &txt,
-	                            SlotUpdateServiceTxt const &completion);
+	Glib::RefPtr<Gio::Cancellable> async_updateServiceTxt(Interface interface, Protocol protocol,
+	                                                      ::AvahiPublishFlags flags,
+	                                                      ServiceName const &name, ServiceType const &type,
+	                                                      Domain const &domain, TxtRecord const &txt,
+	                                                      SlotUpdateServiceTxt const &completion);
+
+	/** Prepares repeated TXT updates of an already existing service (see
+	 *  async_updateServiceTxt() for a description of the parameters).  The
+	 *  returned object must not outlive this entry group.
+	 */
+	PreparedTxtUpdate prepareTxtUpdate(Interface interface, Protocol protocol,
+	                                   ::AvahiPublishFlags flags,
+	                                   ServiceName const &name, ServiceType const &type,
+	                                   Domain const &domain);
+
+	/** Publishes exactly \a services, sending only what has changed since
+	 *  the last (successful) call of this method:
+	 *  - nothing, if all definitions are unchanged (\a completion is invoked
+	 *    from an idle handler),
+	 *  - "UpdateServiceTxt" for each service whose TXT data has changed, if
+	 *    nothing else has changed (no re-add, no new probing),
+	 *  - only "Reset" (if anything has been published) for an empty
+	 *    \a services list, as Avahi cannot commit an empty entry group,
+	 *  - otherwise "Reset" (if required), all services and subtypes and
+	 *    "Commit", pipelined in one burst (Avahi cannot remove single
+	 *    entries from an entry group).
+	 *
+	 *  The first call, and the first call after using any other method
+	 *  which modifies this entry group, always publishes everything.  After
+	 *  a failure, the next call publishes everything as well.
+	 *
+	 *  \param[in]  services    All services of this entry group.
+	 *  \param[out] completion  Asynchronous completion handler which receives
+	 *                          the first error which occurred.  It is
+	 *                          guaranteed that this handler will NOT be called
+	 *                          from within this function.
+	 */
+	Glib::RefPtr<Gio::Cancellable> async_publish(std::vector<ServiceDefinition> const &services,
+	                                             SlotPublish const &completion);
+
+private:  // methods
+	/** Handler for all D-Bus signals of this object (called by Client). */
+	void onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	/** Handler for the "StateChanged" signal (dispatched by onSignal()). */
+	void onStateChanged(std::int32_t state, StringView error);
+	/** Handler for vanishing/re-appearing of the Avahi daemon (called by
+	 *  Client). */
+	void onSession(bool available);
+	/** Attaches this object to a re-created daemon side entry group and
+	 *  re-publishes all entries. */
+	void rebind(Glib::ustring const &objectPath, Glib::Error const &error);
+	/** Records a sent entry in #m_published. */
+	void remember(Transaction::Entry const &entry);
+	/** Completion handler for async_publish() which forgets the published
+	 *  services on failure. */
+	SlotPublish publishCompletion(SlotPublish const &completion);
 
 private:
 	Client &m_client;
+	/** Empty while detached from the daemon side object. */
 	Glib::ustring m_objectPath;
-	::guint m_stateChanged;
+	/** All entries sent since the last reset (for re-publishing them in
+	 *  persistent session mode). */
+	std::vector<Transaction::Entry> m_published;
+	/** Whether the entry group has been committed since the last reset. */
+	bool m_committed;
+	/** Incremented whenever TXT data is published or reset other than via
+	 *  a PreparedTxtUpdate (invalidates their last TXT data). */
+	unsigned int m_txtGeneration;
+	/** Services published via async_publish(); std::nullopt if unknown
+	 *  (e.g. after any other modification). */
+	std::optional<std::vector<ServiceDefinition>> m_services;
+	/** Incremented for each async_publish() (a failure only invalidates
+	 *  #m_services if no newer call has been made). */
+	unsigned int m_publishSerial;
 };
 
 } /* namespace Avahi */
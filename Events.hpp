@@ -0,0 +1,183 @@
+/**
+ *  \file
+ *  \brief Event structs and lightweight listener lists
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_EVENTS_HPP_
+#define SRC_AVAHI_EVENTS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
+
+#include "Types.hpp"
+#include "Views.hpp"
+
+namespace Avahi {
+
+/** "ItemNew"/"ItemRemove" signal of a ServiceBrowser.  All strings are views
+ *  on the received D-Bus message, so the event is only valid during the
+ *  emission. */
+struct ServiceEvent
+{
+	/** true for "ItemNew", false for "ItemRemove". */
+	bool isNew;
+	Interface interface;
+	Protocol protocol;
+	StringView name;
+	StringView type;
+	StringView domain;
+	::AvahiLookupResultFlags flags;
+};
+
+/** "Found" signal of a ServiceResolver.  All strings and the TXT data are
+ *  views on the received D-Bus message, so the event is only valid during
+ *  the emission. */
+struct ResolvedEvent
+{
+	Interface interface;
+	Protocol protocol;
+	StringView name;
+	StringView type;
+	StringView domain;
+	StringView host;
+	/** AVAHI_PROTO_INET or AVAHI_PROTO_INET6. */
+	std::int32_t aprotocol;
+	StringView address;
+	Port port;
+	TxtView txt;
+	::AvahiLookupResultFlags flags;
+};
+
+/** List of listeners for events of type \a Event.
+ *
+ *  A listener is stored as an object pointer plus a plain function pointer
+ *  (generated at compile time for the registered method), so emitting an
+ *  event does neither allocate nor go through type-erased slots.
+ *  Registering only allocates when the internal vector grows.
+ *
+ *  \code
+ *  struct Monitor { void onService(Avahi::ServiceEvent const &event); };
+ *
+ *  auto id = browser->on_event.add<&Monitor::onService>(monitor);
+ *  ...
+ *  browser->on_event.remove(id);
+ *  \endcode
+ *
+ *  Listeners may be added or removed during an emission (added listeners
+ *  are invoked from the next emission on).
+ *
+ *  \note The registered objects are not copied and must outlive their
+ *        registration.  The object emitting the event must not be destroyed
+ *        from within a listener.
+ */
+template <typename Event>
+class Listeners
+{
+public:   // types
+	/** Identifies a registered listener (see remove()). */
+	using Id = std::uint64_t;
+
+public:   // methods
+	/** Registers \a Method (a member function taking Event const &) of
+	 *  \a object. */
+	template <auto Method, typename Object>
+	Id add(Object &object)
+	{
+		return insert(&object, [](void *object, Event const &event)
+		{
+			(static_cast<Object *>(object)->*Method)(event);
+		});
+	}
+
+	/** Registers a function object (e.g. a lambda) taking Event const &.
+	 *  Only a reference to \a callable is stored. */
+	template <typename Callable>
+	Id add(Callable &callable)
+	{
+		return insert(&callable, [](void *object, Event const &event)
+		{
+			(*static_cast<Callable *>(object))(event);
+		});
+	}
+
+	/** Registers \a Function (a free function taking Event const &). */
+	template <void (*Function)(Event const &)>
+	Id add()
+	{
+		return insert(nullptr, [](void * /*object*/, Event const &event)
+		{
+			Function(event);
+		});
+	}
+
+	/** Removes a listener (ignored for unknown ids). */
+	void remove(Id id)
+	{
+		auto it = std::find_if(m_entries.begin(), m_entries.end(), [id](Entry const &entry)
+		{
+			return entry.id == id;
+		});
+		if (it == m_entries.end())
+			return;
+
+		if (m_dispatching)
+			it->invoke = nullptr;  // removed after dispatching
+		else
+			m_entries.erase(it);
+	}
+
+	/** Whether no listener is registered. */
+	bool empty() const { return m_entries.empty(); }
+
+	/** Invokes all listeners with \a event. */
+	void emit(Event const &event)
+	{
+		std::size_t const count = m_entries.size();
+
+		m_dispatching++;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			if (m_entries[i].invoke)
+				m_entries[i].invoke(m_entries[i].object, event);
+		}
+		if (--m_dispatching)
+			return;
+
+		m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](Entry const &entry)
+		{
+			return entry.invoke == nullptr;
+		}), m_entries.end());
+	}
+
+private:  // types
+	using Invoke = void (*)(void *object, Event const &event);
+
+	struct Entry
+	{
+		Id id;
+		void *object;
+		Invoke invoke;
+	};
+
+private:  // methods
+	Id insert(void *object, Invoke invoke)
+	{
+		m_entries.push_back(Entry{++m_lastId, object, invoke});
+		return m_lastId;
+	}
+
+private:  // members
+	std::vector<Entry> m_entries;
+	Id m_lastId = 0;
+	unsigned int m_dispatching = 0;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_EVENTS_HPP_ */
@@ -0,0 +1,105 @@
+/**
+ *  \file
+ *  \brief Interning of frequently repeated strings
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_INTERN_HPP_
+#define SRC_AVAHI_INTERN_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <functional>                  // std::hash
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Avahi {
+
+class InternTable;
+
+/** Handle of an interned string (see InternTable).
+ *
+ *  Atoms of the same table compare equal if (and only if) their strings are
+ *  equal, so comparing and hashing is a single pointer operation and copying
+ *  never allocates.  The default constructed Atom represents the empty
+ *  string.
+ *
+ *  \note operator<() orders by identity, not lexicographically.
+ */
+class Atom
+{
+	friend InternTable;
+
+public:   // methods
+	Atom() = default;
+
+	/** The interned string (valid as long as the owning table). */
+	std::string const &str() const;
+	char const *c_str() const { return str().c_str(); }
+	std::string_view view() const { return str(); }
+	bool empty() const { return m_string == nullptr; }
+
+	bool operator==(Atom other) const { return m_string == other.m_string; }
+	bool operator!=(Atom other) const { return m_string != other.m_string; }
+	bool operator<(Atom other) const { return std::less<std::string const *>()(m_string, other.m_string); }
+
+	std::size_t hash() const { return std::hash<std::string const *>()(m_string); }
+
+private:  // methods
+	explicit Atom(std::string const *string)
+	: m_string(string)
+	{}
+
+private:  // members
+	std::string const *m_string = nullptr;
+};
+
+/** Append-only table of interned strings.
+ *
+ *  Intended for strings from a small, fixed vocabulary which repeat across
+ *  many events: service types and domains.  Strings are never removed, so
+ *  do not intern unique or churning values like service names, host names
+ *  or object paths.
+ *
+ *  \note Interning is not thread-safe.  Reading the string of an existing
+ *        Atom is safe from any thread while the table is alive.
+ */
+class InternTable
+{
+public:   // methods
+	InternTable() = default;
+	InternTable(InternTable const &other) = delete;
+	InternTable& operator=(InternTable const &other) = delete;
+
+	/** Returns the Atom for \a string, adding it to the table if required. */
+	Atom intern(std::string_view string);
+
+	/** Returns the Atom for \a string, or an empty Atom if \a string has not
+	 *  been interned yet. */
+	Atom find(std::string_view string) const;
+
+	/** Number of interned strings. */
+	std::size_t size() const { return m_strings.size(); }
+
+private:  // members
+	/** Element addresses are stable on push_back(). */
+	std::deque<std::string> m_strings;
+	/** Keys point into #m_strings. */
+	std::unordered_map<std::string_view, std::string const *> m_index;
+};
+
+} /* namespace Avahi */
+
+namespace std {
+
+template <>
+struct hash<Avahi::Atom>
+{
+	std::size_t operator()(Avahi::Atom atom) const { return atom.hash(); }
+};
+
+}  // namespace std
+
+#endif /* SRC_AVAHI_INTERN_HPP_ */
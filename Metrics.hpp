@@ -0,0 +1,123 @@
+/**
+ *  \file
+ *  \brief Counters and latency histograms for Client instrumentation
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_METRICS_HPP_
+#define SRC_AVAHI_METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Avahi {
+
+/** Latency histogram with logarithmic buckets.  Recording is lock-free (only
+ *  relaxed atomic operations), so a histogram can be read from another
+ *  thread while being updated. */
+class Histogram
+{
+public:   // types
+	/** Bucket \c i counts values in [2^i, 2^(i+1)) us; bucket 0 also
+	 *  contains 0 us, the last bucket all larger values. */
+	static constexpr std::size_t Buckets = 32;
+
+	/** Copy of a histogram.  The values are read independently, so while
+	 *  the histogram is being updated, #count, #sum_usec and the bucket
+	 *  totals may differ slightly (approximate copy). */
+	struct Snapshot
+	{
+		std::array<std::uint64_t, Buckets> buckets{};
+		std::uint64_t count = 0;
+		std::uint64_t sum_usec = 0;
+		std::uint64_t max_usec = 0;
+
+		/** Mean value [us] (0 if empty). */
+		double mean() const { return count ? static_cast<double>(sum_usec) / count : 0.0; }
+
+		/** Upper bound [us] of the bucket containing the \a p quantile
+		 *  (0.0 <= p <= 1.0), but not larger than max_usec.  Based on the
+		 *  bucket totals only (not on #count). */
+		std::uint64_t percentile(double p) const;
+	};
+
+public:   // methods
+	Histogram() = default;
+	Histogram(Histogram const &other) = delete;
+	Histogram& operator=(Histogram const &other) = delete;
+
+	/** Adds a single value [us]. */
+	void record(std::uint64_t usec) noexcept;
+
+	/** Returns a copy of the current values. */
+	Snapshot snapshot() const noexcept;
+
+	/** Clears all values. */
+	void reset() noexcept;
+
+private:  // members
+	std::array<std::atomic<std::uint64_t>, Buckets> m_buckets{};
+	std::atomic<std::uint64_t> m_count{0};
+	std::atomic<std::uint64_t> m_sum{0};
+	std::atomic<std::uint64_t> m_max{0};
+};
+
+/** Metrics of a single D-Bus method (see Client::Operation). */
+struct CallMetrics
+{
+	/** Number of issued calls. */
+	std::uint64_t calls = 0;
+	/** Number of calls which completed with an error (including timeouts
+	 *  and cancellation). */
+	std::uint64_t failures = 0;
+	/** Number of calls still waiting for their reply. */
+	std::uint64_t pending = 0;
+	/** Round trip time (daemon + bus) of completed calls. */
+	Histogram::Snapshot latency;
+};
+
+/** Metrics of the queue of a call priority class (see Client::Priority). */
+struct QueueMetrics
+{
+	/** Number of calls currently waiting for a free slot in the call
+	 *  window. */
+	std::uint64_t queued = 0;
+	/** Maximum of #queued (since the last reset). */
+	std::uint64_t maxQueued = 0;
+	/** Number of calls which had to wait. */
+	std::uint64_t deferred = 0;
+	/** Time spent in the queue by calls which had to wait. */
+	Histogram::Snapshot waitTime;
+};
+
+/** Metrics of a single signal type (see Client::Signal). */
+struct SignalMetrics
+{
+	/** Number of received signals. */
+	std::uint64_t received = 0;
+	/** Number of signals for which no live proxy object exists. */
+	std::uint64_t unrouted = 0;
+	/** Number of signals whose parameters could not be parsed. */
+	std::uint64_t parseErrors = 0;
+	/** Time spent for decoding and in the application's signal handlers. */
+	Histogram::Snapshot handlerTime;
+};
+
+/** Metrics of a single live proxy object (entry group, browser, resolver). */
+struct ObjectMetrics
+{
+	std::string objectPath;
+	/** D-Bus interface of the object (empty if no signal has been received
+	 *  yet). */
+	std::string interfaceName;
+	std::uint64_t signals = 0;
+	std::uint64_t parseErrors = 0;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_METRICS_HPP_ */
@@ -0,0 +1,165 @@
+/**
+ *  \file
+ *  \brief Aggregated browsing of many service types
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_MULTISERVICEBROWSER_HPP_
+#define SRC_AVAHI_MULTISERVICEBROWSER_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include <avahi-common/defs.h>         // ::AvahiLookupFlags, ::AvahiLookupResultFlags
+
+#include "ServiceBrowser.hpp"
+#include "Types.hpp"
+#include "Views.hpp"
+
+namespace Avahi {
+
+class Client;
+
+/** Browses several service types (on the same interface, protocol and
+ *  domain) via a single object.
+ *
+ *  The ServiceBrowsers for all types added by addTypes() are requested at
+ *  once (the "*Prepare" calls are pipelined).  All items are reported via a
+ *  single event stream and kept in a single index, tagged with a small
+ *  integer TypeId (assigned in order of addType()/addTypes()).
+ *
+ *  With discover(), the types are taken from a browser for the empty type
+ *  (see Client::async_createServiceBrowser()); a ServiceBrowser is added
+ *  for every newly reported type.
+ *
+ *  \note The Client must outlive this object.  This object must not be
+ *        destroyed from within one of its handlers.
+ */
+class MultiServiceBrowser
+{
+public:   // types
+	/** Index of a service type in this browser. */
+	using TypeId = std::uint16_t;
+
+	/** Persistent copy of a known service. */
+	struct Item
+	{
+		TypeId typeId;
+		Interface interface;
+		Protocol protocol;
+		ServiceName name;
+		::AvahiLookupResultFlags flags;
+	};
+
+public:   // slots
+	/** Type for handler to invoke when an error message shall be printed to
+	 *  the application's log file. */
+	using SlotErrorLog  = sigc::signal<void(char const *error)>;
+	/** Type for handler to invoke when a service has been found (\a isNew)
+	 *  or has disappeared.  \a item is only valid during the emission. */
+	using SlotItem      = sigc::signal<void(bool isNew, TypeId typeId, ServiceBrowser::ItemView const &item)>;
+	/** Type for handler to invoke when a service type has been added. */
+	using SlotTypeAdded = sigc::signal<void(TypeId typeId, ServiceType const &type)>;
+	/** Type for handler to invoke when all browsers have reported
+	 *  "AllForNow". */
+	using SlotAllForNow = sigc::signal<void()>;
+	/** Type for handler to invoke when the browser for a type could not be
+	 *  created or has failed (\a typeId is the maximum value for the
+	 *  discovery browser).  A failed browser counts as "AllForNow". */
+	using SlotFailure   = sigc::signal<void(TypeId typeId, Error const &error)>;
+
+	/** Handler to invoke when an error message shall be printed to the
+	 *  application's log file. */
+	SlotErrorLog on_errorLog;
+	/** Handler to invoke when a service has been found or has disappeared
+	 *  (the index is updated before a new item and after a removed item is
+	 *  reported). */
+	SlotItem on_item;
+	/** Handler to invoke when a service type has been added (also for
+	 *  types reported by discover()). */
+	SlotTypeAdded on_typeAdded;
+	/** Handler to invoke when the browsers of all types (and the discovery
+	 *  browser) have reported "AllForNow".  Invoked again if this happens
+	 *  again after new types have been added. */
+	SlotAllForNow on_allForNow;
+	/** Handler to invoke when the browser for a type has failed. */
+	SlotFailure on_failure;
+
+public:   // methods
+	/** \param[in]  client      Client used for creating the browsers.
+	 *  \param[in]  interface   See Client::async_createServiceBrowser().
+	 *  \param[in]  protocol    See Client::async_createServiceBrowser().
+	 *  \param[in]  domain      See Client::async_createServiceBrowser().
+	 *  \param[in]  flags       See Client::async_createServiceBrowser().
+	 */
+	MultiServiceBrowser(Client &client, Interface interface, Protocol protocol,
+	                    Domain const &domain, ::AvahiLookupFlags flags = {});
+	~MultiServiceBrowser();
+	MultiServiceBrowser(MultiServiceBrowser const &other) = delete;
+	MultiServiceBrowser(MultiServiceBrowser &&other) = delete;
+	MultiServiceBrowser& operator=(MultiServiceBrowser const &other) = delete;
+	MultiServiceBrowser& operator=(MultiServiceBrowser &&other) = delete;
+
+	/** Adds a service type (if not already known) and returns its id. */
+	TypeId addType(ServiceType const &type);
+	/** Adds several service types at once. */
+	void addTypes(std::vector<ServiceType> const &types);
+	/** Starts discovering the service types via the empty type. */
+	void discover();
+
+	/** Returns the service type of \a typeId. */
+	ServiceType const &getType(TypeId typeId) const;
+	/** Returns the id of \a type, std::nullopt if unknown. */
+	std::optional<TypeId> findType(StringView type) const;
+	/** Number of known service types. */
+	std::size_t typeCount() const;
+
+	/** Returns all known services.  The pointers are valid until the
+	 *  according on_item emission (with isNew == false). */
+	std::vector<Item const *> items() const;
+	/** Returns all known services of \a typeId. */
+	std::vector<Item const *> items(TypeId typeId) const;
+
+	/** Whether on_allForNow condition is currently met. */
+	bool allForNow() const;
+
+private:  // types
+	/** Browser for a single type (or the discovery browser). */
+	struct Browse;
+	using ItemKey = std::tuple<TypeId, Interface, Protocol, std::string>;
+
+private:  // methods
+	void create(std::shared_ptr<Browse> const &browse);
+	void onItem(Browse &browse, bool isNew, ServiceBrowser::ItemView const &item);
+	void onAllForNow(Browse &browse);
+	void checkAllForNow();
+
+private:  // members
+	Client &m_client;
+	Interface m_interface;
+	Protocol m_protocol;
+	Domain m_domain;
+	::AvahiLookupFlags m_flags;
+
+	/** Indexed by TypeId. */
+	std::vector<std::shared_ptr<Browse>> m_types;
+	std::unordered_map<std::string, TypeId> m_typeIds;
+	std::shared_ptr<Browse> m_discovery;
+
+	std::map<ItemKey, Item> m_items;
+	bool m_allForNow;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_MULTISERVICEBROWSER_HPP_ */
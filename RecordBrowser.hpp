@@ -8,31 +8,69 @@
 #ifndef SRC_AVAHI_RECORDBROWSER_HPP_
 #define SRC_AVAHI_RECORDBROWSER_HPP_
 
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
 #include <glibmm/ustring.h>
+#include <glibmm/variant.h>
 #include <sigc++/signal.h>
 
 #include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
 
+#include "BrowseFilter.hpp"
+#include "RecordDecoder.hpp"
 #include "Types.hpp"
+#include "Views.hpp"
 
-extern "C" {
-	/** "Forward declaration" which avoids including the full <glib.h> file. */
-	typedef unsigned int    guint;
-}
+namespace Glib {
+	class Error;
+}  // namespace Glib
 
 namespace Avahi {
 
 class Client;
+class SharedBrowser;
+template <typename Item> class ItemBatch;
 
 /** Proxy for an Avahi record browser.  A record browser is used for enumerating
  *  arbitrary mDNS records from Avahi's internal database. */
-class RecordBrowser
+class RecordBrowser : public std::enable_shared_from_this<RecordBrowser>
 {
 	/* Use passkey idiom as constructor of RecordBrowser cannot be made private
 	 * (due to use of std::make_shared()). */
 	friend Client;
 	class Token {};
 
+public:   // types
+	/** Non-owning view on the parameters of an "ItemNew"/"ItemRemove"
+	 *  signal.  Only valid during emission of on_itemNewView/on_itemRemoveView.
+	 */
+	struct ItemView
+	{
+		Interface interface;
+		Protocol protocol;
+		StringView name;
+		RecordClass clazz;
+		RecordType type;
+		ByteView rdata;
+		::AvahiLookupResultFlags flags;
+	};
+
+	/** Persistent copy of the parameters of an "ItemNew"/"ItemRemove"
+	 *  signal (used for on_itemsChanged). */
+	struct Item
+	{
+		Interface interface;
+		Protocol protocol;
+		RecordName name;
+		RecordClass clazz;
+		RecordType type;
+		RecordData rdata;
+		::AvahiLookupResultFlags flags;
+	};
+
 public:   // slots
 	/** Type for handler to invoke when an error message shall be printed to
 	 *  the application's log file. */
@@ -41,6 +79,16 @@ public:   // slots
 	using SlotItemNew        = sigc::signal<void(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType const &type, RecordData const &rdata, ::AvahiLookupResultFlags flags)>;
 	/** Type for handler to invoke when an existing record has disappeared. */
 	using SlotItemRemove     = sigc::signal<void(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType const &type, RecordData const &rdata, ::AvahiLookupResultFlags flags)>;
+	/** Type for allocation free variant of SlotItemNew/SlotItemRemove. */
+	using SlotItemView       = sigc::signal<void(ItemView const &item)>;
+	/** Types for handlers to invoke with the decoded rdata of a new
+	 *  (\a isNew) or disappeared record. */
+	using SlotAddressView    = sigc::signal<void(bool isNew, ItemView const &item, AddressView const &address)>;
+	using SlotNameView       = sigc::signal<void(bool isNew, ItemView const &item, NameView const &name)>;
+	using SlotSrvView        = sigc::signal<void(bool isNew, ItemView const &item, SrvView const &srv)>;
+	using SlotTxtView        = sigc::signal<void(bool isNew, ItemView const &item, TxtDataView const &txt)>;
+	/** Type for handler to invoke with a batch of added/removed records. */
+	using SlotItemsChanged   = sigc::signal<void(std::vector<Item> const &added, std::vector<Item> const &removed)>;
 	/** Type for handler to invoke when browsing has failed due to some reason. */
 	using SlotFailure        = sigc::signal<void(Error const &error)>;
 	/** Type for handler to invoke (one time) to notify the user that more
@@ -61,6 +109,26 @@ public:   // slots
 	SlotItemNew on_itemNew;
 	/** Handler to invoke when an existing record has disappeared. */
 	SlotItemRemove on_itemRemove;
+	/** Same as on_itemNew, but without copying the parameters.  If only
+	 *  this signal is connected, no strings/vectors are allocated at all. */
+	SlotItemView on_itemNewView;
+	/** Same as on_itemRemove, but without copying the parameters. */
+	SlotItemView on_itemRemoveView;
+	/** Invoked for A/AAAA records (after on_itemNewView/on_itemRemoveView).
+	 *  The rdata is only decoded if at least one typed signal is connected;
+	 *  malformed rdata is reported via on_errorLog. */
+	SlotAddressView on_addressView;
+	/** Invoked for PTR, CNAME and NS records. */
+	SlotNameView on_nameView;
+	/** Invoked for SRV records. */
+	SlotSrvView on_srvView;
+	/** Invoked for TXT records. */
+	SlotTxtView on_txtView;
+	/** Handler to invoke with all records added/removed since the last
+	 *  batch (only if coalescing has been enabled via setCoalescing()).
+	 *  \a removed must be applied before \a added: a record which has been
+	 *  removed and re-added within the same batch is contained in both. */
+	SlotItemsChanged on_itemsChanged;
 	/** Handler to invoke when browsing has failed due to some reason. */
 	SlotFailure on_failure;
 	/** Handler to invoke (one time) to notify the user that more records will
@@ -73,17 +141,48 @@ public:   // slots
 
 public:   // methods
 	/** Do not call this directly. Use Client::async_createRecordBrowser() instead. */
-	RecordBrowser(Token, Client &client, Glib::ustring const &objectPath);
+	RecordBrowser(Token, Client &client, std::shared_ptr<SharedBrowser> const &shared, BrowseFilter const &filter);
 	~RecordBrowser();
 	RecordBrowser(RecordBrowser const &other) = delete;
 	RecordBrowser(RecordBrowser &&other) = delete;
 	RecordBrowser& operator=(RecordBrowser const &other) = delete;
 	RecordBrowser& operator=(RecordBrowser &&other) = delete;
 
+	/** Enables/disables coalesced delivery via #on_itemsChanged (disabled by
+	 *  default).  See ServiceBrowser::setCoalescing(). */
+	void setCoalescing(bool enable);
+
+private:  // methods
+	/** Handler for all D-Bus signals of the daemon side object (called by
+	 *  SharedBrowser). */
+	void onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	/** Handlers for the single D-Bus signals (dispatched by onSignal()). */
+	void onItemNew(Interface interface, Protocol protocol, StringView name, RecordClass clazz,
+	               RecordType type, ByteView rdata, std::uint32_t flags);
+	void onItemRemove(Interface interface, Protocol protocol, StringView name, RecordClass clazz,
+	                  RecordType type, ByteView rdata, std::uint32_t flags);
+	void onFailure(StringView error);
+	void onAllForNow();
+	void onCacheExhausted();
+	/** Filters and emits an "ItemNew"/"ItemRemove" event. */
+	void onItem(bool isNew, ItemView const &item);
+	/** Emits the typed signal matching the type of \a item (if connected). */
+	void emitDecoded(bool isNew, ItemView const &item);
+	/** Adds an item event to the current batch. */
+	void coalesce(bool isNew, ItemView const &item);
+	/** Emits on_itemsChanged for the current batch. */
+	void flushItems();
+
 private:  // members
 	Client &m_client;
-	Glib::ustring m_objectPath;
-	::guint m_itemNew, m_itemRemove, m_failure, m_allForNow, m_cacheExhausted;
+	/** Daemon side object (shared with all handles with identical
+	 *  parameters). */
+	std::shared_ptr<SharedBrowser> m_shared;
+	/** Applied to "ItemNew"/"ItemRemove" before decoding. */
+	BrowseFilter m_filter;
+	bool m_coalescing;
+	/** Created when coalescing is enabled for the first time. */
+	std::unique_ptr<ItemBatch<Item>> m_batch;
 };
 
 } /* namespace Avahi */
@@ -0,0 +1,202 @@
+/**
+ *  \file
+ *  \brief Allocation free decoders for DNS record data
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Avahi delivers the rdata of browsed records in uncompressed DNS wire
+ *  format.  The decoders in this file validate this data and return typed
+ *  views pointing into it, so (like the views in Views.hpp) they are only
+ *  valid as long as the decoded ByteView.  No avahi-core is required.
+ */
+
+#ifndef SRC_AVAHI_RECORDDECODER_HPP_
+#define SRC_AVAHI_RECORDDECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <avahi-common/address.h>      // ::AvahiAddress
+
+#include "Types.hpp"
+#include "Views.hpp"
+
+namespace Avahi {
+
+struct SrvView;
+class TxtRecord;
+
+/** Decoded data of an A or AAAA record. */
+struct AddressView
+{
+	/** AVAHI_PROTO_INET (A) or AVAHI_PROTO_INET6 (AAAA). */
+	Protocol aprotocol;
+	/** 4 or 16 bytes in network byte order. */
+	ByteView bytes;
+
+	::AvahiAddress toAvahiAddress() const;
+	/** Writes the textual representation (e.g. "192.168.0.1") to \a buffer
+	 *  (should be AVAHI_ADDRESS_STR_MAX bytes) and returns \a buffer. */
+	char const *format(char *buffer, std::size_t size) const;
+	/** Creates a persistent copy of the textual representation. */
+	std::string toString() const;
+};
+
+/** Non-owning view on a domain name in DNS wire format (e.g. the data of a
+ *  PTR record).  Iterating yields the (unescaped) labels. */
+class NameView
+{
+	friend std::optional<NameView> decodeName(ByteView rdata);
+	friend std::optional<SrvView> decodeSrv(ByteView rdata);
+
+public:   // types
+	/** Forward iterator over the labels. */
+	class const_iterator
+	{
+	public:   // types
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = StringView;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = void;
+		using reference         = StringView;
+
+	public:   // methods
+		explicit const_iterator(std::uint8_t const *label)
+		: m_label(label)
+		{}
+
+		StringView operator*() const { return StringView(reinterpret_cast<char const *>(m_label + 1), *m_label); }
+		const_iterator &operator++() { m_label += *m_label + 1; return *this; }
+		const_iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+		bool operator==(const_iterator const &other) const { return m_label == other.m_label; }
+		bool operator!=(const_iterator const &other) const { return m_label != other.m_label; }
+
+	private:  // members
+		std::uint8_t const *m_label;
+	};
+
+public:   // methods
+	/** Root name (no labels). */
+	NameView() = default;
+
+	/** Size in wire format (including the terminating root label). */
+	std::size_t size() const { return m_wire.size(); }
+	/** Whether this is the root name. */
+	bool empty() const { return m_wire.size() <= 1; }
+	const_iterator begin() const { return const_iterator(m_wire.data()); }
+	const_iterator end() const { return const_iterator(m_wire.empty() ? m_wire.end() : m_wire.end() - 1); }
+
+	/** Compares against a name in Avahi's textual representation.  Escape
+	 *  sequences ("\." and "\DDD") are resolved, ASCII letters are compared
+	 *  case-insensitively and a trailing dot is optional. */
+	bool equals(std::string_view name) const;
+	/** Writes the textual representation (escaped like Avahi does) to
+	 *  \a buffer, truncating it if necessary.  For \a size > 0 the result is
+	 *  always NUL terminated.
+	 *  \return Length of the full representation (excluding the NUL), so
+	 *          the result has been truncated if it is >= \a size. */
+	std::size_t format(char *buffer, std::size_t size) const;
+	/** Creates a persistent copy of the textual representation. */
+	std::string toString() const;
+
+private:  // methods
+	explicit NameView(ByteView wire)
+	: m_wire(wire)
+	{}
+
+	/** Validates the name at the start of \a data and returns its wire
+	 *  size (or 0 if malformed).  Compression pointers are rejected. */
+	static std::size_t parse(ByteView data);
+
+private:  // members
+	ByteView m_wire;
+};
+
+/** Decoded data of an SRV record. */
+struct SrvView
+{
+	std::uint16_t priority;
+	std::uint16_t weight;
+	Port port;
+	NameView target;
+};
+
+/** Non-owning view on the data of a TXT record (length prefixed strings).
+ *  Iterating yields the TXT strings (usually "key=value"); empty strings
+ *  are skipped (like Avahi does). */
+class TxtDataView
+{
+	friend std::optional<TxtDataView> decodeTxt(ByteView rdata);
+
+public:   // types
+	/** Forward iterator over the TXT strings. */
+	class const_iterator
+	{
+	public:   // types
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = ByteView;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = void;
+		using reference         = ByteView;
+
+	public:   // methods
+		const_iterator(std::uint8_t const *string, std::uint8_t const *end)
+		: m_string(string)
+		, m_end(end)
+		{ skipEmpty(); }
+
+		ByteView operator*() const { return ByteView(m_string + 1, *m_string); }
+		const_iterator &operator++() { m_string += *m_string + 1; skipEmpty(); return *this; }
+		const_iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+		bool operator==(const_iterator const &other) const { return m_string == other.m_string; }
+		bool operator!=(const_iterator const &other) const { return m_string != other.m_string; }
+
+	private:  // methods
+		void skipEmpty() { while (m_string != m_end && *m_string == 0) ++m_string; }
+
+	private:  // members
+		std::uint8_t const *m_string;
+		std::uint8_t const *m_end;
+	};
+
+public:   // methods
+	TxtDataView() = default;
+
+	const_iterator begin() const { return const_iterator(m_data.begin(), m_data.end()); }
+	const_iterator end() const { return const_iterator(m_data.end(), m_data.end()); }
+	bool empty() const { return begin() == end(); }
+
+	/** Creates a persistent copy of the viewed TXT data. */
+	Txt toTxt() const;
+	/** Same as toTxt(), but with indexed key lookup. */
+	TxtRecord toTxtRecord() const;
+
+private:  // methods
+	explicit TxtDataView(ByteView data)
+	: m_data(data)
+	{}
+
+private:  // members
+	ByteView m_data;
+};
+
+/** Decodes the data of an A record (\a type AVAHI_DNS_TYPE_A) or an AAAA
+ *  record (AVAHI_DNS_TYPE_AAAA).  Returns std::nullopt for other types or
+ *  if \a rdata has the wrong size. */
+std::optional<AddressView> decodeAddress(RecordType type, ByteView rdata);
+/** Decodes the data of a PTR, CNAME or NS record.  Returns std::nullopt if
+ *  \a rdata is not exactly one valid domain name. */
+std::optional<NameView> decodeName(ByteView rdata);
+/** Decodes the data of an SRV record.  Returns std::nullopt if malformed. */
+std::optional<SrvView> decodeSrv(ByteView rdata);
+/** Decodes the data of a TXT record.  Returns std::nullopt if a string
+ *  exceeds \a rdata. */
+std::optional<TxtDataView> decodeTxt(ByteView rdata);
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_RECORDDECODER_HPP_ */
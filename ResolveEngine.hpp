@@ -0,0 +1,210 @@
+/**
+ *  \file
+ *  \brief Bulk resolving of browsed services with bounded concurrency
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_RESOLVEENGINE_HPP_
+#define SRC_AVAHI_RESOLVEENGINE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <glibmm/main.h>
+#include <glibmm/refptr.h>
+#include <glibmm/ustring.h>
+#include <sigc++/connection.h>
+#include <sigc++/signal.h>
+#include <sigc++/trackable.h>
+
+#include <avahi-common/address.h>      // AVAHI_PROTO_UNSPEC
+#include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
+
+#include "Intern.hpp"
+#include "ServiceBrowser.hpp"
+#include "ServiceResolver.hpp"
+#include "TxtRecord.hpp"
+#include "Types.hpp"
+
+namespace Avahi {
+
+class Client;
+
+/** Resolves services reported by one or more ServiceBrowser objects (or
+ *  added manually) while limiting the number of resolvers which are
+ *  concurrently waiting for their first result.
+ *
+ *  Services are identified by (name, type, domain).  If a service is
+ *  reported on several interfaces/protocols, it is resolved only once.
+ *  Pending services are resolved in order of descending priority (and in
+ *  order of arrival for equal priority).  Results are collected and
+ *  delivered in batches via #on_results.
+ *
+ *  \note The engine must be destroyed before the Client.
+ */
+class ResolveEngine : public sigc::trackable
+{
+public:   // types
+	/** What happens to a resolver after it has delivered its first result. */
+	enum class Mode
+	{
+		/** The resolver is freed.  A service is resolved again only after it
+		 *  has disappeared and re-appeared. */
+		OneShot,
+		/** The resolver is kept alive for receiving later updates (e.g. TXT
+		 *  changes) until the service disappears.  Only the first result of
+		 *  each resolver counts against the in-flight limit. */
+		KeepAlive,
+	};
+
+	/** Result of resolving a single service.  If #error is not empty,
+	 *  resolving has failed and only the identifying fields are valid.
+	 *  Type and domain are interned via Client::intern(); host names are
+	 *  not, as they churn (DHCP, renamed hosts) and the table is never
+	 *  pruned. */
+	struct Result
+	{
+		Interface interface;
+		Protocol protocol;
+		ServiceName name;
+		Atom type;
+		Atom domain;
+		Host host;
+		ServiceResolver::AProtocol aprotocol;
+		ServiceResolver::Address address;
+		Port port;
+		TxtRecord txt;
+		::AvahiLookupResultFlags flags;
+		Error error;
+	};
+
+public:   // slots
+	/** Type for handler to invoke when a batch of results is available. */
+	using SlotResults  = sigc::signal<void(std::vector<Result> const &results)>;
+	/** Type for handler to invoke when an error message shall be printed to
+	 *  the application's log file. */
+	using SlotErrorLog = sigc::signal<void(char const *error)>;
+
+	/** Handler to invoke when a batch of results is available. */
+	SlotResults on_results;
+	/** Handler to invoke when an error message shall be printed to the
+	 *  application's log file. */
+	SlotErrorLog on_errorLog;
+
+public:   // methods
+	/** \param[in]  client       Client used for creating the resolvers.
+	 *  \param[in]  mode         See Mode.
+	 *  \param[in]  maxInFlight  Maximum number of resolvers waiting for their
+	 *                           first result (at least 1).
+	 *  \param[in]  aprotocol    Address protocol used for resolving (see
+	 *                           Client::async_createServiceResolver()).
+	 */
+	explicit ResolveEngine(Client &client, Mode mode = Mode::OneShot,
+	                       std::size_t maxInFlight = 16, Protocol aprotocol = AVAHI_PROTO_UNSPEC);
+	~ResolveEngine();
+	ResolveEngine(ResolveEngine const &other) = delete;
+	ResolveEngine(ResolveEngine &&other) = delete;
+	ResolveEngine& operator=(ResolveEngine const &other) = delete;
+	ResolveEngine& operator=(ResolveEngine &&other) = delete;
+
+	/** Changes the in-flight limit.  Raising the limit starts further
+	 *  pending services at once. */
+	void setMaxInFlight(std::size_t maxInFlight);
+
+	/** Sets the time [ms] for collecting results before #on_results is
+	 *  invoked.  With 0 (default), results are delivered when the main loop
+	 *  becomes idle. */
+	void setBatchDelay(unsigned int delay_msec);
+
+	/** Feeds the on_itemNewView/on_itemRemoveView signals of \a browser into
+	 *  this engine.  The connections are released automatically when either
+	 *  object is destroyed.
+	 *
+	 *  \param[in]  browser   Browser to attach.
+	 *  \param[in]  priority  Priority for all services of this browser
+	 *                        (higher values are resolved first).
+	 */
+	void attach(ServiceBrowser &browser, int priority = 0);
+
+	/** Adds a service instance.  If the service (name, type, domain) is
+	 *  already known (e.g. on another interface), only the instance is
+	 *  recorded.  A higher \a priority of a still pending service moves it
+	 *  forward in the queue. */
+	void add(Interface interface, Protocol protocol, ServiceName const &name,
+	         ServiceType const &type, Domain const &domain, int priority = 0);
+
+	/** Removes a service instance.  When the last instance of a service has
+	 *  been removed, the service is dropped from the queue or its resolver
+	 *  is freed.  When the instance which is being resolved (or kept alive)
+	 *  is removed, the service is queued again for the next instance. */
+	void remove(Interface interface, Protocol protocol, ServiceName const &name,
+	            ServiceType const &type, Domain const &domain);
+
+	/** Number of services waiting for a free in-flight slot. */
+	std::size_t pending() const { return m_queue.size(); }
+
+	/** Number of resolvers waiting for their first result. */
+	std::size_t inFlight() const { return m_inFlight; }
+
+	/** Delivers all collected results immediately. */
+	void flush();
+
+private:  // types
+	/** (name, type, domain); std::less<> allows lookup with a string_view
+	 *  as name. */
+	using ServiceKey = std::tuple<std::string, Atom, Atom>;
+	/** Queue order: descending priority, then ascending arrival. */
+	using QueueKey   = std::pair<int, std::uint64_t>;
+	struct Service;
+	using ServiceMap = std::map<ServiceKey, std::shared_ptr<Service>, std::less<>>;
+
+private:  // methods
+	void onItemNew(ServiceBrowser::ItemView const &item, int priority);
+	void onItemRemove(ServiceBrowser::ItemView const &item);
+	void addService(Interface interface, Protocol protocol, std::string_view name,
+	                Atom type, Atom domain, int priority);
+	void removeService(Interface interface, Protocol protocol, std::string_view name,
+	                   Atom type, Atom domain);
+	void enqueue(Service &service);
+	void drop(ServiceMap::iterator it);
+	/** Frees the resolver of \a service and queues it again (for the next
+	 *  instance). */
+	void restart(Service &service);
+	void startPending();
+	void start(std::shared_ptr<Service> const &service);
+	void finishFirst(Service &service);
+	void deliver(Result &&result);
+	void scheduleFlush();
+	bool onFlush();
+
+private:  // members
+	Client &m_client;
+	Mode m_mode;
+	std::size_t m_maxInFlight;
+	Protocol m_aprotocol;
+	unsigned int m_batchDelay;
+	Glib::RefPtr<Glib::MainContext> m_context;
+
+	ServiceMap m_services;
+	std::map<QueueKey, std::weak_ptr<Service>> m_queue;
+	std::uint64_t m_sequence;
+	std::size_t m_inFlight;
+
+	std::vector<Result> m_results;
+	/** Resolvers which are released on next flush (they cannot be destroyed
+	 *  from within their own signal handlers). */
+	std::vector<std::shared_ptr<ServiceResolver>> m_retired;
+	sigc::connection m_flush;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_RESOLVEENGINE_HPP_ */
@@ -8,31 +8,69 @@
 #ifndef SRC_AVAHI_SERVICEBROWSER_HPP_
 #define SRC_AVAHI_SERVICEBROWSER_HPP_
 
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
 #include <glibmm/ustring.h>
+#include <glibmm/variant.h>
 #include <sigc++/signal.h>
 
 #include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
 
+#include "BrowseFilter.hpp"
+#include "Events.hpp"
+#include "Intern.hpp"
 #include "Types.hpp"
+#include "Views.hpp"
 
-extern "C" {
-	/** "Forward declaration" which avoids including the full <glib.h> file. */
-	typedef unsigned int    guint;
-}
+namespace Glib {
+	class Error;
+}  // namespace Glib
 
 namespace Avahi {
 
 class Client;
+class SharedBrowser;
+template <typename Item> class ItemBatch;
 
 /** Proxy for an Avahi service browser.  A service browser is used for finding
  *  Avahi services on the network. */
-class ServiceBrowser
+class ServiceBrowser : public std::enable_shared_from_this<ServiceBrowser>
 {
 	/* Use passkey idiom as constructor of ServiceBrowser cannot be made private
 	 * (due to use of std::make_shared()). */
 	friend Client;
 	class Token {};
 
+public:   // types
+	/** Non-owning view on the parameters of an "ItemNew"/"ItemRemove"
+	 *  signal.  Only valid during emission of on_itemNewView/on_itemRemoveView.
+	 */
+	struct ItemView
+	{
+		Interface interface;
+		Protocol protocol;
+		StringView name;
+		StringView type;
+		StringView domain;
+		::AvahiLookupResultFlags flags;
+	};
+
+	/** Persistent copy of the parameters of an "ItemNew"/"ItemRemove"
+	 *  signal (used for on_itemsChanged).  Type and domain are interned via
+	 *  Client::intern(). */
+	struct Item
+	{
+		Interface interface;
+		Protocol protocol;
+		ServiceName name;
+		Atom type;
+		Atom domain;
+		::AvahiLookupResultFlags flags;
+	};
+
 public:   // slots
 	/** Type for handler to invoke when an error message shall be printed to
 	 *  the application's log file. */
@@ -41,6 +79,10 @@ public:   // slots
 	using SlotItemNew        = sigc::signal<void(Interface interface, Protocol protocol, ServiceName const &name, ServiceType const &type, Domain const &domain, ::AvahiLookupResultFlags flags)>;
 	/** Type for handler to invoke when an existing service has disappeared. */
 	using SlotItemRemove     = sigc::signal<void(Interface interface, Protocol protocol, ServiceName const &name, ServiceType const &type, Domain const &domain, ::AvahiLookupResultFlags flags)>;
+	/** Type for allocation free variant of SlotItemNew/SlotItemRemove. */
+	using SlotItemView       = sigc::signal<void(ItemView const &item)>;
+	/** Type for handler to invoke with a batch of added/removed services. */
+	using SlotItemsChanged   = sigc::signal<void(std::vector<Item> const &added, std::vector<Item> const &removed)>;
 	/** Type for handler to invoke when browsing has failed due to some reason. */
 	using SlotFailure        = sigc::signal<void(Error const &error)>;
 	/** Type for handler to invoke (one time) to notify the user that more
@@ -61,6 +103,21 @@ public:   // slots
 	SlotItemNew on_itemNew;
 	/** Handler to invoke when an existing service has disappeared. */
 	SlotItemRemove on_itemRemove;
+	/** Same as on_itemNew, but without copying the parameters.  If only
+	 *  this signal is connected, no strings are allocated at all. */
+	SlotItemView on_itemNewView;
+	/** Same as on_itemRemove, but without copying the parameters. */
+	SlotItemView on_itemRemoveView;
+	/** Same as on_itemNewView/on_itemRemoveView (distinguished by
+	 *  ServiceEvent::isNew), but delivered via plain function pointers
+	 *  instead of sigc slots (see Listeners).  Invoked before all other
+	 *  item handlers. */
+	Listeners<ServiceEvent> on_event;
+	/** Handler to invoke with all services added/removed since the last
+	 *  batch (only if coalescing has been enabled via setCoalescing()).
+	 *  \a removed must be applied before \a added: a service which has been
+	 *  removed and re-added within the same batch is contained in both. */
+	SlotItemsChanged on_itemsChanged;
 	/** Handler to invoke when browsing has failed due to some reason. */
 	SlotFailure on_failure;
 	/** Handler to invoke (one time) to notify the user that more records will
@@ -73,17 +130,52 @@ public:   // slots
 
 public:   // methods
 	/** Do not call this directly. Use Client::async_createServiceBrowser() instead. */
-	ServiceBrowser(Token, Client &client, Glib::ustring const &objectPath);
+	ServiceBrowser(Token, Client &client, std::shared_ptr<SharedBrowser> const &shared, BrowseFilter const &filter);
 	~ServiceBrowser();
 	ServiceBrowser(ServiceBrowser const &other) = delete;
 	ServiceBrowser(ServiceBrowser &&other) = delete;
 	ServiceBrowser& operator=(ServiceBrowser const &other) = delete;
 	ServiceBrowser& operator=(ServiceBrowser &&other) = delete;
 
+	/** Enables/disables coalesced delivery via #on_itemsChanged (disabled by
+	 *  default).  Item events are buffered until the next main loop
+	 *  iteration (at default priority, so a sustained storm of D-Bus signals
+	 *  is still delivered in batches), until 256 events have been buffered
+	 *  or until "AllForNow" is received (before #on_allForNow is invoked).
+	 *  An "ItemNew" followed by an "ItemRemove" for the same service within
+	 *  a batch cancel out.  The per-item signals are emitted unchanged.
+	 *  Disabling delivers the current batch at once. */
+	void setCoalescing(bool enable);
+
+private:  // methods
+	/** Handler for all D-Bus signals of the daemon side object (called by
+	 *  SharedBrowser). */
+	void onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	/** Handlers for the single D-Bus signals (dispatched by onSignal()). */
+	void onItemNew(Interface interface, Protocol protocol, StringView name, StringView type,
+	               StringView domain, std::uint32_t flags);
+	void onItemRemove(Interface interface, Protocol protocol, StringView name, StringView type,
+	                  StringView domain, std::uint32_t flags);
+	void onFailure(StringView error);
+	void onAllForNow();
+	void onCacheExhausted();
+	/** Filters and emits an "ItemNew"/"ItemRemove" event. */
+	void onItem(bool isNew, ItemView const &item);
+	/** Adds an item event to the current batch. */
+	void coalesce(bool isNew, ItemView const &item);
+	/** Emits on_itemsChanged for the current batch. */
+	void flushItems();
+
 private:  // members
 	Client &m_client;
-	Glib::ustring m_objectPath;
-	::guint m_itemNew, m_itemRemove, m_failure, m_allForNow, m_cacheExhausted;
+	/** Daemon side object (shared with all handles with identical
+	 *  parameters). */
+	std::shared_ptr<SharedBrowser> m_shared;
+	/** Applied to "ItemNew"/"ItemRemove" before decoding. */
+	BrowseFilter m_filter;
+	bool m_coalescing;
+	/** Created when coalescing is enabled for the first time. */
+	std::unique_ptr<ItemBatch<Item>> m_batch;
 };
 
 } /* namespace Avahi */
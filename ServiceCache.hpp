@@ -0,0 +1,220 @@
+/**
+ *  \file
+ *  \brief Shared cache of browsed and resolved Avahi services
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_SERVICECACHE_HPP_
+#define SRC_AVAHI_SERVICECACHE_HPP_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include <avahi-common/address.h>      // AVAHI_PROTO_UNSPEC
+#include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
+
+#include "ServiceResolver.hpp"
+#include "Types.hpp"
+
+namespace Avahi {
+
+class Client;
+
+/** Process wide cache on top of Client::async_createServiceBrowser() and
+ *  Client::async_createServiceResolver().
+ *
+ *  For each (interface, protocol, type, domain) only a single ServiceBrowser
+ *  is created, regardless of the number of subscribers.  Every service
+ *  reported by the browser is resolved once and the resolver is kept alive
+ *  in order to receive TXT updates.  New subscribers get a snapshot of the
+ *  already known services without any round trip to the Avahi daemon.
+ *
+ *  Optionally, the cache can be saved to a snapshot file (saveSnapshot())
+ *  and restored from it after a restart (loadSnapshot()).  The restored
+ *  entries are reported at once, but marked as not verified until the
+ *  browser reports them again.
+ *
+ *  \note The cache must outlive all of its subscriptions.
+ */
+class ServiceCache
+{
+public:   // types
+	/** A service as reported by the browser, plus the resolved data (if
+	 *  #resolved is set). */
+	struct Entry
+	{
+		Interface interface;
+		Protocol protocol;
+		ServiceName name;
+		ServiceType type;
+		Domain domain;
+		::AvahiLookupResultFlags flags;
+		/** False for entries restored from a snapshot which have not been
+		 *  reported by the browser yet.  Such entries are confirmed (via
+		 *  on_updated) or removed (via on_removed) when the browser reports
+		 *  "CacheExhausted" or "AllForNow". */
+		bool verified;
+
+		bool resolved;
+		Host host;
+		ServiceResolver::AProtocol aprotocol;
+		ServiceResolver::Address address;
+		Port port;
+		Txt txt;
+	};
+
+private:  // types
+	struct Browse;
+
+public:   // types
+	/** Handle of a single subscriber.  The underlying browser is released
+	 *  when the last subscription for a query has been destroyed.  Use
+	 *  ServiceCache::subscribe() for creating a subscription. */
+	class Subscription
+	{
+		/* Use passkey idiom as constructor of Subscription cannot be made
+		 * private (due to use of std::make_shared()). */
+		friend ServiceCache;
+		class Token {};
+
+	public:   // slots
+		/** Type for handler to invoke when a service has been added,
+		 *  updated (resolved or TXT changed) or removed. */
+		using SlotEntry     = sigc::signal<void(Entry const &entry)>;
+		/** Type for handler to invoke when the browser has reported
+		 *  "AllForNow". */
+		using SlotAllForNow = sigc::signal<void()>;
+		/** Type for handler to invoke when browsing or resolving has
+		 *  failed. */
+		using SlotFailure   = sigc::signal<void(Error const &error)>;
+
+		/** Handler to invoke when a new service has been found. */
+		SlotEntry on_added;
+		/** Handler to invoke when a known service has been resolved or its
+		 *  resolved data has changed. */
+		SlotEntry on_updated;
+		/** Handler to invoke when a service has disappeared (called before
+		 *  the entry is removed from the cache). */
+		SlotEntry on_removed;
+		/** Handler to invoke when the browser has reported "AllForNow".  If
+		 *  this has already happened before subscribing, allForNow()
+		 *  returns true and the handler will not be invoked. */
+		SlotAllForNow on_allForNow;
+		/** Handler to invoke when browsing has failed, or when resolving a
+		 *  service has failed repeatedly (failed attempts are retried with
+		 *  exponential backoff; the entry stays unresolved afterwards). */
+		SlotFailure on_failure;
+
+	public:   // methods
+		/** Do not call this directly. Use ServiceCache::subscribe() instead. */
+		Subscription(Token, std::shared_ptr<Browse> browse);
+		~Subscription();
+		Subscription(Subscription const &other) = delete;
+		Subscription(Subscription &&other) = delete;
+		Subscription& operator=(Subscription const &other) = delete;
+		Subscription& operator=(Subscription &&other) = delete;
+
+		/** Returns all services currently known for this query.  The
+		 *  pointers are valid until the according on_removed emission. */
+		std::vector<Entry const *> snapshot() const;
+
+		/** Whether the browser has already reported "AllForNow". */
+		bool allForNow() const;
+
+	private:  // members
+		std::shared_ptr<Browse> m_browse;
+	};
+
+	/** Type for handler to invoke when an error message shall be printed to
+	 *  the application's log file. */
+	using SlotErrorLog = sigc::signal<void(char const *error)>;
+
+	/** Handler to invoke when an error message shall be printed to the
+	 *  application's log file. */
+	SlotErrorLog on_errorLog;
+
+public:   // methods
+	/** \param[in]  client      Client used for creating browsers/resolvers.
+	 *  \param[in]  aprotocol   Address protocol used for resolving the
+	 *                          services (see Client::async_createServiceResolver()).
+	 */
+	explicit ServiceCache(Client &client, Protocol aprotocol = AVAHI_PROTO_UNSPEC);
+	~ServiceCache();
+	ServiceCache(ServiceCache const &other) = delete;
+	ServiceCache(ServiceCache &&other) = delete;
+	ServiceCache& operator=(ServiceCache const &other) = delete;
+	ServiceCache& operator=(ServiceCache &&other) = delete;
+
+	/** Subscribes to a browse query.  If the query is already active, the
+	 *  returned subscription immediately provides a snapshot of the known
+	 *  services; afterwards only changes are reported via the subscription's
+	 *  signals.  Otherwise a new ServiceBrowser is created.  If creating
+	 *  the browser fails, on_failure is invoked for the current
+	 *  subscriptions and the next call creates a new browser again.
+	 *
+	 *  \param[in]  interface   See Client::async_createServiceBrowser().
+	 *  \param[in]  protocol    See Client::async_createServiceBrowser().
+	 *  \param[in]  type        See Client::async_createServiceBrowser().
+	 *  \param[in]  domain      See Client::async_createServiceBrowser().
+	 */
+	std::shared_ptr<Subscription> subscribe(Interface interface, Protocol protocol,
+	                                        ServiceType const &type, Domain const &domain);
+
+	/** Returns all cached entries (of all queries) for a service. */
+	std::vector<Entry const *> lookup(ServiceName const &name, ServiceType const &type, Domain const &domain) const;
+
+	/** Returns all resolved entries (of all queries) residing on \a host. */
+	std::vector<Entry const *> lookupHost(Host const &host) const;
+
+	/** Writes the entries of all active queries to the file \a path (which
+	 *  is replaced atomically).  Entries containing strings (or TXT data)
+	 *  which exceed the 16 bit lengths of the file format are skipped and
+	 *  reported via #on_errorLog.
+	 *
+	 *  \return false on error (which is reported via #on_errorLog).
+	 */
+	bool saveSnapshot(std::string const &path) const;
+
+	/** Restores entries written by saveSnapshot().  Should be called before
+	 *  the first subscribe().  The entries of a query are added (as not
+	 *  verified) when the query is subscribed, so they are immediately
+	 *  available via Subscription::snapshot(), lookup() and lookupHost().
+	 *  Entries of queries which are already active are ignored.
+	 *
+	 *  \return false if the file cannot be read or is malformed (reported
+	 *          via #on_errorLog).  Nothing is restored in this case.
+	 */
+	bool loadSnapshot(std::string const &path);
+
+private:  // types
+	using QueryKey = std::tuple<Interface, Protocol, std::string, std::string>;
+	using ServiceKey = std::tuple<std::string, std::string, std::string>;
+
+private:  // methods
+	void index(Entry const &entry);
+	void unindex(Entry const &entry);
+
+private:  // members
+	Client &m_client;
+	Protocol m_aprotocol;
+	/** Active queries.  The Browse objects are owned by the subscriptions. */
+	std::map<QueryKey, std::weak_ptr<Browse>> m_browses;
+	/** Index (name, type, domain) -> entry. */
+	std::multimap<ServiceKey, Entry const *> m_serviceIndex;
+	/** Index host -> resolved entry. */
+	std::multimap<std::string, Entry const *> m_hostIndex;
+	/** Entries restored by loadSnapshot() for queries which have not been
+	 *  subscribed yet. */
+	std::map<QueryKey, std::vector<Entry>> m_snapshot;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_SERVICECACHE_HPP_ */
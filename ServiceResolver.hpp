@@ -9,18 +9,25 @@
 #define SRC_AVAHI_SERVICERESOLVER_HPP_
 
 #include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 #include <glibmm/ustring.h>
+#include <glibmm/variant.h>
 #include <sigc++/signal.h>
 
 #include <avahi-common/defs.h>         // ::AvahiLookupResultFlags
 
+#include "BrowseFilter.hpp"
+#include "Events.hpp"
+#include "TxtRecord.hpp"
 #include "Types.hpp"
+#include "Views.hpp"
 
-extern "C" {
-	/** "Forward declaration" which avoids including the full <glib.h> file. */
-	typedef unsigned int    guint;
-}
+namespace Glib {
+	class Error;
+}  // namespace Glib
 
 namespace Avahi {
 
@@ -28,7 +35,7 @@ class Client;
 
 /** Proxy for an Avahi service resolver.  A service resolver is used to resolve
  *  the hostname/address/port/txt of services found by a ServiceBrowser. */
-class ServiceResolver
+class ServiceResolver : public std::enable_shared_from_this<ServiceResolver>
 {
 	/* Use passkey idiom as constructor of ServiceResolver cannot be made
 	 * private (due to use of std::make_shared()). */
@@ -43,12 +50,43 @@ public:   // types
 	/** IPv4/IPv6 address as string on the usual notation. */
 	using Address   = Glib::ustring;
 
+	/** Non-owning view on the parameters of a "Found" signal.  Only valid
+	 *  during emission of on_foundView. */
+	using FoundView = ResolvedEvent;
+
+	/** Bits of Changes::fields. */
+	enum ChangedField : unsigned
+	{
+		ChangedHost      = 1u << 0,
+		ChangedAProtocol = 1u << 1,
+		ChangedAddress   = 1u << 2,
+		ChangedPort      = 1u << 3,
+		ChangedTxt       = 1u << 4,
+		ChangedFlags     = 1u << 5,
+		ChangedAll       = (1u << 6) - 1,
+	};
+
+	/** Difference to the previous "Found" signal for the same interface and
+	 *  protocol.  Only valid during emission of on_changed. */
+	struct Changes
+	{
+		/** Combination of ChangedField bits. */
+		unsigned fields;
+		/** Keys which have been added, removed or whose value has changed
+		 *  (only set if #fields contains ChangedTxt). */
+		std::vector<StringView> txtKeys;
+	};
+
 public:   // slots
 	/** Type for handler to invoke when an error message shall be printed to
 	 *  the application's log file. */
 	using SlotErrorLog       = sigc::signal<void(char const *error)>;
 	/** Type for handler to invoke when resolving was successful. */
 	using SlotFound          = sigc::signal<void(/*Interface interface, Protocol protocol, */ServiceName const &name, /*ServiceType const &type, Domain const &domain, */Host const &host, AProtocol aprotocol, Address const &address, Port port, Txt const &txt, ::AvahiLookupResultFlags flags)>;
+	/** Type for allocation free variant of SlotFound. */
+	using SlotFoundView      = sigc::signal<void(FoundView const &found)>;
+	/** Type for handler to invoke when the resolved data has changed. */
+	using SlotChanged        = sigc::signal<void(FoundView const &found, Changes const &changes)>;
 	/** Type for handler to invoke when resolving has failed due to some reason. */
 	using SlotFailure        = sigc::signal<void(Error const &error)>;
 
@@ -60,22 +98,82 @@ public:   // slots
 	SlotErrorLog on_errorLog;
 	/** Handler to invoke when resolving was successful. */
 	SlotFound on_found;
+	/** Same as on_found, but without copying the parameters (including the
+	 *  TXT data).  If only this signal is connected, no strings/vectors are
+	 *  allocated at all. */
+	SlotFoundView on_foundView;
+	/** Same as on_foundView, but delivered via plain function pointers
+	 *  instead of sigc slots (see Listeners).  Invoked before all other
+	 *  handlers. */
+	Listeners<ResolvedEvent> on_event;
+	/** Like on_foundView, but only invoked if something has changed since
+	 *  the last "Found" signal for the same interface and protocol
+	 *  (identical re-announcements are suppressed).  The first result
+	 *  reports all fields and TXT keys as changed.  The last seen state is
+	 *  only kept while a handler is connected. */
+	SlotChanged on_changed;
 	/** Handler to invoke when resolving has failed due to some reason. */
 	SlotFailure on_failure;
 
 public:   // methods
 	/** Do not call this directly. Use Client::async_createEntryServiceResolver() instead. */
-	ServiceResolver(Token, Client &client, Glib::ustring const &objectPath);
+	ServiceResolver(Token, Client &client, Glib::ustring const &objectPath, Glib::VariantContainerBase const &parameters);
 	~ServiceResolver();
 	ServiceResolver(ServiceResolver const &other) = delete;
 	ServiceResolver(ServiceResolver &&other) = delete;
 	ServiceResolver& operator=(ServiceResolver const &other) = delete;
 	ServiceResolver& operator=(ServiceResolver &&other) = delete;
 
+	/** Drops "Found" signals which do not match \a filter (interface,
+	 *  protocol, service name and TXT conditions) before any handler is
+	 *  invoked.  Should be set from within the completion handler of
+	 *  Client::async_createServiceResolver(). */
+	void setFilter(BrowseFilter const &filter);
+
+private:  // types
+	/** Last result for a single interface/protocol (for on_changed). */
+	struct Seen
+	{
+		Interface interface;
+		Protocol protocol;
+		Host host;
+		AProtocol aprotocol;
+		Address address;
+		Port port;
+		TxtRecord txt;
+		::AvahiLookupResultFlags flags;
+	};
+
+private:  // methods
+	/** Compares \a found with the last result and emits on_changed. */
+	void emitChanged(FoundView const &found);
+	/** Starts the daemon side object after all signal handlers have been
+	 *  registered.  Must not be called from the constructor (the Start
+	 *  reply is guarded by weak_from_this()). */
+	void start();
+	/** Handler for all D-Bus signals of this object (called by Client). */
+	void onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	/** Handlers for the single D-Bus signals (dispatched by onSignal()). */
+	void onFound(Interface interface, Protocol protocol, StringView name, StringView type,
+	             StringView domain, StringView host, AProtocol aprotocol, StringView address,
+	             Port port, TxtView txt, std::uint32_t flags);
+	void onFailure(StringView error);
+	/** Handler for vanishing/re-appearing of the Avahi daemon (called by
+	 *  Client). */
+	void onSession(bool available);
+	/** Attaches this object to a re-created daemon side object. */
+	void rebind(Glib::ustring const &objectPath, Glib::Error const &error);
+
 private:  // members
 	Client &m_client;
+	/** Empty while detached from the daemon side object. */
 	Glib::ustring m_objectPath;
-	::guint m_found, m_failure;
+	/** Parameters of "ServiceResolverPrepare" (for re-creating the daemon side object). */
+	Glib::VariantContainerBase m_parameters;
+	BrowseFilter m_filter;
+	std::vector<Seen> m_seen;
+	/** Reused for every on_changed emission. */
+	Changes m_changes;
 };
 
 } /* namespace AvahiLib */
@@ -0,0 +1,153 @@
+/**
+ *  \file
+ *  \brief Compact TXT record with case-insensitive key lookup
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#ifndef SRC_AVAHI_TXTRECORD_HPP_
+#define SRC_AVAHI_TXTRECORD_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include <glibmm/variant.h>
+
+#include "Types.hpp"
+#include "Views.hpp"
+
+namespace Avahi {
+
+/** TXT data of a service (D-Bus type "aay"), stored in a single contiguous
+ *  buffer.
+ *
+ *  In contrast to #Txt, no heap allocation per TXT string is required.  The
+ *  buffer has the same layout as the serialized "aay" variant (without the
+ *  trailing framing offsets), so conversion to a GVariant is a single copy.
+ *  Keys are looked up via a small hash table, following the rules from
+ *  RFC 6763, section 6.4 ff.:
+ *  - keys are compared case-insensitively (ASCII only),
+ *  - if a key is present multiple times, only the first one counts,
+ *  - strings starting with '=' (empty key) are ignored for lookup,
+ *  - a string without '=' is a boolean attribute (present, but no value).
+ */
+class TxtRecord
+{
+public:   // types
+	/** A single TXT string, split into key and value. */
+	struct Entry
+	{
+		/** Complete TXT string ("key=value"). */
+		ByteView raw;
+		/** Key (as stored, not lower-cased). */
+		StringView key;
+		/** Value (empty if #hasValue is false). */
+		ByteView value;
+		/** false for boolean attributes ("key" without '='). */
+		bool hasValue;
+
+		/** Value as string (not necessarily valid UTF-8). */
+		StringView valueString() const { return StringView(reinterpret_cast<char const *>(value.data()), value.size()); }
+	};
+
+	/** Forward iterator over the TXT strings (in wire order). */
+	class const_iterator
+	{
+	public:   // types
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = Entry;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = void;
+		using reference         = Entry;
+
+	public:   // methods
+		const_iterator(TxtRecord const &record, std::size_t index)
+		: m_record(&record)
+		, m_index(index)
+		{}
+
+		Entry operator*() const { return (*m_record)[m_index]; }
+		const_iterator &operator++() { ++m_index; return *this; }
+		const_iterator operator++(int) { auto tmp = *this; ++m_index; return tmp; }
+		bool operator==(const_iterator const &other) const { return m_index == other.m_index; }
+		bool operator!=(const_iterator const &other) const { return m_index != other.m_index; }
+
+	private:  // members
+		TxtRecord const *m_record;
+		std::size_t m_index;
+	};
+
+public:   // methods
+	TxtRecord() = default;
+	/** Converts from the (legacy) per-string representation.  Implicit, so
+	 *  that #Txt can still be passed to all methods taking a TxtRecord. */
+	TxtRecord(Txt const &txt);
+	/** Creates a record from TXT strings, e.g. {"path=/", "version=2"}. */
+	TxtRecord(std::initializer_list<std::string_view> entries);
+	/** Creates a persistent copy of received TXT data.  All strings are
+	 *  copied into one buffer (no allocation per string). */
+	explicit TxtRecord(TxtView const &view);
+
+	/** Number of TXT strings. */
+	std::size_t size() const { return m_ends.size(); }
+	bool empty() const { return m_ends.empty(); }
+	/** Returns the TXT string at \a index (no range check). */
+	Entry operator[](std::size_t index) const;
+	const_iterator begin() const { return const_iterator(*this, 0); }
+	const_iterator end() const { return const_iterator(*this, size()); }
+
+	/** Returns the (first) entry with \a key (case-insensitive). */
+	std::optional<Entry> find(std::string_view key) const;
+	/** Returns true if an entry for \a key exists (also for boolean
+	 *  attributes). */
+	bool contains(std::string_view key) const { return lookup(key) != npos; }
+
+	/** Appends a raw TXT string (usually "key=value"; at most 255 bytes). */
+	TxtRecord &add(ByteView entry);
+	/** Appends "key=value". */
+	TxtRecord &add(std::string_view key, std::string_view value);
+	/** Appends a boolean attribute (just "key"). */
+	TxtRecord &add(std::string_view key);
+	/** Removes all entries. */
+	void clear();
+
+	/** Creates a persistent copy in the legacy per-string representation. */
+	Txt toTxt() const;
+	/** Creates an "aay" variant containing all TXT strings.  This requires
+	 *  a single allocation and copy for the whole record. */
+	Glib::VariantBase toVariant() const;
+
+	bool operator==(TxtRecord const &other) const { return m_data == other.m_data && m_ends == other.m_ends; }
+	bool operator!=(TxtRecord const &other) const { return !(*this == other); }
+	/** Whether \a view contains the same TXT strings (in the same order),
+	 *  without creating a copy of the viewed data. */
+	bool equals(TxtView const &view) const;
+
+private:  // methods
+	void append(std::uint8_t const *data, std::size_t size);
+	/** Returns the index of the first entry with \a key, or #npos. */
+	std::size_t lookup(std::string_view key) const;
+	/** Adds entry \a entry to #m_index (unless its key is already present). */
+	void index(std::size_t entry);
+	void rehash(std::size_t buckets);
+
+private:  // members
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	/** All TXT strings, without separators. */
+	std::vector<std::uint8_t> m_data;
+	/** End offset (in #m_data) of each TXT string. */
+	std::vector<std::uint32_t> m_ends;
+	/** Open addressing hash table over the keys (power of two size).  Each
+	 *  slot contains entry index + 1, or 0 if unused. */
+	std::vector<std::uint32_t> m_index;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_TXTRECORD_HPP_ */
@@ -0,0 +1,121 @@
+/**
+ *  \file
+ *  \brief Non-owning views on data inside received D-Bus messages
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  The views in this file point directly into the serialized buffer of a
+ *  received GVariant.  Creating them requires no heap allocation, but they
+ *  are only valid while the signal in which they have been passed is being
+ *  emitted.  Use the to*() methods for creating a persistent copy.
+ */
+
+#ifndef SRC_AVAHI_VIEWS_HPP_
+#define SRC_AVAHI_VIEWS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "Types.hpp"
+
+extern "C" {
+	/** "Forward declaration" which avoids including the full <glib.h> file. */
+	typedef struct _GVariant GVariant;
+}
+
+namespace Avahi {
+
+/** Non-owning view on a string (e.g. a service name) inside a D-Bus message. */
+using StringView = std::string_view;
+
+/** Non-owning view on a byte array (D-Bus type "ay") inside a D-Bus message. */
+class ByteView
+{
+public:   // types
+	using value_type     = std::uint8_t;
+	using const_iterator = std::uint8_t const *;
+
+public:   // methods
+	ByteView() = default;
+	ByteView(std::uint8_t const *data, std::size_t size)
+	: m_data(data)
+	, m_size(size)
+	{}
+
+	std::uint8_t const *data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	const_iterator begin() const { return m_data; }
+	const_iterator end() const { return m_data + m_size; }
+	std::uint8_t operator[](std::size_t index) const { return m_data[index]; }
+
+	/** Creates a persistent copy of the viewed data. */
+	RecordData toVector() const { return RecordData(begin(), end()); }
+
+private:  // members
+	std::uint8_t const *m_data = nullptr;
+	std::size_t m_size = 0;
+};
+
+/** Non-owning view on TXT data (D-Bus type "aay") inside a D-Bus message.
+ *  Each element is a ByteView on a single TXT string (usually "key=value"). */
+class TxtView
+{
+public:   // types
+	/** Forward iterator over the TXT strings. */
+	class const_iterator
+	{
+	public:   // types
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = ByteView;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = void;
+		using reference         = ByteView;
+
+	public:   // methods
+		const_iterator(TxtView const &view, std::size_t index)
+		: m_view(&view)
+		, m_index(index)
+		{}
+
+		ByteView operator*() const { return (*m_view)[m_index]; }
+		const_iterator &operator++() { ++m_index; return *this; }
+		const_iterator operator++(int) { auto tmp = *this; ++m_index; return tmp; }
+		bool operator==(const_iterator const &other) const { return m_index == other.m_index; }
+		bool operator!=(const_iterator const &other) const { return m_index != other.m_index; }
+
+	private:  // members
+		TxtView const *m_view;
+		std::size_t m_index;
+	};
+
+public:   // methods
+	TxtView() = default;
+	/** \param[in] variant  "aay" variant.  No reference is taken, so the
+	 *                      variant must outlive this view. */
+	explicit TxtView(GVariant *variant);
+
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	/** Returns the TXT string at \a index (no range check). */
+	ByteView operator[](std::size_t index) const;
+	const_iterator begin() const { return const_iterator(*this, 0); }
+	const_iterator end() const { return const_iterator(*this, m_size); }
+
+	/** Creates a persistent copy of the viewed TXT data. */
+	Txt toTxt() const;
+
+	/** Underlying "aay" variant (may be nullptr). */
+	GVariant *gobj() const { return m_variant; }
+
+private:  // members
+	GVariant *m_variant = nullptr;
+	std::size_t m_size = 0;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_VIEWS_HPP_ */
@@ -0,0 +1,496 @@
+/**
+ *  \file
+ *  \brief Throughput/latency/allocation benchmarks against a mock Avahi daemon
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Usage: avahi-bench [events [filter]]
+ *
+ *  Starts a private D-Bus bus (GTestDBus) with a fake Avahi daemon and
+ *  measures the signal and call paths of this library.  \a events is the
+ *  number of signals/calls per benchmark (default 10000), \a filter selects
+ *  the benchmarks whose name contains the given string.
+ *
+ *  Allocations are counted via a replacement of the global operator new, so
+ *  only allocations of C++ code (this library, glibmm, sigc++) are included.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <giomm/init.h>
+#include <glibmm/error.h>
+#include <glibmm/main.h>
+
+#include <avahi-common/address.h>      // AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC
+#include <gio/gio.h>
+
+#include "../Client.hpp"
+#include "../EntryGroup.hpp"
+#include "../RecordBrowser.hpp"
+#include "../ServiceBrowser.hpp"
+#include "../ServiceResolver.hpp"
+#include "MockServer.hpp"
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+void *operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t /*size*/) noexcept
+{
+	std::free(ptr);
+}
+
+namespace {
+
+using Avahi::Bench::MockServer;
+using Clock = MockServer::Clock;
+
+class Bench
+{
+public:   // methods
+	Bench(MockServer &mock, Avahi::Client &client, std::size_t events, char const *filter)
+	: m_mock(mock)
+	, m_client(client)
+	, m_events(events)
+	, m_filter(filter)
+	{}
+
+	MockServer &mock() { return m_mock; }
+	Avahi::Client &client() { return m_client; }
+	std::size_t events() const { return m_events; }
+
+	/** Whether the benchmark \a name has been selected on the command line. */
+	bool selected(char const *name) const
+	{
+		return !m_filter || std::strstr(name, m_filter);
+	}
+
+	/** Iterates the main loop until \a done returns true (or timeout). */
+	bool runUntil(std::function<bool()> const &done, std::chrono::seconds timeout = std::chrono::seconds(30))
+	{
+		auto context = Glib::MainContext::get_default();
+		auto const deadline = Clock::now() + timeout;
+
+		/* wake up regularly for checking the deadline */
+		auto wakeup = Glib::signal_timeout().connect([] { return true; }, 100);
+		while (!done() && Clock::now() < deadline)
+			context->iteration(true);
+		wakeup.disconnect();
+
+		return done();
+	}
+
+	/** To be called from the signal handler under test. */
+	void received(std::size_t count = 1)
+	{
+		auto const now = Clock::now();
+
+		for (std::size_t i = 0; i < count; i++)
+			m_received.push_back(now);
+	}
+
+	/** Measures a storm of signals emitted by \a emit. */
+	void storm(char const *name, std::function<void()> const &emit)
+	{
+		m_received.clear();
+		m_received.reserve(m_events);
+		m_mock.clearSendTimes(m_events);
+
+		auto const before = allocations.load();
+		emit();
+		bool const complete = runUntil([this] { return m_received.size() >= m_events; });
+		auto const allocs = allocations.load() - before;
+
+		report(name, complete, m_mock.sendTimes(), allocs);
+	}
+
+	/** Measures \a m_events method calls issued by \a issue (which must
+	 *  record the call times via issued() and the completions via
+	 *  received()). */
+	void calls(char const *name, std::function<void()> const &issue)
+	{
+		m_received.clear();
+		m_received.reserve(m_events);
+		m_issued.clear();
+		m_issued.reserve(m_events);
+
+		auto const before = allocations.load();
+		issue();
+		bool const complete = runUntil([this] { return m_received.size() >= m_events; });
+		auto const allocs = allocations.load() - before;
+
+		report(name, complete, m_issued, allocs);
+	}
+
+	/** To be called before issuing a method call under test. */
+	void issued() { m_issued.push_back(Clock::now()); }
+
+private:  // methods
+	void report(char const *name, bool complete, std::vector<Clock::time_point> const &sent, std::size_t allocs)
+	{
+		auto const count = std::min(sent.size(), m_received.size());
+		if (!complete || !count)
+		{
+			std::printf("%-40s incomplete: %zu of %zu events received\n", name, m_received.size(), m_events);
+			return;
+		}
+
+		std::vector<double> latencies;
+		latencies.reserve(count);
+		for (std::size_t i = 0; i < count; i++)
+			latencies.push_back(std::chrono::duration<double, std::micro>(m_received[i] - sent[i]).count());
+		std::sort(latencies.begin(), latencies.end());
+
+		auto const percentile = [&latencies](double p)
+		{
+			return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))];
+		};
+		auto const seconds = std::chrono::duration<double>(m_received[count - 1] - sent.front()).count();
+
+		std::printf("%-40s %9.0f ev/s  p50 %8.1f us  p90 %8.1f us  p99 %8.1f us  max %8.1f us  %6.2f allocs/ev\n",
+		            name, count / seconds, percentile(0.50), percentile(0.90), percentile(0.99),
+		            latencies.back(), static_cast<double>(allocs) / count);
+	}
+
+private:  // members
+	MockServer &m_mock;
+	Avahi::Client &m_client;
+	std::size_t m_events;
+	char const *m_filter;
+	std::vector<Clock::time_point> m_received;
+	std::vector<Clock::time_point> m_issued;
+};
+
+void fail(char const *what, Glib::Error const &error)
+{
+	std::string const message = error.what();
+
+	std::fprintf(stderr, "%s failed: %s\n", what, message.c_str());
+	std::exit(EXIT_FAILURE);
+}
+
+std::shared_ptr<Avahi::ServiceBrowser> createServiceBrowser(Bench &bench)
+{
+	std::shared_ptr<Avahi::ServiceBrowser> browser;
+
+	bench.client().async_createServiceBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "_bench._tcp", "local", {},
+		[&browser](std::shared_ptr<Avahi::ServiceBrowser> const &created, Glib::Error const &error)
+		{
+			if (error)
+				fail("ServiceBrowserPrepare", error);
+			browser = created;
+		});
+	bench.runUntil([&browser] { return browser != nullptr; });
+	return browser;
+}
+
+std::shared_ptr<Avahi::RecordBrowser> createRecordBrowser(Bench &bench)
+{
+	std::shared_ptr<Avahi::RecordBrowser> browser;
+
+	bench.client().async_createRecordBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "bench.local", 1, 1, {},
+		[&browser](std::shared_ptr<Avahi::RecordBrowser> const &created, Glib::Error const &error)
+		{
+			if (error)
+				fail("RecordBrowserPrepare", error);
+			browser = created;
+		});
+	bench.runUntil([&browser] { return browser != nullptr; });
+	return browser;
+}
+
+std::shared_ptr<Avahi::ServiceResolver> createServiceResolver(Bench &bench)
+{
+	std::shared_ptr<Avahi::ServiceResolver> resolver;
+
+	bench.client().async_createServiceResolver(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "bench", "_bench._tcp", "local",
+		AVAHI_PROTO_UNSPEC, {},
+		[&resolver](std::shared_ptr<Avahi::ServiceResolver> const &created, Glib::Error const &error)
+		{
+			if (error)
+				fail("ServiceResolverPrepare", error);
+			resolver = created;
+		});
+	bench.runUntil([&resolver] { return resolver != nullptr; });
+	return resolver;
+}
+
+std::shared_ptr<Avahi::EntryGroup> createEntryGroup(Bench &bench)
+{
+	std::shared_ptr<Avahi::EntryGroup> group;
+
+	bench.client().async_createEntryGroup(
+		[&group](std::shared_ptr<Avahi::EntryGroup> const &created, Glib::Error const &error)
+		{
+			if (error)
+				fail("EntryGroupNew", error);
+			group = created;
+		});
+	bench.runUntil([&group] { return group != nullptr; });
+	return group;
+}
+
+void benchServiceBrowser(Bench &bench)
+{
+	if (bench.selected("ServiceBrowser ItemNew (view)"))
+	{
+		auto browser = createServiceBrowser(bench);
+		browser->on_itemNewView.connect([&bench](Avahi::ServiceBrowser::ItemView const &/*item*/)
+		{
+			bench.received();
+		});
+		bench.storm("ServiceBrowser ItemNew (view)", [&bench]
+		{
+			bench.mock().emitServiceItemNew(bench.mock().lastObjectPath(MockServer::Kind::ServiceBrowser), bench.events());
+		});
+	}
+
+	if (bench.selected("ServiceBrowser ItemNew (copy)"))
+	{
+		auto browser = createServiceBrowser(bench);
+		browser->on_itemNew.connect([&bench](Avahi::Interface, Avahi::Protocol, Avahi::ServiceName const &,
+		                                     Avahi::ServiceType const &, Avahi::Domain const &, ::AvahiLookupResultFlags)
+		{
+			bench.received();
+		});
+		bench.storm("ServiceBrowser ItemNew (copy)", [&bench]
+		{
+			bench.mock().emitServiceItemNew(bench.mock().lastObjectPath(MockServer::Kind::ServiceBrowser), bench.events());
+		});
+	}
+
+	if (bench.selected("ServiceBrowser ItemNew (coalesced)"))
+	{
+		auto browser = createServiceBrowser(bench);
+		browser->setCoalescing(true);
+		browser->on_itemsChanged.connect([&bench](std::vector<Avahi::ServiceBrowser::Item> const &added,
+		                                          std::vector<Avahi::ServiceBrowser::Item> const &/*removed*/)
+		{
+			bench.received(added.size());
+		});
+		bench.storm("ServiceBrowser ItemNew (coalesced)", [&bench]
+		{
+			bench.mock().emitServiceItemNew(bench.mock().lastObjectPath(MockServer::Kind::ServiceBrowser), bench.events());
+		});
+	}
+}
+
+void benchRecordBrowser(Bench &bench)
+{
+	if (bench.selected("RecordBrowser ItemNew (view)"))
+	{
+		auto browser = createRecordBrowser(bench);
+		browser->on_itemNewView.connect([&bench](Avahi::RecordBrowser::ItemView const &/*item*/)
+		{
+			bench.received();
+		});
+		bench.storm("RecordBrowser ItemNew (view)", [&bench]
+		{
+			bench.mock().emitRecordItemNew(bench.mock().lastObjectPath(MockServer::Kind::RecordBrowser), bench.events());
+		});
+	}
+
+	if (bench.selected("RecordBrowser ItemNew (copy)"))
+	{
+		auto browser = createRecordBrowser(bench);
+		browser->on_itemNew.connect([&bench](Avahi::Interface, Avahi::Protocol, Avahi::RecordName const &,
+		                                     Avahi::RecordClass, Avahi::RecordType const &,
+		                                     Avahi::RecordData const &, ::AvahiLookupResultFlags)
+		{
+			bench.received();
+		});
+		bench.storm("RecordBrowser ItemNew (copy)", [&bench]
+		{
+			bench.mock().emitRecordItemNew(bench.mock().lastObjectPath(MockServer::Kind::RecordBrowser), bench.events());
+		});
+	}
+}
+
+void benchServiceResolver(Bench &bench)
+{
+	if (bench.selected("ServiceResolver Found (view)"))
+	{
+		auto resolver = createServiceResolver(bench);
+		resolver->on_foundView.connect([&bench](Avahi::ServiceResolver::FoundView const &/*found*/)
+		{
+			bench.received();
+		});
+		bench.storm("ServiceResolver Found (view)", [&bench]
+		{
+			bench.mock().emitFound(bench.mock().lastObjectPath(MockServer::Kind::ServiceResolver), bench.events());
+		});
+	}
+
+	if (bench.selected("ServiceResolver Found (copy)"))
+	{
+		auto resolver = createServiceResolver(bench);
+		resolver->on_found.connect([&bench](Avahi::ServiceName const &, Avahi::Host const &,
+		                                    Avahi::ServiceResolver::AProtocol, Avahi::ServiceResolver::Address const &,
+		                                    Avahi::Port, Avahi::Txt const &, ::AvahiLookupResultFlags)
+		{
+			bench.received();
+		});
+		bench.storm("ServiceResolver Found (copy)", [&bench]
+		{
+			bench.mock().emitFound(bench.mock().lastObjectPath(MockServer::Kind::ServiceResolver), bench.events());
+		});
+	}
+}
+
+void benchEntryGroup(Bench &bench)
+{
+	if (bench.selected("EntryGroup StateChanged"))
+	{
+		auto group = createEntryGroup(bench);
+		group->on_stateChanged.connect([&bench](::AvahiEntryGroupState, Glib::ustring const &)
+		{
+			bench.received();
+		});
+		bench.storm("EntryGroup StateChanged", [&bench]
+		{
+			bench.mock().emitEntryGroupStateChanged(bench.mock().lastObjectPath(MockServer::Kind::EntryGroup), bench.events());
+		});
+	}
+
+	if (bench.selected("EntryGroup AddService (call)"))
+	{
+		auto group = createEntryGroup(bench);
+		Avahi::Txt const txt{{'t', 'x', 't', 'v', 'e', 'r', 's', '=', '1'}};
+
+		bench.calls("EntryGroup AddService (call)", [&bench, &group, &txt]
+		{
+			for (std::size_t i = 0; i < bench.events(); i++)
+			{
+				bench.issued();
+				group->async_addService(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {}, "bench", "_bench._tcp", "local",
+					"", 80, txt, [&bench](Glib::Error const &error)
+					{
+						if (error)
+							fail("AddService", error);
+						bench.received();
+					});
+			}
+		});
+	}
+}
+
+void benchClient(Bench &bench)
+{
+	if (bench.selected("Client StateChanged"))
+	{
+		auto connection = bench.client().on_serverStateChanged.connect([&bench](::AvahiServerState, Glib::ustring const &)
+		{
+			bench.received();
+		});
+		bench.storm("Client StateChanged", [&bench]
+		{
+			bench.mock().emitServerStateChanged(bench.events());
+		});
+		connection.disconnect();
+	}
+
+	if (bench.selected("Client GetHostName (call)"))
+	{
+		bench.calls("Client GetHostName (call)", [&bench]
+		{
+			for (std::size_t i = 0; i < bench.events(); i++)
+			{
+				bench.issued();
+				bench.client().async_getHostName([&bench](Glib::ustring const &/*hostname*/, Glib::Error const &error)
+				{
+					if (error)
+						fail("GetHostName", error);
+					bench.received();
+				});
+			}
+		});
+	}
+}
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	std::size_t const events = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+	char const *filter = (argc > 2) ? argv[2] : nullptr;
+
+	Gio::init();
+
+	/* private bus; the Client connects to the "system" bus */
+	auto *bus = ::g_test_dbus_new(G_TEST_DBUS_NONE);
+	::g_test_dbus_up(bus);
+	std::string const address = ::g_test_dbus_get_bus_address(bus);
+	::g_setenv("DBUS_SYSTEM_BUS_ADDRESS", address.c_str(), TRUE);
+
+	int result = EXIT_SUCCESS;
+	{
+		MockServer mock(address);
+		mock.acquire();
+
+		Avahi::Client client;
+		bool connected = false;
+		client.on_connected.connect([&connected] { connected = true; });
+
+		Bench bench(mock, client, events, filter);
+		if (bench.runUntil([&connected] { return connected; }))
+		{
+			benchServiceBrowser(bench);
+			benchRecordBrowser(bench);
+			benchServiceResolver(bench);
+			benchEntryGroup(bench);
+			benchClient(bench);
+
+			/* let outstanding "Free" calls finish */
+			bench.runUntil([&mock] { return mock.liveObjects() == 0; }, std::chrono::seconds(5));
+		}
+		else
+		{
+			std::fprintf(stderr, "Cannot connect to mock Avahi daemon\n");
+			result = EXIT_FAILURE;
+		}
+	}
+
+	::g_test_dbus_down(bus);
+	::g_object_unref(bus);
+	return result;
+}
@@ -0,0 +1,355 @@
+/**
+ *  \file
+ *  \brief Fake Avahi daemon on a private D-Bus bus
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include <avahi-common/dbus.h>
+#include <avahi-common/defs.h>         // AVAHI_SERVER_RUNNING, AVAHI_ENTRY_GROUP_ESTABLISHED
+
+#include "MockServer.hpp"              // IWYU pragma: associated
+
+namespace Avahi::Bench {
+
+namespace {
+
+char const introspection[] =
+	"<node>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_SERVER "'>"
+	"    <method name='GetState'><arg direction='out' type='i'/></method>"
+	"    <method name='GetHostName'><arg direction='out' type='s'/></method>"
+	"    <method name='SetHostName'><arg direction='in' type='s'/></method>"
+	"    <method name='ReconfirmRecord'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='q'/><arg direction='in' type='q'/><arg direction='in' type='u'/>"
+	"      <arg direction='in' type='ay'/>"
+	"    </method>"
+	"    <method name='EntryGroupNew'><arg direction='out' type='o'/></method>"
+	"    <signal name='StateChanged'><arg type='i'/><arg type='s'/></signal>"
+	"  </interface>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_SERVER2 "'>"
+	"    <method name='RecordBrowserPrepare'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='q'/><arg direction='in' type='q'/><arg direction='in' type='u'/>"
+	"      <arg direction='out' type='o'/>"
+	"    </method>"
+	"    <method name='ServiceBrowserPrepare'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='u'/>"
+	"      <arg direction='out' type='o'/>"
+	"    </method>"
+	"    <method name='ServiceResolverPrepare'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='s'/><arg direction='in' type='i'/>"
+	"      <arg direction='in' type='u'/>"
+	"      <arg direction='out' type='o'/>"
+	"    </method>"
+	"  </interface>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_ENTRY_GROUP "'>"
+	"    <method name='Free'/>"
+	"    <method name='Commit'/>"
+	"    <method name='Reset'/>"
+	"    <method name='GetState'><arg direction='out' type='i'/></method>"
+	"    <method name='AddService'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='u'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='s'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='q'/><arg direction='in' type='aay'/>"
+	"    </method>"
+	"    <method name='AddServiceSubtype'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='u'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='s'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='s'/>"
+	"    </method>"
+	"    <method name='UpdateServiceTxt'>"
+	"      <arg direction='in' type='i'/><arg direction='in' type='i'/><arg direction='in' type='u'/>"
+	"      <arg direction='in' type='s'/><arg direction='in' type='s'/><arg direction='in' type='s'/>"
+	"      <arg direction='in' type='aay'/>"
+	"    </method>"
+	"    <signal name='StateChanged'><arg type='i'/><arg type='s'/></signal>"
+	"  </interface>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_RECORD_BROWSER "'>"
+	"    <method name='Free'/><method name='Start'/>"
+	"  </interface>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_SERVICE_BROWSER "'>"
+	"    <method name='Free'/><method name='Start'/>"
+	"  </interface>"
+	"  <interface name='" AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER "'>"
+	"    <method name='Free'/><method name='Start'/>"
+	"  </interface>"
+	"</node>";
+
+char const *interfaceOf(MockServer::Kind kind)
+{
+	switch (kind)
+	{
+		case MockServer::Kind::EntryGroup:      return AVAHI_DBUS_INTERFACE_ENTRY_GROUP;
+		case MockServer::Kind::RecordBrowser:   return AVAHI_DBUS_INTERFACE_RECORD_BROWSER;
+		case MockServer::Kind::ServiceBrowser:  return AVAHI_DBUS_INTERFACE_SERVICE_BROWSER;
+		case MockServer::Kind::ServiceResolver: return AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER;
+	}
+	return nullptr;
+}
+
+char const *nameOf(MockServer::Kind kind)
+{
+	switch (kind)
+	{
+		case MockServer::Kind::EntryGroup:      return "EntryGroup";
+		case MockServer::Kind::RecordBrowser:   return "RecordBrowser";
+		case MockServer::Kind::ServiceBrowser:  return "ServiceBrowser";
+		case MockServer::Kind::ServiceResolver: return "ServiceResolver";
+	}
+	return nullptr;
+}
+
+}  // namespace
+
+GDBusInterfaceVTable const MockServer::s_vtable = {&MockServer::onMethodCall, nullptr, nullptr, {}};
+
+MockServer::MockServer(std::string const &address)
+: m_connection(nullptr)
+, m_nodeInfo(nullptr)
+, m_serverRegistrations{0, 0}
+, m_ownerId(0)
+, m_nextObject(1)
+, m_methodCalls(0)
+{
+	GError *error = nullptr;
+
+	m_connection = ::g_dbus_connection_new_for_address_sync(address.c_str(),
+		static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+		                                  G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+		nullptr, nullptr, &error);
+	if (!m_connection)
+	{
+		std::string message = std::string("MockServer: Cannot connect to bus: ") + error->message;
+		::g_error_free(error);
+		throw std::runtime_error(message);
+	}
+
+	m_nodeInfo = ::g_dbus_node_info_new_for_xml(introspection, &error);
+	if (!m_nodeInfo)
+	{
+		std::string message = std::string("MockServer: Cannot parse introspection data: ") + error->message;
+		::g_error_free(error);
+		throw std::runtime_error(message);
+	}
+}
+
+MockServer::~MockServer()
+{
+	release();
+	::g_dbus_node_info_unref(m_nodeInfo);
+	::g_object_unref(m_connection);
+}
+
+void MockServer::acquire()
+{
+	if (m_ownerId)
+		return;
+
+	char const *const interfaces[] = {AVAHI_DBUS_INTERFACE_SERVER, AVAHI_DBUS_INTERFACE_SERVER2};
+	for (std::size_t i = 0; i < 2; i++)
+	{
+		m_serverRegistrations[i] = ::g_dbus_connection_register_object(m_connection, AVAHI_DBUS_PATH_SERVER,
+			::g_dbus_node_info_lookup_interface(m_nodeInfo, interfaces[i]), &s_vtable, this, nullptr, nullptr);
+	}
+
+	m_ownerId = ::g_bus_own_name_on_connection(m_connection, AVAHI_DBUS_NAME,
+		G_BUS_NAME_OWNER_FLAGS_NONE, nullptr, nullptr, nullptr, nullptr);
+}
+
+void MockServer::release()
+{
+	if (!m_ownerId)
+		return;
+
+	::g_bus_unown_name(m_ownerId);
+	m_ownerId = 0;
+
+	for (auto &registration : m_serverRegistrations)
+	{
+		::g_dbus_connection_unregister_object(m_connection, registration);
+		registration = 0;
+	}
+
+	for (auto const &[path, object] : m_objects)
+		::g_dbus_connection_unregister_object(m_connection, object.registration);
+	m_objects.clear();
+}
+
+std::string const &MockServer::lastObjectPath(Kind kind) const
+{
+	static std::string const none;
+
+	auto it = m_lastPaths.find(kind);
+	return (it != m_lastPaths.end()) ? it->second : none;
+}
+
+void MockServer::clearSendTimes(std::size_t count)
+{
+	m_sendTimes.clear();
+	m_sendTimes.reserve(count);
+}
+
+void MockServer::emitServerStateChanged(std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		emit(AVAHI_DBUS_PATH_SERVER, AVAHI_DBUS_INTERFACE_SERVER, "StateChanged",
+		     ::g_variant_new("(is)", static_cast<gint32>(AVAHI_SERVER_RUNNING), ""));
+}
+
+void MockServer::emitEntryGroupStateChanged(std::string const &objectPath, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; i++)
+		emit(objectPath.c_str(), AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "StateChanged",
+		     ::g_variant_new("(is)", static_cast<gint32>(AVAHI_ENTRY_GROUP_ESTABLISHED), ""));
+}
+
+void MockServer::emitServiceItemNew(std::string const &objectPath, std::size_t count)
+{
+	char name[32];
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::snprintf(name, sizeof(name), "bench-%zu", i);
+		emit(objectPath.c_str(), AVAHI_DBUS_INTERFACE_SERVICE_BROWSER, "ItemNew",
+		     ::g_variant_new("(iisssu)", 2, 0, name, "_bench._tcp", "local", 0u));
+	}
+}
+
+void MockServer::emitRecordItemNew(std::string const &objectPath, std::size_t count)
+{
+	static guint8 const rdata[] = {192, 168, 0, 1};
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		emit(objectPath.c_str(), AVAHI_DBUS_INTERFACE_RECORD_BROWSER, "ItemNew",
+		     ::g_variant_new("(iisqq@ayu)", 2, 0, "bench.local", 1, 1,
+		                     ::g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, rdata, sizeof(rdata), 1), 0u));
+	}
+}
+
+void MockServer::emitFound(std::string const &objectPath, std::size_t count)
+{
+	static char const *const txt[] = {"txtvers=1", "model=bench", "serial=0123456789"};
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		GVariantBuilder builder;
+
+		::g_variant_builder_init(&builder, G_VARIANT_TYPE("aay"));
+		for (auto const *entry : txt)
+			::g_variant_builder_add_value(&builder,
+				::g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, entry, std::char_traits<char>::length(entry), 1));
+
+		emit(objectPath.c_str(), AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, "Found",
+		     ::g_variant_new("(iissssisqaayu)", 2, 0, "bench", "_bench._tcp", "local",
+		                     "bench.local", 0, "192.168.0.1", 80, &builder, 0u));
+	}
+}
+
+void MockServer::onMethodCall(GDBusConnection * /*connection*/, gchar const * /*sender*/,
+        gchar const *objectPath, gchar const * /*interfaceName*/,
+        gchar const *methodName, GVariant * /*parameters*/,
+        GDBusMethodInvocation *invocation, gpointer userData)
+{
+	auto *self = static_cast<MockServer *>(userData);
+
+	self->m_methodCalls++;
+	if (std::strcmp(objectPath, AVAHI_DBUS_PATH_SERVER) == 0)
+		self->handleServer(methodName, invocation);
+	else
+		self->handleObject(objectPath, methodName, invocation);
+}
+
+void MockServer::handleServer(gchar const *methodName, GDBusMethodInvocation *invocation)
+{
+	/* std::strcmp() avoids allocations in the mock */
+	auto const is = [methodName](char const *name) { return std::strcmp(methodName, name) == 0; };
+
+	if (is("GetState"))
+		::g_dbus_method_invocation_return_value(invocation, ::g_variant_new("(i)", static_cast<gint32>(AVAHI_SERVER_RUNNING)));
+	else if (is("GetHostName"))
+		::g_dbus_method_invocation_return_value(invocation, ::g_variant_new("(s)", "bench"));
+	else if (is("SetHostName") || is("ReconfirmRecord"))
+		::g_dbus_method_invocation_return_value(invocation, nullptr);
+	else
+	{
+		Kind kind;
+
+		if (is("EntryGroupNew"))
+			kind = Kind::EntryGroup;
+		else if (is("RecordBrowserPrepare"))
+			kind = Kind::RecordBrowser;
+		else if (is("ServiceBrowserPrepare"))
+			kind = Kind::ServiceBrowser;
+		else
+			kind = Kind::ServiceResolver;
+
+		auto const path = createObject(kind);
+		::g_dbus_method_invocation_return_value(invocation, ::g_variant_new("(o)", path.c_str()));
+		on_objectCreated(kind, path);
+	}
+}
+
+void MockServer::handleObject(gchar const *objectPath, gchar const *methodName, GDBusMethodInvocation *invocation)
+{
+	auto const is = [methodName](char const *name) { return std::strcmp(methodName, name) == 0; };
+
+	auto it = m_objects.find(std::string_view(objectPath));
+	if (it == m_objects.end())
+	{
+		::g_dbus_method_invocation_return_dbus_error(invocation, "org.freedesktop.Avahi.BadStateError", "Unknown object");
+		return;
+	}
+
+	auto const kind = it->second.kind;
+	if (is("GetState"))
+	{
+		::g_dbus_method_invocation_return_value(invocation, ::g_variant_new("(i)", 0));
+		return;
+	}
+
+	::g_dbus_method_invocation_return_value(invocation, nullptr);
+
+	if (is("Free"))
+	{
+		auto const path = it->first;
+
+		::g_dbus_connection_unregister_object(m_connection, it->second.registration);
+		m_objects.erase(it);
+		on_objectFreed(kind, path);
+	}
+	else if (is("Start"))
+		on_objectStarted(kind, it->first);
+	else if (is("Commit"))
+		emit(objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "StateChanged",
+		     ::g_variant_new("(is)", static_cast<gint32>(AVAHI_ENTRY_GROUP_ESTABLISHED), ""));
+}
+
+std::string MockServer::createObject(Kind kind)
+{
+	auto const path = std::string("/Client1/") + nameOf(kind) + std::to_string(m_nextObject++);
+	auto const registration = ::g_dbus_connection_register_object(m_connection, path.c_str(),
+		::g_dbus_node_info_lookup_interface(m_nodeInfo, interfaceOf(kind)), &s_vtable, this, nullptr, nullptr);
+
+	m_objects.emplace(path, Object{kind, registration});
+	m_lastPaths[kind] = path;
+	return path;
+}
+
+void MockServer::emit(gchar const *objectPath, gchar const *interfaceName, gchar const *signalName, GVariant *parameters)
+{
+	if (m_sendTimes.size() < m_sendTimes.capacity())
+		m_sendTimes.push_back(Clock::now());
+	::g_dbus_connection_emit_signal(m_connection, nullptr, objectPath, interfaceName, signalName, parameters, nullptr);
+}
+
+} /* namespace Avahi::Bench */
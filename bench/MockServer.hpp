@@ -0,0 +1,126 @@
+/**
+ *  \file
+ *  \brief Fake Avahi daemon on a private D-Bus bus
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  The mock implements just enough of the org.freedesktop.Avahi D-Bus API
+ *  for creating entry groups, browsers and resolvers, and emits configurable
+ *  storms of signals on them.  It is implemented with the plain GDBus C API
+ *  so that its own work does not show up in the allocation counts of
+ *  the benchmarks.
+ */
+
+#ifndef SRC_AVAHI_BENCH_MOCKSERVER_HPP_
+#define SRC_AVAHI_BENCH_MOCKSERVER_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sigc++/signal.h>
+
+#include <gio/gio.h>
+
+namespace Avahi::Bench {
+
+class MockServer
+{
+public:   // types
+	using Clock = std::chrono::steady_clock;
+
+	/** Kind of daemon side object. */
+	enum class Kind
+	{
+		EntryGroup,
+		RecordBrowser,
+		ServiceBrowser,
+		ServiceResolver,
+	};
+
+public:   // slots
+	/** Type for handler to invoke when a daemon side object has been
+	 *  created/started/freed by the client. */
+	using SlotObject = sigc::signal<void(Kind kind, std::string const &objectPath)>;
+
+	/** Handler to invoke when a *Prepare/EntryGroupNew call has been answered. */
+	SlotObject on_objectCreated;
+	/** Handler to invoke when "Start" has been called on a browser/resolver. */
+	SlotObject on_objectStarted;
+	/** Handler to invoke when "Free" has been called. */
+	SlotObject on_objectFreed;
+
+public:   // methods
+	/** \param[in]  address  D-Bus address of the (test) bus. */
+	explicit MockServer(std::string const &address);
+	~MockServer();
+	MockServer(MockServer const &other) = delete;
+	MockServer(MockServer &&other) = delete;
+	MockServer& operator=(MockServer const &other) = delete;
+	MockServer& operator=(MockServer &&other) = delete;
+
+	/** Acquires the well known name "org.freedesktop.Avahi" (daemon start). */
+	void acquire();
+	/** Drops all objects and releases the well known name (daemon stop). */
+	void release();
+
+	/** Object path of the most recently created object of \a kind. */
+	std::string const &lastObjectPath(Kind kind) const;
+	/** Number of currently existing daemon side objects. */
+	std::size_t liveObjects() const { return m_objects.size(); }
+	/** Number of method calls received so far. */
+	std::size_t methodCalls() const { return m_methodCalls; }
+
+	/** Send time stamps of all signals emitted since clearSendTimes(). */
+	std::vector<Clock::time_point> const &sendTimes() const { return m_sendTimes; }
+	/** Clears the send time stamps and reserves space for \a count entries. */
+	void clearSendTimes(std::size_t count);
+
+	/** Emits \a count server "StateChanged" signals. */
+	void emitServerStateChanged(std::size_t count);
+	/** Emits \a count entry group "StateChanged" signals. */
+	void emitEntryGroupStateChanged(std::string const &objectPath, std::size_t count);
+	/** Emits \a count service browser "ItemNew" signals (distinct names). */
+	void emitServiceItemNew(std::string const &objectPath, std::size_t count);
+	/** Emits \a count record browser "ItemNew" signals. */
+	void emitRecordItemNew(std::string const &objectPath, std::size_t count);
+	/** Emits \a count service resolver "Found" signals (with TXT data). */
+	void emitFound(std::string const &objectPath, std::size_t count);
+
+private:  // methods
+	static void onMethodCall(GDBusConnection *connection, gchar const *sender,
+	                         gchar const *objectPath, gchar const *interfaceName,
+	                         gchar const *methodName, GVariant *parameters,
+	                         GDBusMethodInvocation *invocation, gpointer userData);
+	void handleServer(gchar const *methodName, GDBusMethodInvocation *invocation);
+	void handleObject(gchar const *objectPath, gchar const *methodName, GDBusMethodInvocation *invocation);
+	std::string createObject(Kind kind);
+	void emit(gchar const *objectPath, gchar const *interfaceName, gchar const *signalName, GVariant *parameters);
+
+private:  // types
+	struct Object
+	{
+		Kind kind;
+		guint registration;
+	};
+
+private:  // members
+	static GDBusInterfaceVTable const s_vtable;
+
+	GDBusConnection *m_connection;
+	GDBusNodeInfo *m_nodeInfo;
+	guint m_serverRegistrations[2];
+	guint m_ownerId;
+	std::size_t m_nextObject;
+	std::size_t m_methodCalls;
+	std::map<std::string, Object, std::less<>> m_objects;
+	std::map<Kind, std::string> m_lastPaths;
+	std::vector<Clock::time_point> m_sendTimes;
+};
+
+} /* namespace Avahi::Bench */
+
+#endif /* SRC_AVAHI_BENCH_MOCKSERVER_HPP_ */
@@ -0,0 +1,391 @@
+/**
+ *  \file
+ *  \brief Soak test of the object lifetime model against a mock Avahi daemon
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Usage: avahi-soak [cycles [objects [restartEvery]]]
+ *
+ *  Starts a private D-Bus bus (GTestDBus) with a fake Avahi daemon (see
+ *  MockServer) and runs \a cycles cycles (default 1000).  Each cycle creates
+ *  \a objects service browsers, service resolvers and entry groups each
+ *  (default 50), waits for their first event (ItemNew/Found/publishing) and
+ *  destroys them again.  Every \a restartEvery cycles (default 25, 0 for
+ *  never) the daemon is stopped while the creations are still in flight
+ *  and started again afterwards (with persistent session enabled, so that
+ *  the Client re-creates the surviving objects).
+ *
+ *  Every 10 cycles, a line with the resident set size, the number of live
+ *  C++ allocations, pending calls, live proxy objects on the client side,
+ *  live objects on the daemon side and the cycle latency is printed.  When
+ *  the lifetime model leaks, the memory and object columns grow over time;
+ *  when it slows down, the latency grows.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <giomm/init.h>
+#include <glibmm/error.h>
+#include <glibmm/main.h>
+
+#include <avahi-common/address.h>      // AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC
+#include <gio/gio.h>
+#include <unistd.h>                    // sysconf()
+
+#include "../Client.hpp"
+#include "../EntryGroup.hpp"
+#include "../ServiceBrowser.hpp"
+#include "../ServiceResolver.hpp"
+#include "MockServer.hpp"
+
+namespace {
+
+/** Number of C++ allocations which have not been freed yet. */
+std::atomic<std::ptrdiff_t> liveAllocations{0};
+
+}  // namespace
+
+void *operator new(std::size_t size)
+{
+	if (void *ptr = std::malloc(size ? size : 1))
+	{
+		liveAllocations.fetch_add(1, std::memory_order_relaxed);
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	if (ptr)
+		liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t /*size*/) noexcept
+{
+	operator delete(ptr);
+}
+
+namespace {
+
+using Avahi::Bench::MockServer;
+using Clock = MockServer::Clock;
+
+/** Resident set size [kB] (0 if unknown). */
+long residentSetSize()
+{
+	std::ifstream statm("/proc/self/statm");
+	long size = 0, resident = 0;
+
+	if (!(statm >> size >> resident))
+		return 0;
+	return resident * (::sysconf(_SC_PAGESIZE) / 1024);
+}
+
+class Soak
+{
+public:   // methods
+	Soak(MockServer &mock, Avahi::Client &client, std::size_t objects, std::size_t restartEvery)
+	: m_mock(mock)
+	, m_client(client)
+	, m_objects(objects)
+	, m_restartEvery(restartEvery)
+	, m_connected(false)
+	, m_waiting(0)
+	, m_events(0)
+	, m_failures(0)
+	, m_stuck(0)
+	{
+		m_client.on_connected.connect([this] { m_connected = true; });
+		m_client.on_disconncted.connect([this] { m_connected = false; });
+
+		/* every started browser/resolver reports a single event */
+		m_mock.on_objectStarted.connect([this](MockServer::Kind kind, std::string const &objectPath)
+		{
+			Glib::signal_idle().connect_once([this, kind, objectPath]
+			{
+				if (kind == MockServer::Kind::ServiceBrowser)
+					m_mock.emitServiceItemNew(objectPath, 1);
+				else if (kind == MockServer::Kind::ServiceResolver)
+					m_mock.emitFound(objectPath, 1);
+			});
+		});
+	}
+
+	/** Iterates the main loop until \a done returns true (or timeout). */
+	bool runUntil(std::function<bool()> const &done, std::chrono::seconds timeout = std::chrono::seconds(30))
+	{
+		auto context = Glib::MainContext::get_default();
+		auto const deadline = Clock::now() + timeout;
+
+		/* wake up regularly for checking the deadline */
+		auto wakeup = Glib::signal_timeout().connect([] { return true; }, 100);
+		while (!done() && Clock::now() < deadline)
+			context->iteration(true);
+		wakeup.disconnect();
+
+		return done();
+	}
+
+	bool connect()
+	{
+		return runUntil([this] { return m_connected; });
+	}
+
+	/** Runs a single create/destroy cycle and returns its duration. */
+	Clock::duration cycle(std::size_t index)
+	{
+		bool const restart = m_restartEvery && (index % m_restartEvery) == m_restartEvery - 1;
+		auto const start = Clock::now();
+
+		m_events = 0;
+		create();
+
+		if (restart)
+		{
+			/* stop the daemon while the creations are still in flight */
+			runUntil([this] { return m_waiting <= 2 * m_objects; });
+			m_mock.release();
+			runUntil([this] { return !m_connected; });
+			m_mock.acquire();
+			if (!connect())
+				std::fprintf(stderr, "cycle %zu: Cannot reconnect to mock Avahi daemon\n", index);
+
+			/* some calls may have been deferred until the daemon re-appeared */
+			runUntil([this] { return m_waiting == 0; });
+		}
+		else
+		{
+			runUntil([this] { return m_waiting == 0 && m_events >= 3 * m_objects; });
+		}
+
+		destroy();
+
+		/* all daemon side objects must have been freed */
+		if (!runUntil([this] { return m_mock.liveObjects() == 0 && pendingCalls() == 0; }, std::chrono::seconds(5)))
+			m_stuck++;
+
+		return Clock::now() - start;
+	}
+
+	/** Prints the table header. */
+	static void header()
+	{
+		std::printf("%8s %10s %10s %8s %8s %8s %8s %8s %10s %10s %10s\n",
+		            "cycle", "rss [kB]", "allocs", "pending", "proxies", "daemon", "failed", "stuck",
+		            "min [ms]", "avg [ms]", "max [ms]");
+	}
+
+	/** Prints a table line for the cycles since the previous report. */
+	void report(std::size_t index, std::vector<Clock::duration> const &durations)
+	{
+		auto const metrics = m_client.getMetrics();
+		auto const ms = [](Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::milli>(duration).count();
+		};
+
+		Clock::duration sum{};
+		for (auto const &duration : durations)
+			sum += duration;
+
+		std::printf("%8zu %10ld %10td %8zu %8zu %8zu %8zu %8zu %10.1f %10.1f %10.1f\n",
+		            index, residentSetSize(), liveAllocations.load(), pendingCalls(),
+		            metrics.objects.size(), m_mock.liveObjects(), m_failures, m_stuck,
+		            ms(*std::min_element(durations.begin(), durations.end())),
+		            ms(sum) / durations.size(),
+		            ms(*std::max_element(durations.begin(), durations.end())));
+		std::fflush(stdout);
+	}
+
+	/** Number of daemon calls still waiting for their reply (or for a slot
+	 *  in the call window). */
+	std::size_t pendingCalls() const
+	{
+		auto const metrics = m_client.getMetrics();
+		std::size_t pending = 0;
+
+		for (auto const &call : metrics.calls)
+			pending += call.pending;
+		for (auto const &queue : metrics.queues)
+			pending += queue.queued;
+		return pending;
+	}
+
+private:  // methods
+	void create()
+	{
+		for (std::size_t i = 0; i < m_objects; i++)
+		{
+			/* distinct types, so that the browsers do not share a daemon side
+			 * object */
+			std::string const type = "_soak" + std::to_string(i) + "._tcp";
+
+			m_waiting++;
+			m_client.async_createServiceBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, type, "local", {},
+				[this](std::shared_ptr<Avahi::ServiceBrowser> const &browser, Glib::Error const &error)
+				{
+					m_waiting--;
+					if (!created(error))
+						return;
+					browser->on_itemNewView.connect([this](Avahi::ServiceBrowser::ItemView const &/*item*/)
+					{
+						m_events++;
+					});
+					m_browsers.push_back(browser);
+				});
+
+			m_waiting++;
+			m_client.async_createServiceResolver(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, "soak", type, "local",
+				AVAHI_PROTO_UNSPEC, {},
+				[this](std::shared_ptr<Avahi::ServiceResolver> const &resolver, Glib::Error const &error)
+				{
+					m_waiting--;
+					if (!created(error))
+						return;
+					resolver->on_foundView.connect([this](Avahi::ServiceResolver::FoundView const &/*found*/)
+					{
+						m_events++;
+					});
+					m_resolvers.push_back(resolver);
+				});
+
+			m_waiting++;
+			m_client.async_createEntryGroup(
+				[this, type](std::shared_ptr<Avahi::EntryGroup> const &group, Glib::Error const &error)
+				{
+					if (!created(error))
+					{
+						m_waiting--;
+						return;
+					}
+					m_groups.push_back(group);
+
+					Avahi::EntryGroup::ServiceDefinition service{AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, {},
+						"soak", type, "local", "", 80, {}, {}};
+					group->async_publish({service}, [this](Glib::Error const &error)
+					{
+						m_waiting--;
+						if (created(error))
+							m_events++;
+					});
+				});
+		}
+	}
+
+	void destroy()
+	{
+		m_browsers.clear();
+		m_resolvers.clear();
+		m_groups.clear();
+	}
+
+	/** Counts \a error (expected while the daemon is restarted). */
+	bool created(Glib::Error const &error)
+	{
+		if (!error)
+			return true;
+		m_failures++;
+		return false;
+	}
+
+private:  // members
+	MockServer &m_mock;
+	Avahi::Client &m_client;
+	std::size_t m_objects;
+	std::size_t m_restartEvery;
+
+	bool m_connected;
+	/** Number of outstanding creations/publishings. */
+	std::size_t m_waiting;
+	/** Number of events received in the current cycle. */
+	std::size_t m_events;
+	/** Total number of failed creations/publishings. */
+	std::size_t m_failures;
+	/** Number of cycles after which daemon side objects or calls were left. */
+	std::size_t m_stuck;
+
+	std::vector<std::shared_ptr<Avahi::ServiceBrowser>> m_browsers;
+	std::vector<std::shared_ptr<Avahi::ServiceResolver>> m_resolvers;
+	std::vector<std::shared_ptr<Avahi::EntryGroup>> m_groups;
+};
+
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+	std::size_t const cycles = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000;
+	std::size_t const objects = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 50;
+	std::size_t const restartEvery = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 25;
+	std::size_t const reportEvery = 10;
+
+	Gio::init();
+
+	/* private bus; the Client connects to the "system" bus */
+	auto *bus = ::g_test_dbus_new(G_TEST_DBUS_NONE);
+	::g_test_dbus_up(bus);
+	std::string const address = ::g_test_dbus_get_bus_address(bus);
+	::g_setenv("DBUS_SYSTEM_BUS_ADDRESS", address.c_str(), TRUE);
+
+	int result = EXIT_SUCCESS;
+	{
+		MockServer mock(address);
+		mock.acquire();
+
+		Avahi::Client client;
+		client.setPersistentSession(true);
+
+		Soak soak(mock, client, objects, restartEvery);
+		if (soak.connect())
+		{
+			std::vector<Clock::duration> durations;
+
+			Soak::header();
+			for (std::size_t i = 0; i < cycles; i++)
+			{
+				durations.push_back(soak.cycle(i));
+				if (durations.size() == reportEvery || i + 1 == cycles)
+				{
+					soak.report(i + 1, durations);
+					durations.clear();
+				}
+			}
+		}
+		else
+		{
+			std::fprintf(stderr, "Cannot connect to mock Avahi daemon\n");
+			result = EXIT_FAILURE;
+		}
+	}
+
+	::g_test_dbus_down(bus);
+	::g_object_unref(bus);
+	return result;
+}
@@ -5,13 +5,11 @@
  *      Author: eggers
  */
 
-#include <cstring>                   /* ::strcmp() */
 #include <iostream>
 #include <memory>
 
 #include <avahi-common/address.h>    /* AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC */
 #include <avahi-common/defs.h>       /* AVAHI_DNS_CLASS_IN, AVAHI_DNS_TYPE_A */
-#include <avahi-core/rr.h>
 #include <boost/io/ios_state.hpp>
 #include <giomm/init.h>
 #include <glibmm/error.h>
@@ -20,6 +18,7 @@
 
 #include "../Client.hpp"
 #include "../RecordBrowser.hpp"
+#include "../RecordDecoder.hpp"
 
 using namespace Avahi;
 
@@ -72,25 +71,15 @@ static void on_connected()
 	::avahi_reverse_lookup_name(::avahi_address_parse(address, AVAHI_PROTO_UNSPEC, &avahiAddress), addressReverse, sizeof(addressReverse));
 #endif
 
-	auto checkServicePtr = [service]
-		(Interface interface, Protocol protocol, RecordName const &name,
-		RecordClass clazz, RecordType const &type, RecordData const &rdata,
-		::AvahiLookupResultFlags flags)
+	auto checkServicePtr = [service](bool isNew, RecordBrowser::ItemView const &item, NameView const &ptr)
 		{
-			::AvahiRecord *r = ::avahi_record_new_full(
-				name.c_str(),
-				clazz,
-				type,
-				0);
-
-			::avahi_rdata_parse(r, rdata.data(), rdata.size());
-			if (::strcmp(r->data.ptr.name, service) == 0)
+			if (isNew && ptr.equals(service))
 			{
-				std::cout << "PTR::name = \"" << r->data.ptr.name << "\"\n";
-				do_reconfirm(interface, protocol, name, clazz, type, rdata, flags);
+				std::cout << "PTR::name = \"" << ptr.toString() << "\"\n";
+				do_reconfirm(item.interface, item.protocol,
+					RecordName(item.name.begin(), item.name.end()),
+					item.clazz, item.type, item.rdata.toVector(), item.flags);
 			}
-
-			::avahi_record_unref(r);
 		};
 
 	/* 1. Service sub type */
@@ -104,7 +93,7 @@ static void on_connected()
 				return;
 			}
 			connectCommonHandlers(browser);
-			browser->on_itemNew.connect(checkServicePtr);
+			browser->on_nameView.connect(checkServicePtr);
 		});
 
 	avahiClient->async_createRecordBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC,
@@ -117,7 +106,7 @@ static void on_connected()
 				return;
 			}
 			connectCommonHandlers(browser);
-			browser->on_itemNew.connect(checkServicePtr);
+			browser->on_nameView.connect(checkServicePtr);
 		});
 
 #if 0
@@ -133,36 +122,20 @@ static void on_connected()
 				return;
 			}
 			connectCommonHandlers(browser);
-			browser->on_itemNew.connect(checkServicePtr);
+			browser->on_nameView.connect(checkServicePtr);
 		});
 #endif
 
-	/* 3. Service TXT record */
-	avahiClient->async_createRecordBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC,
-		service, AVAHI_DNS_CLASS_IN, AVAHI_DNS_TYPE_TXT, {},
-		[](std::shared_ptr<RecordBrowser> const &browser, Glib::Error const &error)
-		{
-			if (error)
-			{
-				std::cerr << "Cannot create record browser for service TXT record:" << error.what() << '\n';
-				return;
-			}
-			connectCommonHandlers(browser);
-			browser->on_itemNew.connect(sigc::ptr_fun(do_reconfirm));
-		});
-
-	/* 4. Service SRV record */
-	avahiClient->async_createRecordBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC,
-		service, AVAHI_DNS_CLASS_IN, AVAHI_DNS_TYPE_SRV, {},
-		[](std::shared_ptr<RecordBrowser> const &browser, Glib::Error const &error)
+	/* 3. Service type PTR, TXT and SRV records */
+	avahiClient->async_reconfirmService("myService", "_myServiceType._tcp", "local",
+		[](std::size_t records, Glib::Error const &error)
 		{
 			if (error)
 			{
-				std::cerr << "Cannot create record browser for service SRV record:" << error.what() << '\n';
+				std::cerr << "Error on reconfirmation of service: " << error.what() << '\n';
 				return;
 			}
-			connectCommonHandlers(browser);
-			browser->on_itemNew.connect(sigc::ptr_fun(do_reconfirm));
+			std::cout << "Reconfirmed " << records << " service records\n";
 		});
 
 #if 0
@@ -0,0 +1,147 @@
+/**
+ *  \file
+ *  \brief Declarative filter for browse and resolve results
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "../BrowseFilter.hpp"         // IWYU pragma: associated
+
+namespace Avahi {
+
+namespace {
+
+int toLower(int c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+/** Matches \a text against \a pattern ('*' and '?'), without recursion
+ *  (backtracks to the last '*' only). */
+bool globMatch(StringView pattern, StringView text)
+{
+	std::size_t p = 0, t = 0;
+	std::size_t star = StringView::npos, resume = 0;
+
+	while (t < text.size())
+	{
+		if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+		{
+			p++;
+			t++;
+		}
+		else if (p < pattern.size() && pattern[p] == '*')
+		{
+			star = p++;
+			resume = t;
+		}
+		else if (star != StringView::npos)
+		{
+			p = star + 1;
+			t = ++resume;
+		}
+		else
+			return false;
+	}
+
+	while (p < pattern.size() && pattern[p] == '*')
+		p++;
+	return p == pattern.size();
+}
+
+}  // namespace
+
+BrowseFilter &BrowseFilter::interfaces(std::vector<Interface> interfaces)
+{
+	m_interfaces = std::move(interfaces);
+	m_empty = false;
+	return *this;
+}
+
+BrowseFilter &BrowseFilter::protocols(std::vector<Protocol> protocols)
+{
+	m_protocols = std::move(protocols);
+	m_empty = false;
+	return *this;
+}
+
+BrowseFilter &BrowseFilter::namePrefix(std::string prefix)
+{
+	m_namePrefix = std::move(prefix);
+	m_empty = false;
+	return *this;
+}
+
+BrowseFilter &BrowseFilter::nameGlob(std::string pattern)
+{
+	m_nameGlob = std::move(pattern);
+	m_hasNameGlob = true;
+	m_empty = false;
+	return *this;
+}
+
+BrowseFilter &BrowseFilter::txtHasKey(std::string key)
+{
+	m_txt.push_back(TxtCondition{std::move(key), {}, false});
+	m_empty = false;
+	return *this;
+}
+
+BrowseFilter &BrowseFilter::txtEquals(std::string key, std::string value)
+{
+	m_txt.push_back(TxtCondition{std::move(key), std::move(value), true});
+	m_empty = false;
+	return *this;
+}
+
+bool BrowseFilter::matchItem(Interface interface, Protocol protocol, StringView name) const
+{
+	if (m_empty)
+		return true;
+
+	if (!m_interfaces.empty() && std::find(m_interfaces.begin(), m_interfaces.end(), interface) == m_interfaces.end())
+		return false;
+	if (!m_protocols.empty() && std::find(m_protocols.begin(), m_protocols.end(), protocol) == m_protocols.end())
+		return false;
+	if (name.compare(0, m_namePrefix.size(), m_namePrefix) != 0)
+		return false;
+	if (m_hasNameGlob && !globMatch(m_nameGlob, name))
+		return false;
+	return true;
+}
+
+bool BrowseFilter::TxtCondition::matchKey(ByteView string) const
+{
+	if (string.empty())
+		return false;
+
+	auto const *data = reinterpret_cast<char const *>(string.data());
+	auto const *separator = static_cast<char const *>(std::memchr(data, '=', string.size()));
+	std::size_t const keySize = separator ? static_cast<std::size_t>(separator - data) : string.size();
+
+	if (keySize != key.size())
+		return false;
+	for (std::size_t i = 0; i < keySize; i++)
+	{
+		if (toLower(static_cast<unsigned char>(data[i])) != toLower(static_cast<unsigned char>(key[i])))
+			return false;
+	}
+	return true;
+}
+
+bool BrowseFilter::TxtCondition::matchValue(ByteView string) const
+{
+	if (!hasValue)
+		return true;
+	if (string.size() <= key.size() || string[key.size()] != '=')
+		return false;  // no value
+
+	auto const *data = reinterpret_cast<char const *>(string.data());
+	return StringView(data + key.size() + 1, string.size() - key.size() - 1) == value;
+}
+
+} /* namespace Avahi */
@@ -5,35 +5,101 @@
  *  \copyright 2022 ARRI Lighting Stephanskirchen
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
 #include <tuple>
 #include <typeinfo>                    // std::bad_cast
+#include <vector>
 
+#include <giomm/cancellable.h>
 #include <giomm/dbusconnection.h>
 #include <giomm/dbuswatchname.h>
+#include <giomm/slot_async.h>         // Gio::SignalProxy_async_callback()
 #include <glibmm/error.h>
+#include <glibmm/main.h>
 #include <glibmm/refptr.h>
 #include <glibmm/ustring.h>
 #include <glibmm/variant.h>
 #include <glibmm/variantdbusstring.h>
 
 #include <avahi-common/dbus.h>
-#include <glib.h>                      // G_MAXINT, G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED
+#include <gio/gio.h>                   // g_task_had_error(), g_task_new()
+#include <glib.h>                      // G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED
 
+#include "../BrowseFilter.hpp"
 #include "../EntryGroup.hpp"
 #include "../RecordBrowser.hpp"
 #include "../ServiceBrowser.hpp"
 #include "../ServiceResolver.hpp"
 #include "../Client.hpp"               // IWYU pragma: associated
+#include "SharedBrowser.hpp"
 
 namespace Gio { class AsyncResult; }
 
 namespace Avahi {
 
+struct Client::CallQueue
+{
+	/** Call waiting for a free slot in the call window. */
+	struct Call
+	{
+		Operation operation;
+		/** Connection at the time of queuing (the completion handlers finish
+		 *  the call on their own copy). */
+		Glib::RefPtr<Gio::DBus::Connection> connection;
+		Glib::ustring objectPath;
+		char const *interfaceName;
+		char const *methodName;
+		Glib::VariantContainerBase parameters;
+		Gio::SlotAsyncReady slot;
+		Glib::RefPtr<Gio::Cancellable> cancellable;
+		/** Handler on #cancellable (0 if none). */
+		gulong cancelHandler;
+		std::int64_t queued;
+		/** Monotonic time at which the operation's timeout expires (0 for
+		 *  infinite timeout). */
+		std::int64_t deadline;
+	};
+
+	/** FIFO per daemon side object (keyed by object path). */
+	std::unordered_map<std::string, std::deque<Call>> objects;
+	/** Round-robin order of the objects in #objects. */
+	std::deque<std::string> order;
+	std::size_t size = 0;
+	std::uint64_t maxQueued = 0;
+	std::uint64_t deferred = 0;
+	Histogram waitTime;
+};
+
 Client::Client()
 : m_connection()
 , m_stateChanged(0)
+, m_persistentSession(false)
+, m_defaultTimeout(DefaultTimeout)
+, m_timeouts()
+, m_dispatchObject(nullptr)
+, m_dispatchSignal(Signal::Other)
+, m_browserLinger(0)
+, m_bootstrap(false)
+, m_bootstrapPending(0)
+, m_sessionGeneration(0)
+, m_callWindow(0)
+, m_callsInFlight(0)
+, m_lifetime(std::make_shared<Client *>(this))
+, m_callTimerDeadline(0)
+, m_entryGroupPoolSize(0)
+, m_releaseBatchSize(32)
+, m_releaseMaxInFlight(128)
+, m_releasesInFlight(0)
 {
+	for (auto &queue : m_callQueues)
+		queue = std::make_unique<CallQueue>();
+
 	m_watchHandle = Gio::DBus::watch_name(
 		Gio::DBus::BusType::BUS_TYPE_SYSTEM,
 		"org.freedesktop.Avahi",
@@ -56,24 +122,84 @@ Client::Client()
 					using Error = Glib::ustring;
 					using Params = std::tuple<State, Error>;
 
+					auto &metrics = m_signalMetrics[static_cast<std::size_t>(Signal::ServerStateChanged)];
+					auto const started = ::g_get_monotonic_time();
+					metrics.received++;
+
 					try
 					{
 						auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
 						const auto &[state, error] = params.get();
+						auto const serverState = static_cast<AvahiServerState>(state);
+
+						m_serverState = serverState;
+						if (serverState == AVAHI_SERVER_REGISTERING || serverState == AVAHI_SERVER_COLLISION)
+							m_hostName.reset();  // host name is being changed
+						else if (serverState == AVAHI_SERVER_RUNNING && m_bootstrap && !m_hostName && !m_bootstrapPending)
+							queryHostName();
 
-						on_serverStateChanged(static_cast<AvahiServerState>(state), error);
+						on_serverStateChanged(serverState, error);
 					}
 					catch (std::bad_cast const &e)
 					{
+						metrics.parseErrors++;
 						on_serverStateChanged(AVAHI_SERVER_FAILURE, "Cannot parse \"StateChanged\" parameters");
 						return;
 					}
+					metrics.handlerTime.record(::g_get_monotonic_time() - started);
 				},
 				AVAHI_DBUS_NAME,
 				AVAHI_DBUS_INTERFACE_SERVER,
 				"StateChanged",
 				"/");
 
+			/* Subscribe only once per interface (without member and object
+			 * path filter); the signals are routed to the individual proxy
+			 * objects by dispatchSignal(). */
+			for (char const *interfaceName : {AVAHI_DBUS_INTERFACE_ENTRY_GROUP,
+			                                  AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
+			                                  AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
+			                                  AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER})
+			{
+				/* C API, as giomm would copy sender, object path, interface
+				 * and signal name into Glib::ustrings for every signal. */
+				m_objectSignals.push_back(::g_dbus_connection_signal_subscribe(
+					connection->gobj(), AVAHI_DBUS_NAME, interfaceName, nullptr, nullptr, nullptr,
+					G_DBUS_SIGNAL_FLAGS_NONE,
+					[](GDBusConnection */*connection*/, gchar const */*senderName*/,
+					   gchar const *objectPath, gchar const *interfaceName,
+					   gchar const *signalName, GVariant *parameters, gpointer userData)
+					{
+						static_cast<Client *>(userData)->dispatchSignal(objectPath, interfaceName, signalName,
+							Glib::VariantContainerBase(parameters, true));
+					},
+					this, nullptr));
+			}
+
+			if (m_bootstrap)
+				bootstrap();
+
+			if (m_persistentSession)
+			{
+				for (auto const &[object, slot] : m_sessions)
+					slot(true);
+			}
+
+			/* requests which have been issued before the daemon appeared */
+			auto deferred = std::move(m_deferred);
+			m_deferred.clear();
+			m_deferredCancel.disconnect();
+			for (auto const &request : deferred)
+			{
+				if (request.cancelHandler)
+					request.cancellable->disconnect(request.cancelHandler);
+
+				if (request.cancellable->is_cancelled())
+					request.fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+				else
+					request.start();
+			}
+
 			on_connected();
 		},
 		/* name_vanished_slot */
@@ -85,11 +211,89 @@ Client::Client()
 
 			connection->signal_unsubscribe(m_stateChanged);
 			m_stateChanged = 0;
+
+			for (auto subscription : m_objectSignals)
+				connection->signal_unsubscribe(subscription);
+			m_objectSignals.clear();
+
+			/* The daemon side objects are gone.  A restarted daemon may
+			 * reuse their object paths, so detach all proxy objects and
+			 * drop the queued "Free" calls. */
+			m_objects.clear();
+			m_releases.clear();
+			m_releaseFlush.disconnect();
+			drainCalls(/*all*/true);
+			if (!m_persistentSession)
+				m_entryGroupPool.clear();  // would become inoperative
+			m_serverState.reset();
+			m_hostName.reset();
+			m_bootstrapPending = 0;
+			m_sessionGeneration++;
+			for (auto const &[object, slot] : m_sessions)
+				slot(false);
 		});
 }
 
 Client::~Client()
 {
+	m_metricsExport.disconnect();
+	m_deferredCancel.disconnect();
+	for (auto const &request : m_deferred)
+	{
+		if (request.cancelHandler)
+			request.cancellable->disconnect(request.cancelHandler);
+	}
+
+	/* queued calls are dropped */
+	m_callCancel.disconnect();
+	m_callTimer.disconnect();
+	for (auto const &queue : m_callQueues)
+	{
+		for (auto const &[objectPath, calls] : queue->objects)
+		{
+			for (auto const &call : calls)
+			{
+				if (call.cancelHandler)
+					call.cancellable->disconnect(call.cancelHandler);
+			}
+		}
+	}
+
+	/* These own browsers/entry groups, which queue their "Free" calls on
+	 * destruction. */
+	m_reconfirms.clear();
+	m_lingeringBrowsers.clear();
+	m_entryGroupPool.clear();
+
+	/* There's no main loop iteration for this object anymore, so send the
+	 * remaining "Free" calls at once (bypassing call(), as the replies may
+	 * arrive after destruction). */
+	m_releaseFlush.disconnect();
+	if (m_connection)
+	{
+		for (auto const &release : m_releases)
+		{
+			m_connection->call(
+				release.objectPath, release.interfaceName, "Free",
+				Glib::VariantContainerBase(),
+				[](Glib::RefPtr<Gio::AsyncResult> &/*result*/) {},
+				/*cancellable*/ {},
+				/*bus_name*/ AVAHI_DBUS_NAME,
+				/*timeout_msec*/getTimeout(Operation::Free),
+				Gio::DBus::CALL_FLAGS_NO_AUTO_START
+			);
+		}
+
+		/* The subscriptions refer to this object (the daemon side objects
+		 * may still emit signals until the "Free" calls have arrived). */
+		m_connection->signal_unsubscribe(m_stateChanged);
+		m_stateChanged = 0;
+		for (auto subscription : m_objectSignals)
+			m_connection->signal_unsubscribe(subscription);
+		m_objectSignals.clear();
+	}
+	m_releases.clear();
+
 	Gio::DBus::unwatch_name(m_watchHandle);
 }
 
@@ -98,10 +302,840 @@ Glib::RefPtr<Gio::DBus::Connection> const &Client::getConnection()
 	return m_connection;
 }
 
-void Client::async_getServerState(SlotGetServerState const &completion)
+void Client::setDefaultTimeout(int timeout_msec)
+{
+	m_defaultTimeout = timeout_msec;
+}
+
+void Client::setTimeout(Operation operation, int timeout_msec)
+{
+	m_timeouts[static_cast<std::size_t>(operation)] = timeout_msec;
+}
+
+int Client::getTimeout(Operation operation) const
+{
+	auto const timeout = m_timeouts[static_cast<std::size_t>(operation)];
+
+	return (timeout > 0) ? timeout : m_defaultTimeout;
+}
+
+void Client::setPersistentSession(bool enable)
+{
+	m_persistentSession = enable;
+}
+
+void Client::setBrowserLinger(unsigned int linger_msec)
+{
+	m_browserLinger = linger_msec;
+}
+
+void Client::setReleaseBatching(std::size_t batchSize, std::size_t maxInFlight)
+{
+	m_releaseBatchSize = std::max<std::size_t>(batchSize, 1);
+	m_releaseMaxInFlight = std::max<std::size_t>(maxInFlight, 1);
+	scheduleReleases();
+}
+
+void Client::setBootstrap(bool enable)
+{
+	bool const start = enable && !m_bootstrap && m_connection;
+
+	m_bootstrap = enable;
+	if (start)
+		bootstrap();
+}
+
+void Client::releaseAll()
+{
+	m_entryGroupPool.clear();
+	if (m_connection)
+	{
+		for (auto const &[objectPath, route] : m_objects)
+			m_releases.push_back(Release{route->objectPath, route->interfaceName});
+	}
+	m_objects.clear();
+
+	/* Same as vanishing of the daemon, but without re-creation in persistent
+	 * session mode.  The handlers may (un-)register sessions. */
+	auto sessions = std::move(m_sessions);
+	m_sessions.clear();
+	for (auto const &[object, slot] : sessions)
+		slot(false);
+
+	scheduleReleases();
+}
+
+Client::Metrics Client::getMetrics() const
+{
+	Metrics metrics;
+
+	for (std::size_t i = 0; i < metrics.calls.size(); i++)
+	{
+		auto const &counters = m_callMetrics[i];
+		metrics.calls[i] = CallMetrics{counters.calls, counters.failures, counters.pending, counters.latency.snapshot()};
+	}
+
+	for (std::size_t i = 0; i < metrics.signals.size(); i++)
+	{
+		auto const &counters = m_signalMetrics[i];
+		metrics.signals[i] = SignalMetrics{counters.received, counters.unrouted, counters.parseErrors, counters.handlerTime.snapshot()};
+	}
+
+	metrics.objects.reserve(m_objects.size());
+	for (std::size_t i = 0; i < metrics.queues.size(); i++)
+	{
+		auto const &queue = *m_callQueues[i];
+		metrics.queues[i] = QueueMetrics{queue.size, queue.maxQueued, queue.deferred, queue.waitTime.snapshot()};
+	}
+
+	for (auto const &[objectPath, route] : m_objects)
+		metrics.objects.push_back(ObjectMetrics{route->objectPath, route->counters.interfaceName,
+		                                        route->counters.signals, route->counters.parseErrors});
+
+	return metrics;
+}
+
+void Client::resetMetrics()
+{
+	for (auto &counters : m_callMetrics)
+	{
+		counters.calls = 0;
+		counters.failures = 0;
+		counters.latency.reset();
+	}
+
+	for (auto &queue : m_callQueues)
+	{
+		queue->maxQueued = queue->size;
+		queue->deferred = 0;
+		queue->waitTime.reset();
+	}
+
+	for (auto &counters : m_signalMetrics)
+	{
+		counters.received = 0;
+		counters.unrouted = 0;
+		counters.parseErrors = 0;
+		counters.handlerTime.reset();
+	}
+
+	for (auto &[objectPath, route] : m_objects)
+	{
+		route->counters.signals = 0;
+		route->counters.parseErrors = 0;
+	}
+}
+
+void Client::setMetricsExport(unsigned int interval_msec, SlotMetrics const &slot)
+{
+	m_metricsExport.disconnect();
+	if (!interval_msec || slot.empty())
+		return;
+
+	m_metricsExport = Glib::MainContext::get_thread_default()->signal_timeout().connect([this, slot]
+	{
+		slot(getMetrics());
+		return true;  // continue
+	}, interval_msec);
+}
+
+char const *Client::getOperationName(Operation operation)
+{
+	switch (operation)
+	{
+		case Operation::GetState:               return "GetState";
+		case Operation::GetHostName:            return "GetHostName";
+		case Operation::SetHostName:            return "SetHostName";
+		case Operation::ReconfirmRecord:        return "ReconfirmRecord";
+		case Operation::EntryGroupNew:          return "EntryGroupNew";
+		case Operation::RecordBrowserPrepare:   return "RecordBrowserPrepare";
+		case Operation::ServiceBrowserPrepare:  return "ServiceBrowserPrepare";
+		case Operation::ServiceResolverPrepare: return "ServiceResolverPrepare";
+		case Operation::Start:                  return "Start";
+		case Operation::Free:                   return "Free";
+		case Operation::AddService:             return "AddService";
+		case Operation::AddServiceSubtype:      return "AddServiceSubtype";
+		case Operation::Commit:                 return "Commit";
+		case Operation::Reset:                  return "Reset";
+		case Operation::UpdateServiceTxt:       return "UpdateServiceTxt";
+		case Operation::Count:                  break;
+	}
+	return "";
+}
+
+char const *Client::getSignalName(Signal signal)
+{
+	switch (signal)
+	{
+		case Signal::ServerStateChanged:     return "Server.StateChanged";
+		case Signal::EntryGroupStateChanged: return "EntryGroup.StateChanged";
+		case Signal::ItemNew:                return "ItemNew";
+		case Signal::ItemRemove:             return "ItemRemove";
+		case Signal::Found:                  return "Found";
+		case Signal::Failure:                return "Failure";
+		case Signal::AllForNow:              return "AllForNow";
+		case Signal::CacheExhausted:         return "CacheExhausted";
+		case Signal::Other:                  return "Other";
+		case Signal::Count:                  break;
+	}
+	return "";
+}
+
+char const *Client::getPriorityName(Priority priority)
+{
+	switch (priority)
+	{
+		case Priority::Publish:   return "Publish";
+		case Priority::Resolve:   return "Resolve";
+		case Priority::Reconfirm: return "Reconfirm";
+		case Priority::Browse:    return "Browse";
+		case Priority::Count:     break;
+	}
+	return "";
+}
+
+void Client::setEntryGroupPool(std::size_t maxSize)
+{
+	m_entryGroupPoolSize = maxSize;
+	if (m_entryGroupPool.size() > maxSize)
+		m_entryGroupPool.resize(maxSize);
+}
+
+void Client::recycleEntryGroup(std::shared_ptr<EntryGroup> group)
+{
+	if (!group || group.use_count() > 1 || group->m_objectPath.empty() ||
+	    m_entryGroupPool.size() >= m_entryGroupPoolSize)
+		return;  // dropped (freed)
+
+	group->on_errorLog.clear();
+	group->on_stateChanged.clear();
+	/* D-Bus preserves the message order, so the group can be handed out
+	 * again before the reply has been received. */
+	group->async_reset([](Glib::Error const &/*error*/) {});
+	m_entryGroupPool.push_back(std::move(group));
+}
+
+void Client::setCallWindow(std::size_t maxInFlight)
+{
+	m_callWindow = maxInFlight;
+	drainCalls();
+}
+
+Client::Priority Client::getPriority(Operation operation, char const *interfaceName)
+{
+	switch (operation)
+	{
+		case Operation::ServiceResolverPrepare:
+			return Priority::Resolve;
+		case Operation::ReconfirmRecord:
+			return Priority::Reconfirm;
+		case Operation::RecordBrowserPrepare:
+		case Operation::ServiceBrowserPrepare:
+			return Priority::Browse;
+		case Operation::Start:
+		case Operation::Free:
+			/* depends on the object */
+			if (std::strcmp(interfaceName, AVAHI_DBUS_INTERFACE_ENTRY_GROUP) == 0)
+				return Priority::Publish;
+			if (std::strcmp(interfaceName, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER) == 0)
+				return Priority::Resolve;
+			return Priority::Browse;
+		default:
+			return Priority::Publish;
+	}
+}
+
+void Client::call(Operation operation, Glib::ustring const &objectPath,
+        char const *interfaceName, char const *methodName,
+        Glib::VariantContainerBase const &parameters,
+        Gio::SlotAsyncReady const &slot,
+        Glib::RefPtr<Gio::Cancellable> const &cancellable)
+{
+	/* An already cancelled call is sent at once (GDBus completes it with
+	 * G_IO_ERROR_CANCELLED without sending it). */
+	if (!m_callWindow || m_callsInFlight < m_callWindow || (cancellable && cancellable->is_cancelled()))
+	{
+		sendCall(operation, m_connection, objectPath, interfaceName, methodName, parameters, slot, cancellable);
+		return;
+	}
+
+	auto const now = ::g_get_monotonic_time();
+	auto const timeout = getTimeout(operation);
+	auto const deadline = (timeout == InfiniteTimeout) ? 0 : now + static_cast<std::int64_t>(timeout) * 1000;
+
+	auto &queue = *m_callQueues[static_cast<std::size_t>(getPriority(operation, interfaceName))];
+	auto [it, inserted] = queue.objects.try_emplace(objectPath.raw());
+
+	if (inserted)
+		queue.order.push_back(it->first);
+	it->second.push_back(CallQueue::Call{operation, m_connection, objectPath, interfaceName, methodName,
+	                                parameters, slot, cancellable, 0, now, deadline});
+	queue.size++;
+	queue.deferred++;
+	queue.maxQueued = std::max<std::uint64_t>(queue.maxQueued, queue.size);
+
+	if (cancellable)
+	{
+		/* a cancelled call leaves the queue (from an idle handler, as the
+		 * handler must not be disconnected from within cancel()) */
+		it->second.back().cancelHandler = cancellable->connect([this]
+		{
+			if (!m_callCancel.connected())
+				m_callCancel = Glib::MainContext::get_thread_default()->signal_idle().connect(
+					sigc::mem_fun(*this, &Client::onCallCancelled));
+		});
+	}
+	if (deadline)
+		scheduleCallTimer(deadline);
+}
+
+bool Client::onCallCancelled()
+{
+	/* release the connection without disconnecting the running handler */
+	m_callCancel = sigc::connection();
+	expireCalls();
+	return false;  // disconnect
+}
+
+bool Client::onCallTimer()
+{
+	m_callTimer = sigc::connection();
+	m_callTimerDeadline = 0;
+	expireCalls();
+	return false;  // disconnect (rescheduled by expireCalls())
+}
+
+void Client::scheduleCallTimer(std::int64_t deadline)
+{
+	if (m_callTimer.connected() && m_callTimerDeadline <= deadline)
+		return;
+
+	auto const remaining = std::max<std::int64_t>(0, deadline - ::g_get_monotonic_time());
+	m_callTimer.disconnect();
+	m_callTimerDeadline = deadline;
+	m_callTimer = Glib::MainContext::get_thread_default()->signal_timeout().connect(
+		sigc::mem_fun(*this, &Client::onCallTimer), static_cast<unsigned int>((remaining + 999) / 1000));
+}
+
+void Client::expireCalls()
+{
+	auto const now = ::g_get_monotonic_time();
+	std::vector<CallQueue::Call> cancelled;
+	std::vector<CallQueue::Call> expired;
+	std::int64_t next = 0;
+
+	for (auto &queuePtr : m_callQueues)
+	{
+		auto &queue = *queuePtr;
+		for (auto it = queue.objects.begin(); it != queue.objects.end(); )
+		{
+			auto &calls = it->second;
+			for (auto call = calls.begin(); call != calls.end(); )
+			{
+				if (call->cancellable && call->cancellable->is_cancelled())
+					cancelled.push_back(std::move(*call));
+				else if (call->deadline && call->deadline <= now)
+					expired.push_back(std::move(*call));
+				else
+				{
+					if (call->deadline && (!next || call->deadline < next))
+						next = call->deadline;
+					++call;
+					continue;
+				}
+				call = calls.erase(call);
+				queue.size--;
+			}
+
+			if (!calls.empty())
+			{
+				++it;
+				continue;
+			}
+			queue.order.erase(std::remove(queue.order.begin(), queue.order.end(), it->first), queue.order.end());
+			it = queue.objects.erase(it);
+		}
+	}
+
+	if (next)
+		scheduleCallTimer(next);
+
+	/* The completions may issue new calls.  Cancelled calls are sent at
+	 * once (completed by GDBus without sending them), calls which have
+	 * waited longer than their timeout are failed without sending them. */
+	for (auto const &call : cancelled)
+	{
+		call.cancellable->disconnect(call.cancelHandler);
+		sendCall(call.operation, call.connection, call.objectPath, call.interfaceName,
+		         call.methodName, call.parameters, call.slot, call.cancellable);
+	}
+	for (auto const &call : expired)
+	{
+		if (call.cancelHandler)
+			call.cancellable->disconnect(call.cancelHandler);
+		failCall(call.operation, call.connection, call.slot);
+	}
+}
+
+void Client::failCall(Operation operation, Glib::RefPtr<Gio::DBus::Connection> const &connection,
+        Gio::SlotAsyncReady const &slot)
+{
+	auto &metrics = m_callMetrics[static_cast<std::size_t>(operation)];
+
+	metrics.calls++;
+	metrics.failures++;
+
+	/* Completed like a timed out GDBus call (the completion's call_finish()
+	 * only checks the source object and propagates the error).  GTask
+	 * invokes the callback from the main loop, not from within here. */
+	auto *task = ::g_task_new(connection->gobj(), nullptr, &Gio::SignalProxy_async_callback, new Gio::SlotAsyncReady(slot));
+	::g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "Timeout was reached");
+	::g_object_unref(task);
+}
+
+void Client::drainCalls(bool all)
+{
+	for (auto &queuePtr : m_callQueues)
+	{
+		auto &queue = *queuePtr;
+		while (queue.size && (all || !m_callWindow || m_callsInFlight < m_callWindow))
+		{
+			/* round-robin between the objects, FIFO per object */
+			auto const objectPath = std::move(queue.order.front());
+			queue.order.pop_front();
+
+			auto it = queue.objects.find(objectPath);
+			auto queued = std::move(it->second.front());
+			it->second.pop_front();
+			if (it->second.empty())
+				queue.objects.erase(it);
+			else
+				queue.order.push_back(objectPath);
+			queue.size--;
+
+			auto const now = ::g_get_monotonic_time();
+			queue.waitTime.record(now - queued.queued);
+			if (queued.cancelHandler)
+				queued.cancellable->disconnect(queued.cancelHandler);
+
+			/* the time spent in the queue counts towards the timeout */
+			auto timeout = getTimeout(queued.operation);
+			if (queued.deadline)
+				timeout = static_cast<int>(std::max<std::int64_t>(1, (queued.deadline - now) / 1000));
+
+			sendCall(queued.operation, queued.connection, queued.objectPath, queued.interfaceName,
+			         queued.methodName, queued.parameters, queued.slot, queued.cancellable, timeout);
+		}
+		if (queue.size)
+			return;  // window is full
+	}
+}
+
+void Client::sendCall(Operation operation, Glib::RefPtr<Gio::DBus::Connection> const &connection,
+        Glib::ustring const &objectPath,
+        char const *interfaceName, char const *methodName,
+        Glib::VariantContainerBase const &parameters,
+        Gio::SlotAsyncReady const &slot,
+        Glib::RefPtr<Gio::Cancellable> const &cancellable,
+        int timeout_msec)
+{
+	auto &metrics = m_callMetrics[static_cast<std::size_t>(operation)];
+	auto const started = ::g_get_monotonic_time();
+
+	metrics.calls++;
+	metrics.pending++;
+	m_callsInFlight++;
+
+	connection->call(
+		objectPath, interfaceName, methodName,
+		parameters,
+		[weak = std::weak_ptr<Client *>(m_lifetime), operation, started, slot](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			/* the completion is invoked even after destruction of the
+			 * Client (e.g. for "Free" calls sent by ~Client) */
+			if (auto lifetime = weak.lock())
+			{
+				auto *self = *lifetime;
+
+				self->m_callsInFlight--;
+				self->completeCall(operation, started, result);
+				self->drainCalls();
+			}
+			slot(result);
+		},
+		cancellable,
+		/*bus_name*/ AVAHI_DBUS_NAME,
+		/*timeout_msec*/timeout_msec ? timeout_msec : getTimeout(operation),
+		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+	);
+}
+
+void Client::completeCall(Operation operation, std::int64_t started, Glib::RefPtr<Gio::AsyncResult> const &result)
+{
+	auto &metrics = m_callMetrics[static_cast<std::size_t>(operation)];
+
+	metrics.pending--;
+	metrics.latency.record(::g_get_monotonic_time() - started);
+
+	/* GDBus completes its calls via GTask, so the result can be checked
+	 * without consuming it. */
+	auto *asyncResult = result ? result->gobj() : nullptr;
+	if (asyncResult && G_IS_TASK(asyncResult) && ::g_task_had_error(G_TASK(asyncResult)))
+		metrics.failures++;
+}
+
+void Client::registerObject(Glib::ustring const &objectPath, char const *interfaceName, SlotSignal const &slot)
+{
+	auto route = std::make_unique<Route>(Route{objectPath.raw(), interfaceName, slot, {}});
+	std::string_view const key = route->objectPath;
+
+	route->counters.interfaceName = interfaceName;
+
+	m_objects.erase(key);
+	m_objects.emplace(key, std::move(route));
+}
+
+void Client::unregisterObject(Glib::ustring const &objectPath)
+{
+	m_objects.erase(std::string_view(objectPath.raw()));
+}
+
+void Client::releaseObject(Glib::ustring const &objectPath, char const *interfaceName)
+{
+	unregisterObject(objectPath);
+	if (!m_connection)
+		return;  // daemon side object is already gone
+
+	m_releases.push_back(Release{objectPath.raw(), interfaceName});
+	scheduleReleases();
+}
+
+void Client::scheduleReleases()
+{
+	if (m_releases.empty() || m_releaseFlush.connected() || m_releasesInFlight >= m_releaseMaxInFlight)
+		return;
+
+	m_releaseFlush = Glib::MainContext::get_thread_default()->signal_idle().connect(
+		sigc::mem_fun(*this, &Client::flushReleases));
+}
+
+bool Client::flushReleases()
+{
+	for (std::size_t sent = 0; sent < m_releaseBatchSize; sent++)
+	{
+		if (m_releases.empty() || m_releasesInFlight >= m_releaseMaxInFlight)
+			return false;  // disconnect, rescheduled by releaseObject() or on reply
+
+		auto const release = std::move(m_releases.front());
+		m_releases.pop_front();
+		m_releasesInFlight++;
+
+		call(
+			Operation::Free, release.objectPath, release.interfaceName, "Free",
+			Glib::VariantContainerBase(),
+			[weak = std::weak_ptr<Client *>(m_lifetime)](Glib::RefPtr<Gio::AsyncResult> &/*result*/)
+			{
+				/* we are not interested in the result, so there's no need
+				 * to run call_finish() */
+				if (auto lifetime = weak.lock())
+				{
+					(*lifetime)->m_releasesInFlight--;
+					(*lifetime)->scheduleReleases();
+				}
+			}
+		);
+	}
+
+	return !m_releases.empty();  // continue with next batch
+}
+
+void Client::bootstrap()
+{
+	/* Both calls are sent at once; the replies are dropped if the daemon
+	 * vanishes (or this object is destroyed) in the meantime. */
+	m_bootstrapPending = 2;
+
+	async_getServerState([weak = std::weak_ptr<Client *>(m_lifetime), generation = m_sessionGeneration](::AvahiServerState state, Glib::Error const &error)
+	{
+		auto lifetime = weak.lock();
+		if (!lifetime)
+			return;
+
+		auto *self = *lifetime;
+		if (generation != self->m_sessionGeneration)
+			return;  // daemon has vanished in the meantime
+
+		if (!error)
+			self->m_serverState = state;
+		if (self->m_bootstrapPending && !--self->m_bootstrapPending)
+			self->on_bootstrapped();
+	});
+	queryHostName();
+}
+
+void Client::queryHostName()
+{
+	async_getHostName([weak = std::weak_ptr<Client *>(m_lifetime), generation = m_sessionGeneration](Glib::ustring const &hostname, Glib::Error const &error)
+	{
+		auto lifetime = weak.lock();
+		if (!lifetime)
+			return;
+
+		auto *self = *lifetime;
+		if (generation != self->m_sessionGeneration)
+			return;  // daemon has vanished in the meantime
+
+		if (!error)
+			self->m_hostName = hostname.raw();
+		if (self->m_bootstrapPending && !--self->m_bootstrapPending)
+			self->on_bootstrapped();
+	});
+}
+
+void Client::whenConnected(Glib::RefPtr<Gio::Cancellable> const &cancellable,
+        sigc::slot<void()> const &start, sigc::slot<void(Glib::Error const &error)> const &fail)
+{
+	if (m_connection || !m_bootstrap)
+	{
+		start();
+		return;
+	}
+
+	m_deferred.push_back(Deferred{cancellable, 0, start, fail});
+
+	/* connecting invokes the handler at once if already cancelled */
+	m_deferred.back().cancelHandler = cancellable->connect([this]
+	{
+		/* completion must not be invoked from within cancel() */
+		if (!m_deferredCancel.connected())
+			m_deferredCancel = Glib::MainContext::get_thread_default()->signal_idle().connect(
+				sigc::mem_fun(*this, &Client::failCancelled));
+	});
+}
+
+bool Client::failCancelled()
+{
+	/* release the connection without disconnecting the running handler */
+	m_deferredCancel = sigc::connection();
+
+	auto it = std::stable_partition(m_deferred.begin(), m_deferred.end(), [](Deferred const &request)
+	{
+		return !request.cancellable->is_cancelled();
+	});
+	std::vector<Deferred> cancelled(std::make_move_iterator(it), std::make_move_iterator(m_deferred.end()));
+	m_deferred.erase(it, m_deferred.end());
+
+	/* the completions may issue new requests */
+	for (auto const &request : cancelled)
+	{
+		if (request.cancelHandler)
+			request.cancellable->disconnect(request.cancelHandler);
+		request.fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+	}
+	return false;  // disconnect
+}
+
+void Client::dispatchSignal(std::string_view objectPath, char const */*interfaceName*/,
+        std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	auto signal = Signal::Other;
+	if (signalName == "ItemNew")
+		signal = Signal::ItemNew;
+	else if (signalName == "ItemRemove")
+		signal = Signal::ItemRemove;
+	else if (signalName == "Found")
+		signal = Signal::Found;
+	else if (signalName == "StateChanged")
+		signal = Signal::EntryGroupStateChanged;
+	else if (signalName == "Failure")
+		signal = Signal::Failure;
+	else if (signalName == "AllForNow")
+		signal = Signal::AllForNow;
+	else if (signalName == "CacheExhausted")
+		signal = Signal::CacheExhausted;
+
+	auto &metrics = m_signalMetrics[static_cast<std::size_t>(signal)];
+	metrics.received++;
+
+	auto it = m_objects.find(objectPath);
+	if (it == m_objects.end())
+	{
+		metrics.unrouted++;
+		return;  // object has already been destroyed (or belongs to another client)
+	}
+
+	auto &counters = it->second->counters;
+	counters.signals++;
+
+	auto *const previousObject = std::exchange(m_dispatchObject, &counters);
+	auto const previousSignal = std::exchange(m_dispatchSignal, signal);
+	auto const started = ::g_get_monotonic_time();
+
+	/* Note: The handler may destroy the proxy object (and thereby invalidate
+	 * the iterator and the counters).  Neither must be used after this call. */
+	it->second->slot(signalName, parameters);
+
+	metrics.handlerTime.record(::g_get_monotonic_time() - started);
+	m_dispatchObject = previousObject;
+	m_dispatchSignal = previousSignal;
+}
+
+void Client::parseError()
+{
+	m_signalMetrics[static_cast<std::size_t>(m_dispatchSignal)].parseErrors++;
+	if (m_dispatchObject)
+		m_dispatchObject->parseErrors++;
+}
+
+void Client::registerSession(void const *object, SlotSession const &slot)
+{
+	m_sessions[object] = slot;
+}
+
+void Client::unregisterSession(void const *object)
+{
+	m_sessions.erase(object);
+}
+
+void Client::restoreObject(Operation operation, char const *methodName,
+        Glib::VariantContainerBase const &parameters, char const *interfaceName,
+        std::weak_ptr<void const> const &owner, SlotRebind const &rebind)
+{
+	auto const *serverInterface = (operation == Operation::EntryGroupNew) ? AVAHI_DBUS_INTERFACE_SERVER
+	                                                                       : AVAHI_DBUS_INTERFACE_SERVER2;
+
+	call(
+		operation, "/", serverInterface, methodName,
+		parameters,
+		[this, connection = m_connection, methodName, interfaceName, owner, rebind](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			try
+			{
+				auto response = connection->call_finish(result);
+
+				using ParamsType = std::tuple<Glib::DBusObjectPathString>;
+				auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
+				auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
+
+				if (owner.expired())
+				{
+					/* proxy object has been destroyed in the meantime */
+					releaseObject(objectPath, interfaceName);
+					return;
+				}
+
+				rebind(objectPath, Glib::Error());
+			}
+			catch (std::bad_cast const &e)
+			{
+				if (!owner.expired())
+					rebind("", Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, Glib::ustring("Client: Cannot parse response to \"") + methodName + "\""));
+			}
+			catch (Glib::Error const &e)
+			{
+				if (!owner.expired())
+					rebind("", e);
+			}
+		}
+	);
+}
+
+void Client::acquireBrowser(Operation operation, char const *methodName, char const *interfaceName,
+        Glib::VariantContainerBase const &parameters, Glib::RefPtr<Gio::Cancellable> const &cancellable,
+        SlotAcquireBrowser const &completion)
+{
+	auto *variant = const_cast<GVariant *>(parameters.gobj());
+	std::string key(interfaceName);
+	key.push_back('\0');
+	key.append(static_cast<char const *>(::g_variant_get_data(variant)), ::g_variant_get_size(variant));
+
+	auto &entry = m_browsers[key];
+	auto shared = entry.lock();
+	if (shared && !shared->isDefunct() && shared->isReplayable())
+	{
+		if (!shared->isPrepared())
+		{
+			/* "*Prepare" is still in progress */
+			shared->addWaiter(cancellable, completion);
+			return;
+		}
+
+		/* keep recording the items until the new handle has subscribed */
+		shared->addPendingHandle();
+		Glib::MainContext::get_thread_default()->signal_idle().connect([shared, cancellable, completion]
+		{
+			if (cancellable->is_cancelled())
+				completion({}, Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+			else
+				completion(shared, Glib::Error());
+			shared->removePendingHandle();
+			return false;  // disconnect
+		});
+		return;
+	}
+
+	shared = std::make_shared<SharedBrowser>(*this, key, operation, methodName, interfaceName, parameters);
+	entry = shared;
+	shared->addWaiter(cancellable, completion);
+
+	/* Not cancellable, as other requests may wait for this browser, too */
+	call(
+		operation, "/", AVAHI_DBUS_INTERFACE_SERVER2, methodName,
+		parameters,
+		[connection = m_connection, methodName, shared](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			Glib::Error error;
+
+			try
+			{
+				auto response = connection->call_finish(result);
+
+				try
+				{
+					using ParamsType = std::tuple<Glib::DBusObjectPathString>;
+					auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
+					auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
+
+					shared->bind(objectPath);
+				}
+				catch (std::bad_cast const &e)
+				{
+					error = Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, Glib::ustring("Client: Cannot parse response to \"") + methodName + "\"");
+				}
+			}
+			catch (Glib::Error const &e)
+			{
+				error = e;
+			}
+
+			if (error)
+				shared->retire();
+
+			for (auto const &waiter : shared->takeWaiters())
+			{
+				if (error)
+					waiter.completion({}, error);
+				else if (waiter.cancellable->is_cancelled())
+					waiter.completion({}, Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+				else
+					waiter.completion(shared, Glib::Error());
+			}
+		}
+	);
+}
+
+void Client::releaseBrowser(std::shared_ptr<SharedBrowser> const &browser)
 {
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER, "GetState",
+	if (m_browserLinger && m_connection && !browser->subscribers() &&
+	    browser->isPrepared() && !browser->isDefunct())
+		browser->linger(m_browserLinger);
+}
+
+Glib::RefPtr<Gio::Cancellable> Client::async_getServerState(SlotGetServerState const &completion)
+{
+	auto cancellable = Gio::Cancellable::create();
+	call(
+		Operation::GetState, "/", AVAHI_DBUS_INTERFACE_SERVER, "GetState",
 		Glib::VariantContainerBase(),
 		[connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -128,16 +1162,17 @@ void Client::async_getServerState(SlotGetServerState const &completion)
 				completion(AvahiServerState{}, e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void Client::async_getHostName(SlotGetHostName const &completion)
+Glib::RefPtr<Gio::Cancellable> Client::async_getHostName(SlotGetHostName const &completion)
 {
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER, "GetHostName",
+	auto cancellable = Gio::Cancellable::create();
+	call(
+		Operation::GetHostName, "/", AVAHI_DBUS_INTERFACE_SERVER, "GetHostName",
 		Glib::VariantContainerBase(),
 		[connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -163,18 +1198,19 @@ void Client::async_getHostName(SlotGetHostName const &completion)
 				completion("", e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void Client::async_setHostName(Glib::ustring const &name,
+Glib::RefPtr<Gio::Cancellable> Client::async_setHostName(Glib::ustring const &name,
         SlotSetHostName const &completion)
 {
 	auto parameters = std::make_tuple(name);
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER, "SetHostName",
+	auto cancellable = Gio::Cancellable::create();
+	call(
+		Operation::SetHostName, "/", AVAHI_DBUS_INTERFACE_SERVER, "SetHostName",
 		Glib::Variant<decltype(parameters)>::create(parameters),
 		[connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -188,13 +1224,13 @@ void Client::async_setHostName(Glib::ustring const &name,
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void Client::async_reconfirmRecord(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType type, RecordData const &data, SlotReconfirmRecord const &completion)
+Glib::RefPtr<Gio::Cancellable> Client::async_reconfirmRecord(Interface interface, Protocol protocol, RecordName const &name, RecordClass clazz, RecordType type, RecordData const &data, SlotReconfirmRecord const &completion)
 {
 	std::uint32_t flags = 0;
 	auto parameters = std::make_tuple(
@@ -205,8 +1241,9 @@ void Client::async_reconfirmRecord(Interface interface, Protocol protocol, Recor
 		type,
 		flags,
 		data);
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER, "ReconfirmRecord",
+	auto cancellable = Gio::Cancellable::create();
+	call(
+		Operation::ReconfirmRecord, "/", AVAHI_DBUS_INTERFACE_SERVER, "ReconfirmRecord",
 		Glib::Variant<decltype(parameters)>::create(parameters),
 		[connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -220,51 +1257,83 @@ void Client::async_reconfirmRecord(Interface interface, Protocol protocol, Recor
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void Client::async_createEntryGroup(SlotCreateEntryGroup const &completion)
+Glib::RefPtr<Gio::Cancellable> Client::async_createEntryGroup(SlotCreateEntryGroup const &completion)
 {
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER, "EntryGroupNew",
-		Glib::VariantContainerBase{},
-		[this, connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
+	auto cancellable = Gio::Cancellable::create();
+
+	if (!m_entryGroupPool.empty())
+	{
+		auto group = std::move(m_entryGroupPool.back());
+		m_entryGroupPool.pop_back();
+
+		/* the completion must not be invoked from here */
+		Glib::MainContext::get_thread_default()->signal_idle().connect([cancellable, completion, group]
 		{
-			try
-			{
-				auto response = connection->call_finish(result);
+			if (cancellable->is_cancelled())
+				completion({}, Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+			else
+				completion(group, Glib::Error());
+			return false;  // disconnect
+		});
+		return cancellable;
+	}
 
+	whenConnected(cancellable, [this, cancellable, completion]
+	{
+		call(
+			Operation::EntryGroupNew, "/", AVAHI_DBUS_INTERFACE_SERVER, "EntryGroupNew",
+			Glib::VariantContainerBase{},
+			[this, connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
+			{
 				try
 				{
-					using ParamsType = std::tuple<Glib::DBusObjectPathString>;
-					auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
-					auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
+					auto response = connection->call_finish(result);
 
-					auto entryGroup = std::make_shared<EntryGroup>(EntryGroup::Token{}, *this, objectPath);
-					completion(entryGroup, Glib::Error());
+					try
+					{
+						using ParamsType = std::tuple<Glib::DBusObjectPathString>;
+						auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
+						auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
+
+						auto entryGroup = std::make_shared<EntryGroup>(EntryGroup::Token{}, *this, objectPath);
+						completion(entryGroup, Glib::Error());
+					}
+					catch (std::bad_cast const &e)
+					{
+						completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"EntryGroupNew\""));
+					}
 				}
-				catch (std::bad_cast const &e)
+				catch (Glib::Error const &e)
 				{
-					completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"EntryGroupNew\""));
+					completion({}, e);
 				}
-			}
-			catch (Glib::Error const &e)
-			{
-				completion({}, e);
-			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+			},
+			cancellable
+		);
+	}, [completion](Glib::Error const &error)
+	{
+		completion({}, error);
+	});
+
+	return cancellable;
 }
 
-void Client::async_createRecordBrowser(Interface interface, Protocol protocol,
+Glib::RefPtr<Gio::Cancellable> Client::async_createRecordBrowser(Interface interface, Protocol protocol,
         RecordName const &name, RecordClass clazz, RecordType type, ::AvahiLookupFlags flags,
         SlotCreateRecordBrowser const &completion)
+{
+	return async_createRecordBrowser(interface, protocol, name, clazz, type, flags, BrowseFilter(), completion);
+}
+
+Glib::RefPtr<Gio::Cancellable> Client::async_createRecordBrowser(Interface interface, Protocol protocol,
+        RecordName const &name, RecordClass clazz, RecordType type, ::AvahiLookupFlags flags,
+        BrowseFilter const &filter, SlotCreateRecordBrowser const &completion)
 {
 	auto parameters = std::make_tuple(
 		interface,
@@ -274,119 +1343,124 @@ void Client::async_createRecordBrowser(Interface interface, Protocol protocol,
 		type,
 		static_cast<std::uint32_t>(flags));
 
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER2, "RecordBrowserPrepare",
-		Glib::Variant<decltype(parameters)>::create(parameters),
-		[this, connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
-		{
-			try
+	auto cancellable = Gio::Cancellable::create();
+	whenConnected(cancellable, [this, parameters, filter, cancellable, completion]
+	{
+		acquireBrowser(
+			Operation::RecordBrowserPrepare, "RecordBrowserPrepare", AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
+			Glib::Variant<decltype(parameters)>::create(parameters), cancellable,
+			[this, filter, completion](std::shared_ptr<SharedBrowser> const &shared, Glib::Error const &error)
 			{
-				auto response = connection->call_finish(result);
-
-				try
+				if (error)
 				{
-					using ParamsType = std::tuple<Glib::DBusObjectPathString>;
-					auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
-					auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
-
-					auto recordBrowser = std::make_shared<RecordBrowser>(RecordBrowser::Token{}, *this, objectPath);
-					completion(recordBrowser, Glib::Error());
+					completion({}, error);
+					return;
 				}
-				catch (std::bad_cast const &e)
-				{
-					completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"ServiceBrowserPrepare\""));
-				}
-			}
-			catch (Glib::Error const &e)
-			{
-				completion({}, e);
+
+				auto recordBrowser = std::make_shared<RecordBrowser>(RecordBrowser::Token{}, *this, shared, filter);
+				completion(recordBrowser, Glib::Error());
+				shared->activate();
+				shared->replay(recordBrowser.get());
 			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+		);
+	}, [completion](Glib::Error const &error)
+	{
+		completion({}, error);
+	});
+
+	return cancellable;
 }
 
-void Client::async_createServiceBrowser(Interface interface, Protocol protocol,
+Glib::RefPtr<Gio::Cancellable> Client::async_createServiceBrowser(Interface interface, Protocol protocol,
         ServiceType const &type, Domain const &domain, ::AvahiLookupFlags flags,
         SlotCreateServiceBrowser const &completion)
+{
+	return async_createServiceBrowser(interface, protocol, type, domain, flags, BrowseFilter(), completion);
+}
+
+Glib::RefPtr<Gio::Cancellable> Client::async_createServiceBrowser(Interface interface, Protocol protocol,
+        ServiceType const &type, Domain const &domain, ::AvahiLookupFlags flags,
+        BrowseFilter const &filter, SlotCreateServiceBrowser const &completion)
 {
 	auto parameters = std::make_tuple(interface, protocol, type, domain, static_cast<std::uint32_t>(flags));
 
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER2, "ServiceBrowserPrepare",
-		Glib::Variant<decltype(parameters)>::create(parameters),
-		[this, connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
-		{
-			try
+	auto cancellable = Gio::Cancellable::create();
+	whenConnected(cancellable, [this, parameters, filter, cancellable, completion]
+	{
+		acquireBrowser(
+			Operation::ServiceBrowserPrepare, "ServiceBrowserPrepare", AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
+			Glib::Variant<decltype(parameters)>::create(parameters), cancellable,
+			[this, filter, completion](std::shared_ptr<SharedBrowser> const &shared, Glib::Error const &error)
 			{
-				auto response = connection->call_finish(result);
-
-				try
+				if (error)
 				{
-					using ParamsType = std::tuple<Glib::DBusObjectPathString>;
-					auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
-					auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
-
-					auto serviceBrowser = std::make_shared<ServiceBrowser>(ServiceBrowser::Token{}, *this, objectPath);
-					completion(serviceBrowser, Glib::Error());
+					completion({}, error);
+					return;
 				}
-				catch (std::bad_cast const &e)
-				{
-					completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"ServiceBrowserPrepare\""));
-				}
-			}
-			catch (Glib::Error const &e)
-			{
-				completion({}, e);
+
+				auto serviceBrowser = std::make_shared<ServiceBrowser>(ServiceBrowser::Token{}, *this, shared, filter);
+				completion(serviceBrowser, Glib::Error());
+				shared->activate();
+				shared->replay(serviceBrowser.get());
 			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+		);
+	}, [completion](Glib::Error const &error)
+	{
+		completion({}, error);
+	});
+
+	return cancellable;
 }
 
-void Client::async_createServiceResolver(Interface interface, Protocol protocol,
+Glib::RefPtr<Gio::Cancellable> Client::async_createServiceResolver(Interface interface, Protocol protocol,
         ServiceName const &name, ServiceType const &type, Domain const &domain,
         Protocol aprotocol, ::AvahiLookupFlags flags,
         SlotCreateServiceResolver const &completion)
 {
 	auto parameters = std::make_tuple(interface, protocol, name, type, domain, aprotocol, static_cast<std::uint32_t>(flags));
 
-	m_connection->call(
-		"/", AVAHI_DBUS_INTERFACE_SERVER2, "ServiceResolverPrepare",
-		Glib::Variant<decltype(parameters)>::create(parameters),
-		[this, connection = m_connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
-		{
-			try
+	auto variant = Glib::Variant<decltype(parameters)>::create(parameters);
+	auto cancellable = Gio::Cancellable::create();
+	whenConnected(cancellable, [this, variant, cancellable, completion]
+	{
+		call(
+			Operation::ServiceResolverPrepare, "/", AVAHI_DBUS_INTERFACE_SERVER2, "ServiceResolverPrepare",
+			variant,
+			[this, connection = m_connection, variant, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 			{
-				auto response = connection->call_finish(result);
-
 				try
 				{
-					using ParamsType = std::tuple<Glib::DBusObjectPathString>;
-					auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
-					auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
+					auto response = connection->call_finish(result);
+
+					try
+					{
+						using ParamsType = std::tuple<Glib::DBusObjectPathString>;
+						auto const parsedParams = Glib::VariantBase::cast_dynamic<Glib::Variant<ParamsType>>(response);
+						auto const &[objectPath] = parsedParams.get();  // unpack variant+tuple
 
-					auto serviceBrowser = std::make_shared<ServiceResolver>(ServiceResolver::Token{}, *this, objectPath);
-					completion(serviceBrowser, Glib::Error());
+						auto serviceBrowser = std::make_shared<ServiceResolver>(ServiceResolver::Token{}, *this, objectPath, variant);
+						/* Start service resolver after registering all signals handlers */
+						serviceBrowser->start();
+						completion(serviceBrowser, Glib::Error());
+					}
+					catch (std::bad_cast const &e)
+					{
+						completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"ServiceResolverPrepare\""));
+					}
 				}
-				catch (std::bad_cast const &e)
+				catch (Glib::Error const &e)
 				{
-					completion({}, Glib::Error(G_VARIANT_PARSE_ERROR, G_VARIANT_PARSE_ERROR_FAILED, "Client: Cannot parse response to \"ServiceResolverPrepare\""));
+					completion({}, e);
 				}
-			}
-			catch (Glib::Error const &e)
-			{
-				completion({}, e);
-			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+			},
+			cancellable
+		);
+	}, [completion](Glib::Error const &error)
+	{
+		completion({}, error);
+	});
+
+	return cancellable;
 }
 
 } /* namespace Avahi */
@@ -0,0 +1,291 @@
+/**
+ *  \file
+ *  \brief Avahi client running on a dedicated worker thread
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include <glibmm/main.h>
+
+#include <glib.h>
+
+#include "../ClientThread.hpp"         // IWYU pragma: associated
+
+namespace Avahi {
+
+/* Intrusive MPSC queue as described by Dmitry Vyukov: producers only
+ * exchange the head pointer, the (single) consumer follows the 'next' links
+ * from the tail.  A producer which has exchanged the head but not yet
+ * linked its node makes the queue look empty; the consumer reports this as
+ * 'busy' and requests another dispatch. */
+class ClientThread::Mailbox
+{
+public:   // methods
+	Mailbox()
+	: m_head(&m_stub)
+	, m_tail(&m_stub)
+	, m_scheduled(false)
+	, m_budget(5000)
+	{}
+
+	~Mailbox()
+	{
+		bool busy;
+		while (Node *node = pop(busy))
+			delete node;
+	}
+
+	Mailbox(Mailbox const &other) = delete;
+	Mailbox& operator=(Mailbox const &other) = delete;
+
+	void post(Work work)
+	{
+		push(new Node{{nullptr}, std::move(work)});
+		schedule();
+	}
+
+	std::size_t dispatch()
+	{
+		std::int64_t const budget = m_budget.load(std::memory_order_relaxed);
+		std::int64_t const started = ::g_get_monotonic_time();
+		std::size_t count = 0;
+
+		/* Cleared before draining, so that work posted from now on
+		 * requests a new dispatch. */
+		m_scheduled.store(false);
+
+		for (;;)
+		{
+			bool busy;
+			Node *node = pop(busy);
+			if (!node)
+			{
+				if (busy)
+					schedule();
+				break;
+			}
+
+			auto work = std::move(node->work);
+			delete node;
+			work();
+			count++;
+
+			if (budget && ::g_get_monotonic_time() - started >= budget)
+			{
+				schedule();
+				break;
+			}
+		}
+
+		return count;
+	}
+
+	void setBudget(unsigned int budget_usec) { m_budget.store(budget_usec, std::memory_order_relaxed); }
+
+	SlotWakeup wakeup;
+
+private:  // types
+	struct Node
+	{
+		std::atomic<Node *> next;
+		Work work;
+	};
+
+private:  // methods
+	void schedule()
+	{
+		if (!m_scheduled.exchange(true) && wakeup)
+			wakeup();
+	}
+
+	void push(Node *node)
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node *previous = m_head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	Node *pop(bool &busy)
+	{
+		busy = false;
+
+		Node *tail = m_tail;
+		Node *next = tail->next.load(std::memory_order_acquire);
+
+		if (tail == &m_stub)
+		{
+			if (!next)
+			{
+				busy = m_head.load(std::memory_order_acquire) != &m_stub;
+				return nullptr;
+			}
+			m_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next)
+		{
+			m_tail = next;
+			return tail;
+		}
+
+		if (tail != m_head.load(std::memory_order_acquire))
+		{
+			busy = true;
+			return nullptr;
+		}
+
+		/* 'tail' is the last node; re-insert the stub so that it can be
+		 * detached. */
+		push(&m_stub);
+		next = tail->next.load(std::memory_order_acquire);
+		if (next)
+		{
+			m_tail = next;
+			return tail;
+		}
+
+		busy = true;
+		return nullptr;
+	}
+
+private:  // members
+	Node m_stub{{nullptr}, {}};
+	std::atomic<Node *> m_head;
+	/** Only accessed by the consumer. */
+	Node *m_tail;
+	/** Set while a dispatch is pending. */
+	std::atomic<bool> m_scheduled;
+	std::atomic<std::int64_t> m_budget;
+};
+
+namespace {
+
+/** Attaches an idle source to \a context which calls dispatch() (unless the
+ *  mailbox has been destroyed meanwhile).  Thread-safe, in contrast to
+ *  Glib::SignalIdle::connect(). */
+template <typename Mailbox>
+void attachDispatch(GMainContext *context, std::weak_ptr<Mailbox> const &mailbox)
+{
+	GSource *source = ::g_idle_source_new();
+	::g_source_set_priority(source, G_PRIORITY_DEFAULT);
+	::g_source_set_callback(source,
+		[](gpointer data) -> gboolean
+		{
+			if (auto mailbox = static_cast<std::weak_ptr<Mailbox> *>(data)->lock())
+				mailbox->dispatch();
+			return G_SOURCE_REMOVE;
+		},
+		new std::weak_ptr<Mailbox>(mailbox),
+		[](gpointer data)
+		{
+			delete static_cast<std::weak_ptr<Mailbox> *>(data);
+		});
+	::g_source_attach(source, context);
+	::g_source_unref(source);
+}
+
+}  // namespace
+
+ClientThread::ClientThread(Glib::RefPtr<Glib::MainContext> const &target)
+: m_context(Glib::MainContext::create())
+, m_loop(Glib::MainLoop::create(m_context, false))
+, m_mailbox(std::make_shared<Mailbox>())
+, m_client()
+, m_thread()
+{
+	auto context = target ? target : Glib::MainContext::get_thread_default();
+	if (!context)
+		context = Glib::MainContext::get_default();
+
+	std::weak_ptr<Mailbox> mailbox = m_mailbox;
+	m_mailbox->wakeup = [context, mailbox]
+	{
+		attachDispatch(context->gobj(), mailbox);
+	};
+
+	/* Started last, so that the mailbox is never accessed concurrently
+	 * while being set up. */
+	m_thread = std::thread(&ClientThread::run, this);
+}
+
+ClientThread::ClientThread(SlotWakeup const &wakeup)
+: m_context(Glib::MainContext::create())
+, m_loop(Glib::MainLoop::create(m_context, false))
+, m_mailbox(std::make_shared<Mailbox>())
+, m_client()
+, m_thread()
+{
+	m_mailbox->wakeup = wakeup;
+	m_thread = std::thread(&ClientThread::run, this);
+}
+
+ClientThread::~ClientThread()
+{
+	/* Quitting via the context (instead of calling m_loop->quit() directly)
+	 * also works if the worker has not started running the loop yet. */
+	::g_main_context_invoke_full(m_context->gobj(), G_PRIORITY_DEFAULT,
+		[](gpointer data) -> gboolean
+		{
+			::g_main_loop_quit(static_cast<GMainLoop *>(data));
+			return G_SOURCE_REMOVE;
+		},
+		m_loop->gobj(), nullptr);
+	m_thread.join();
+}
+
+void ClientThread::invoke(Task task)
+{
+	struct Context
+	{
+		ClientThread *self;
+		Task task;
+	};
+
+	::g_main_context_invoke_full(m_context->gobj(), G_PRIORITY_DEFAULT,
+		[](gpointer data) -> gboolean
+		{
+			auto *context = static_cast<Context *>(data);
+			if (context->self->m_client)
+				context->task(*context->self->m_client);
+			return G_SOURCE_REMOVE;
+		},
+		new Context{this, std::move(task)},
+		[](gpointer data)
+		{
+			delete static_cast<Context *>(data);
+		});
+}
+
+void ClientThread::post(Work work)
+{
+	m_mailbox->post(std::move(work));
+}
+
+std::size_t ClientThread::dispatch()
+{
+	return m_mailbox->dispatch();
+}
+
+void ClientThread::setDispatchBudget(unsigned int budget_usec)
+{
+	m_mailbox->setBudget(budget_usec);
+}
+
+void ClientThread::run()
+{
+	m_context->push_thread_default();
+
+	m_client = std::make_unique<Client>();
+	m_loop->run();
+	m_client.reset();
+
+	m_context->pop_thread_default();
+}
+
+} /* namespace Avahi */
@@ -0,0 +1,209 @@
+/**
+ *  \file
+ *  \brief Parallel IPv4/IPv6 resolving of a single service
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <giomm/cancellable.h>
+#include <glibmm/error.h>
+
+#include <avahi-common/address.h>      // AVAHI_PROTO_INET, AVAHI_PROTO_INET6
+
+#include "../Client.hpp"
+#include "../DualStackResolver.hpp"    // IWYU pragma: associated
+#include "../ServiceResolver.hpp"
+
+namespace Avahi {
+
+namespace {
+
+bool isLinkLocal(ServiceResolver::AProtocol aprotocol, StringView address)
+{
+	if (aprotocol == AVAHI_PROTO_INET)
+		return address.compare(0, 8, "169.254.") == 0;
+
+	/* fe80::/10 */
+	if (address.size() < 4 || (address[0] != 'f' && address[0] != 'F') || (address[1] != 'e' && address[1] != 'E'))
+		return false;
+	switch (address[2])
+	{
+		case '8': case '9': case 'a': case 'b': case 'A': case 'B':
+			return address[3] != ':';  // "fe8:" would be fe8::/16 (not link-local)
+		default:
+			return false;
+	}
+}
+
+}  // namespace
+
+/** Owned by the DualStackResolver; the creation completion only holds a weak
+ *  reference. */
+struct DualStackResolver::Lookup
+{
+	Lookup(DualStackResolver &owner, ServiceResolver::AProtocol aprotocol)
+	: owner(owner)
+	, aprotocol(aprotocol)
+	, done(false)
+	{}
+
+	DualStackResolver &owner;
+	ServiceResolver::AProtocol aprotocol;
+	Glib::RefPtr<Gio::Cancellable> creating;
+	std::shared_ptr<ServiceResolver> resolver;
+	/** Whether the first result (or a failure) has been received. */
+	bool done;
+};
+
+DualStackResolver::DualStackResolver(Client &client, Interface interface, Protocol protocol,
+        ServiceName const &name, ServiceType const &type, Domain const &domain,
+        ::AvahiLookupFlags flags)
+: m_client(client)
+, m_lookups{std::make_shared<Lookup>(*this, AVAHI_PROTO_INET), std::make_shared<Lookup>(*this, AVAHI_PROTO_INET6)}
+, m_complete(false)
+{
+	/* both "ServiceResolverPrepare" calls are sent at once */
+	for (auto const &lookup : m_lookups)
+	{
+		lookup->creating = m_client.async_createServiceResolver(interface, protocol, name, type, domain, lookup->aprotocol, flags,
+			[weak = std::weak_ptr<Lookup>(lookup)](std::shared_ptr<ServiceResolver> const &resolver, Glib::Error const &error)
+			{
+				auto lookup = weak.lock();
+				if (!lookup)
+					return;  // owner has been destroyed in the meantime
+
+				auto &owner = lookup->owner;
+				lookup->creating.reset();
+				if (error)
+				{
+					std::stringstream ss;
+
+					ss << "DualStackResolver: Cannot create " << (lookup->aprotocol == AVAHI_PROTO_INET ? "IPv4" : "IPv6")
+					   << " resolver: " << error.what();
+					owner.on_errorLog(ss.str().c_str());
+					owner.onDone(*lookup, error.what());
+					return;
+				}
+
+				/* The resolver is owned by 'lookup', which is owned by the
+				 * owner, so capturing raw pointers is safe. */
+				auto *raw = lookup.get();
+				resolver->on_errorLog.connect([raw](char const *message)
+				{
+					raw->owner.on_errorLog(message);
+				});
+				resolver->on_foundView.connect([raw](ServiceResolver::FoundView const &found)
+				{
+					raw->owner.onFound(found);
+					raw->owner.onDone(*raw, Error());
+				});
+				resolver->on_failure.connect([raw](Error const &message)
+				{
+					if (raw->done)
+					{
+						std::stringstream ss;
+
+						ss << "DualStackResolver: " << (raw->aprotocol == AVAHI_PROTO_INET ? "IPv4" : "IPv6")
+						   << " resolver has failed: " << message;
+						raw->owner.on_errorLog(ss.str().c_str());
+						return;
+					}
+					raw->owner.onDone(*raw, message);
+				});
+				lookup->resolver = resolver;
+			});
+	}
+}
+
+DualStackResolver::~DualStackResolver()
+{
+	/* the completions of pending creations only hold weak references */
+	for (auto const &lookup : m_lookups)
+	{
+		if (lookup->creating)
+			lookup->creating->cancel();
+	}
+}
+
+bool DualStackResolver::complete() const
+{
+	return m_complete;
+}
+
+void DualStackResolver::onFound(ServiceResolver::FoundView const &found)
+{
+	m_txt = TxtRecord(found.txt);
+
+	/* each resolver reports a single address per interface, a new one
+	 * replaces the previous one (e.g. after a DHCP renew) */
+	auto it = std::find_if(m_candidates.begin(), m_candidates.end(), [&found](Candidate const &candidate)
+	{
+		return candidate.interface == found.interface && candidate.aprotocol == found.aprotocol;
+	});
+
+	if (it != m_candidates.end())
+	{
+		bool const sameAddress = StringView(it->address.data(), it->address.bytes()) == found.address;
+
+		/* known address, report only relevant changes */
+		if (sameAddress && it->port == found.port && StringView(it->host.data(), it->host.bytes()) == found.host)
+		{
+			it->flags = found.flags;
+			return;
+		}
+
+		if (!sameAddress)
+			*it = makeCandidate(found);
+		else
+		{
+			it->host = Host(found.host.begin(), found.host.end());
+			it->port = found.port;
+			it->flags = found.flags;
+		}
+		on_candidate(*it, false);
+		return;
+	}
+
+	m_candidates.push_back(makeCandidate(found));
+	on_candidate(m_candidates.back(), m_candidates.size() == 1);
+}
+
+DualStackResolver::Candidate DualStackResolver::makeCandidate(ServiceResolver::FoundView const &found)
+{
+	Candidate candidate{found.interface, found.protocol, found.aprotocol,
+	                    ServiceResolver::Address(found.address.begin(), found.address.end()),
+	                    isLinkLocal(found.aprotocol, found.address), std::string(found.address),
+	                    Host(found.host.begin(), found.host.end()), found.port, found.flags};
+	if (candidate.linkLocal && candidate.aprotocol == AVAHI_PROTO_INET6)
+		candidate.scopedAddress += '%' + std::to_string(candidate.interface);
+	return candidate;
+}
+
+void DualStackResolver::onDone(Lookup &lookup, Error const &error)
+{
+	if (lookup.done)
+		return;
+
+	lookup.done = true;
+	if (!error.empty() && m_firstError.empty())
+		m_firstError = error;
+
+	for (auto const &other : m_lookups)
+	{
+		if (!other->done)
+			return;
+	}
+
+	m_complete = true;
+	if (m_candidates.empty())
+		on_failure(m_firstError);
+	else
+		on_complete();
+}
+
+} /* namespace Avahi */
@@ -5,90 +5,227 @@
  *  \copyright 2022 ARRI Lighting Stephanskirchen
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <sstream>
 #include <tuple>
-#include <typeinfo>                    // std::bad_cast
+#include <vector>
 
+#include <giomm/cancellable.h>
 #include <giomm/dbusconnection.h>
 #include <glibmm/error.h>
+#include <glibmm/main.h>
 #include <glibmm/refptr.h>
 #include <glibmm/variant.h>
+#include <sigc++/functors/mem_fun.h>
 
 #include <avahi-common/dbus.h>
-#include <glib.h>                      // G_MAXINT
+#include <gio/gio.h>                   // G_IO_ERROR
+#include <glib.h>
 
 #include "../Client.hpp"
 #include "../EntryGroup.hpp"           // IWYU pragma: associated
+#include "../TxtRecord.hpp"
+#include "SignalTable.hpp"
 
 namespace Gio { class AsyncResult; }
 
 namespace Avahi {
 
+namespace {
+
+/* The TXT data is inserted as pre-serialized "aay" variant, so the
+ * parameters cannot be built via Glib::Variant<std::tuple<...>>. */
+
+Glib::VariantContainerBase addServiceParameters(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
+        Host const &host, Port port, TxtRecord const &txt)
+{
+	auto txtVariant = txt.toVariant();
+
+	return Glib::VariantContainerBase(::g_variant_new("(iiussssq@aay)",
+		interface, protocol, static_cast<std::uint32_t>(flags), name.c_str(), type.c_str(), domain.c_str(),
+		host.c_str(), port, txtVariant.gobj()));
+}
+
+Glib::VariantContainerBase updateServiceTxtParameters(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
+        TxtRecord const &txt)
+{
+	auto txtVariant = txt.toVariant();
+
+	return Glib::VariantContainerBase(::g_variant_new("(iiusss@aay)",
+		interface, protocol, static_cast<std::uint32_t>(flags), name.c_str(), type.c_str(), domain.c_str(),
+		txtVariant.gobj()));
+}
+
+/** Whether \a a and \a b only differ in their TXT data. */
+bool sameExceptTxt(EntryGroup::ServiceDefinition const &a, EntryGroup::ServiceDefinition const &b)
+{
+	return a.interface == b.interface && a.protocol == b.protocol && a.flags == b.flags &&
+	       a.name == b.name && a.type == b.type && a.domain == b.domain &&
+	       a.host == b.host && a.port == b.port && a.subtypes == b.subtypes;
+}
+
+}  // namespace
+
 EntryGroup::EntryGroup(Token, Client &client, Glib::ustring const &objectPath)
 : m_client(client)
 , m_objectPath(objectPath)
+, m_committed(false)
+, m_txtGeneration(0)
+, m_publishSerial(0)
 {
-	m_stateChanged = m_client.getConnection()->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using State = std::int32_t;
-			using Error = Glib::ustring;
-			using Params = std::tuple<State, Error>;
+	m_client.registerSession(this, sigc::mem_fun(*this, &EntryGroup::onSession));
+	m_client.registerObject(m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, sigc::mem_fun(*this, &EntryGroup::onSignal));
+}
 
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[state, error] = params.get();
+EntryGroup::~EntryGroup()
+{
+	m_client.unregisterSession(this);
 
-				on_stateChanged(static_cast<AvahiEntryGroupState>(state), error);
-			}
-			catch (std::bad_cast const &e)
+	if (m_objectPath.empty())
+		return;  // detached
+
+	m_client.releaseObject(m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP);
+}
+
+EntryGroup::Transaction EntryGroup::createTransaction()
+{
+	return Transaction(*this);
+}
+
+void EntryGroup::onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	static constexpr SignalHandler<EntryGroup> handlers[] = {
+		signalHandler<&EntryGroup::onStateChanged>("StateChanged"),
+	};
+
+	if (dispatchSignal(handlers, *this, signalName, parameters) == SignalResult::ParseError)
+	{
+		std::stringstream ss;
+
+		ss << "EntryGroup: Cannot parse \"" << signalName << "\" parameters";
+		m_client.parseError();
+		on_errorLog(ss.str().c_str());
+	}
+}
+
+void EntryGroup::onStateChanged(std::int32_t state, StringView error)
+{
+	on_stateChanged(static_cast<AvahiEntryGroupState>(state), Glib::ustring(error.data(), error.size()));
+}
+
+void EntryGroup::onSession(bool available)
+{
+	if (!available)
+	{
+		/* daemon side object is gone (Client has already dropped the
+		 * signal routing) */
+		m_objectPath.clear();
+		return;
+	}
+
+	m_client.restoreObject(Client::Operation::EntryGroupNew, "EntryGroupNew",
+		Glib::VariantContainerBase(), AVAHI_DBUS_INTERFACE_ENTRY_GROUP,
+		weak_from_this(), sigc::mem_fun(*this, &EntryGroup::rebind));
+}
+
+void EntryGroup::rebind(Glib::ustring const &objectPath, Glib::Error const &error)
+{
+	if (error)
+	{
+		std::stringstream ss;
+
+		ss << "EntryGroup: Cannot re-create entry group: " << error.what();
+		on_errorLog(ss.str().c_str());
+		return;
+	}
+
+	m_objectPath = objectPath;
+	m_client.registerObject(m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, sigc::mem_fun(*this, &EntryGroup::onSignal));
+
+	/* Re-publish all entries at once; the result is reported via
+	 * on_stateChanged. */
+	auto const &connection = m_client.getConnection();
+	auto replay = [this, connection](Client::Operation operation, char const *method, Glib::VariantContainerBase const &parameters)
+	{
+		m_client.call(
+			operation, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, method,
+			parameters,
+			[weak = weak_from_this(), connection, method](Glib::RefPtr<Gio::AsyncResult> &result)
 			{
-				on_errorLog("EntryGroup: Cannot parse \"StateChanged\" parameters");
-				return;
+				try
+				{
+					connection->call_finish(result);
+				}
+				catch (Glib::Error const &e)
+				{
+					auto self = weak.lock();
+					if (!self)
+						return;
+
+					std::stringstream ss;
+
+					ss << "EntryGroup: Re-publishing (\"" << method << "\") failed: " << e.what();
+					self->on_errorLog(ss.str().c_str());
+				}
 			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_ENTRY_GROUP,
-		"StateChanged",
-		m_objectPath);
+		);
+	};
+
+	for (auto const &entry : m_published)
+		replay(entry.operation, entry.method, entry.parameters);
+	if (m_committed)
+		replay(Client::Operation::Commit, "Commit", Glib::VariantContainerBase());
 }
 
-EntryGroup::~EntryGroup()
+void EntryGroup::remember(Transaction::Entry const &entry)
 {
-	auto const &connection = m_client.getConnection();
+	m_services.reset();
 
-	if (connection)
+	if (entry.operation == Client::Operation::UpdateServiceTxt)
 	{
-		connection->signal_unsubscribe(m_stateChanged);
-		connection->call(
-			m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Free",
-			Glib::VariantContainerBase(),
-			[](Glib::RefPtr<Gio::AsyncResult> &/*result*/)
-			{
-				/* we are not interested in the result, so there's no need to
-				 * run call_finish() */
-			},
-			/*bus_name*/ AVAHI_DBUS_NAME,
-			/*timeout_msec*/G_MAXINT,
-			Gio::DBus::CALL_FLAGS_NO_AUTO_START
-		);
+		/* Only the latest TXT update per service is relevant (and periodic
+		 * updates must not accumulate). */
+		auto sameService = [&entry](Transaction::Entry const &other)
+		{
+			if (other.operation != Client::Operation::UpdateServiceTxt)
+				return false;
+
+			/* interface, protocol, (flags), name, type, domain */
+			for (gsize index : {0, 1, 3, 4, 5})
+			{
+				GVariant *a = ::g_variant_get_child_value(const_cast<GVariant *>(entry.parameters.gobj()), index);
+				GVariant *b = ::g_variant_get_child_value(const_cast<GVariant *>(other.parameters.gobj()), index);
+				bool const equal = ::g_variant_equal(a, b);
+				::g_variant_unref(a);
+				::g_variant_unref(b);
+
+				if (!equal)
+					return false;
+			}
+			return true;
+		};
+
+		m_published.erase(std::remove_if(m_published.begin(), m_published.end(), sameService), m_published.end());
 	}
+
+	m_published.push_back(entry);
 }
 
-void EntryGroup::async_addService(Interface interface, Protocol protocol, ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain, Host const &host, Port port, Txt const &txt, SlotAddService const &completion)
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_addService(Interface interface, Protocol protocol, ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain, Host const &host, Port port, TxtRecord const &txt, SlotAddService const &completion)
 {
-	auto parameters = std::make_tuple(interface, protocol, static_cast<std::uint32_t>(flags), name, type, domain, host, port, txt);
+	auto variant = addServiceParameters(interface, protocol, flags, name, type, domain, host, port, txt);
+	remember({Client::Operation::AddService, "AddService", variant});
+	m_txtGeneration++;
 
 	auto const &connection = m_client.getConnection();
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "AddService",
-		Glib::Variant<decltype(parameters)>::create(parameters),
+	auto cancellable = Gio::Cancellable::create();
+	m_client.call(
+		Client::Operation::AddService, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "AddService",
+		variant,
 		[connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
 			try
@@ -101,22 +238,26 @@ void EntryGroup::async_addService(Interface interface, Protocol protocol, ::Avah
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void EntryGroup::async_addServiceSubtype(Interface interface, Protocol protocol,
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_addServiceSubtype(Interface interface, Protocol protocol,
         ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
         Subtype const &subtype, SlotAddServiceSubtype const &completion)
 {
 	auto parameters = std::make_tuple(interface, protocol, static_cast<std::uint32_t>(flags), name, type, domain, subtype);
 
+	auto variant = Glib::Variant<decltype(parameters)>::create(parameters);
+	remember({Client::Operation::AddServiceSubtype, "AddServiceSubtype", variant});
+
 	auto const &connection = m_client.getConnection();
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "AddServiceSubtype",
-		Glib::Variant<decltype(parameters)>::create(parameters),
+	auto cancellable = Gio::Cancellable::create();
+	m_client.call(
+		Client::Operation::AddServiceSubtype, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "AddServiceSubtype",
+		variant,
 		[connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
 			try
@@ -129,17 +270,20 @@ void EntryGroup::async_addServiceSubtype(Interface interface, Protocol protocol,
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void EntryGroup::async_commit(SlotCommit const &completion)
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_commit(SlotCommit const &completion)
 {
+	m_committed = true;
+
 	auto const &connection = m_client.getConnection();
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Commit",
+	auto cancellable = Gio::Cancellable::create();
+	m_client.call(
+		Client::Operation::Commit, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Commit",
 		Glib::VariantContainerBase(),
 		[connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -153,17 +297,23 @@ void EntryGroup::async_commit(SlotCommit const &completion)
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void EntryGroup::async_reset(SlotReset const &completion)
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_reset(SlotReset const &completion)
 {
+	m_published.clear();
+	m_services.reset();
+	m_committed = false;
+	m_txtGeneration++;
+
 	auto const &connection = m_client.getConnection();
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Reset",
+	auto cancellable = Gio::Cancellable::create();
+	m_client.call(
+		Client::Operation::Reset, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Reset",
 		Glib::VariantContainerBase(),
 		[connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
@@ -177,22 +327,25 @@ void EntryGroup::async_reset(SlotReset const &completion)
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
 }
 
-void EntryGroup::async_updateServiceTxt(Interface interface, Protocol protocol,
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_updateServiceTxt(Interface interface, Protocol protocol,
         ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
-        Txt const &txt, SlotUpdateServiceTxt const &completion)
+        TxtRecord const &txt, SlotUpdateServiceTxt const &completion)
 {
-	auto parameters = std::make_tuple(interface, protocol, static_cast<std::uint32_t>(flags), name, type, domain, txt);
+	auto variant = updateServiceTxtParameters(interface, protocol, flags, name, type, domain, txt);
+	remember({Client::Operation::UpdateServiceTxt, "UpdateServiceTxt", variant});
+	m_txtGeneration++;
 
 	auto const &connection = m_client.getConnection();
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "UpdateServiceTxt",
-		Glib::Variant<decltype(parameters)>::create(parameters),
+	auto cancellable = Gio::Cancellable::create();
+	m_client.call(
+		Client::Operation::UpdateServiceTxt, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "UpdateServiceTxt",
+		variant,
 		[connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
 			try
@@ -205,10 +358,336 @@ void EntryGroup::async_updateServiceTxt(Interface interface, Protocol protocol,
 				completion(e);
 			}
 		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		cancellable
 	);
+
+	return cancellable;
+}
+
+Glib::RefPtr<Gio::Cancellable> EntryGroup::async_publish(std::vector<ServiceDefinition> const &services,
+        SlotPublish const &completion)
+{
+	bool structural = !m_services || m_services->size() != services.size();
+	std::vector<std::size_t> changedTxt;
+
+	for (std::size_t index = 0; !structural && index < services.size(); index++)
+	{
+		if (!sameExceptTxt((*m_services)[index], services[index]))
+			structural = true;
+		else if ((*m_services)[index].txt != services[index].txt)
+			changedTxt.push_back(index);
+	}
+
+	auto const finish = publishCompletion(completion);
+	Glib::RefPtr<Gio::Cancellable> cancellable;
+	bool const published = !m_published.empty() || m_committed;
+
+	if (structural && services.empty() && published)
+	{
+		/* avahi-daemon refuses to commit an empty entry group
+		 * (AVAHI_ERR_IS_EMPTY) */
+		cancellable = async_reset(finish);
+	}
+	else if (structural && !services.empty())
+	{
+		/* Shared by "Reset" and the transaction; "Reset" is answered first. */
+		auto resetError = std::make_shared<Glib::Error>();
+		if (published)
+		{
+			async_reset([resetError](Glib::Error const &error)
+			{
+				*resetError = error;
+			});
+		}
+
+		auto transaction = createTransaction();
+		for (auto const &service : services)
+		{
+			transaction.addService(service.interface, service.protocol, service.flags, service.name,
+			                       service.type, service.domain, service.host, service.port, service.txt);
+			for (auto const &subtype : service.subtypes)
+				transaction.addServiceSubtype(service.interface, service.protocol, {}, service.name,
+				                              service.type, service.domain, subtype);
+		}
+		cancellable = transaction.async_commit([resetError, finish](Glib::Error const &error, std::vector<Glib::Error> const &/*entryErrors*/)
+		{
+			finish(*resetError ? *resetError : error);
+		});
+	}
+	else if (changedTxt.empty())
+	{
+		/* unchanged (or nothing to unpublish), but the completion must not
+		 * be invoked from here */
+		cancellable = Gio::Cancellable::create();
+		Glib::MainContext::get_thread_default()->signal_idle().connect([cancellable, completion]
+		{
+			if (cancellable->is_cancelled())
+				completion(Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+			else
+				completion(Glib::Error());
+			return false;  // disconnect
+		});
+		return cancellable;
+	}
+	else
+	{
+		/* Shared between the completion handlers of all pipelined calls */
+		struct State
+		{
+			SlotPublish completion;
+			Glib::Error error;
+			std::size_t pending;
+		};
+
+		auto state = std::make_shared<State>(State{finish, Glib::Error(), changedTxt.size()});
+		auto const &connection = m_client.getConnection();
+
+		cancellable = Gio::Cancellable::create();
+		for (auto index : changedTxt)
+		{
+			auto const &service = services[index];
+			auto variant = updateServiceTxtParameters(service.interface, service.protocol, service.flags,
+			                                          service.name, service.type, service.domain, service.txt);
+			remember({Client::Operation::UpdateServiceTxt, "UpdateServiceTxt", variant});
+
+			m_client.call(
+				Client::Operation::UpdateServiceTxt, m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "UpdateServiceTxt",
+				variant,
+				[connection, state](Glib::RefPtr<Gio::AsyncResult> &result)
+				{
+					try
+					{
+						connection->call_finish(result);
+					}
+					catch (Glib::Error const &e)
+					{
+						if (!state->error)
+							state->error = e;
+					}
+					if (!--state->pending)
+						state->completion(state->error);
+				},
+				cancellable
+			);
+		}
+		m_txtGeneration++;
+	}
+
+	/* after the calls above, which invalidate it */
+	m_services = services;
+	return cancellable;
+}
+
+EntryGroup::SlotPublish EntryGroup::publishCompletion(SlotPublish const &completion)
+{
+	return [weak = weak_from_this(), serial = ++m_publishSerial, completion](Glib::Error const &error)
+	{
+		if (error)
+		{
+			auto self = weak.lock();
+			if (self && self->m_publishSerial == serial)
+				self->m_services.reset();
+		}
+		completion(error);
+	};
+}
+
+EntryGroup::PreparedTxtUpdate EntryGroup::prepareTxtUpdate(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain)
+{
+	auto state = std::make_shared<PreparedTxtUpdate::State>();
+
+	state->identity = {
+		Glib::VariantBase(::g_variant_new_int32(interface)),
+		Glib::VariantBase(::g_variant_new_int32(protocol)),
+		Glib::VariantBase(::g_variant_new_uint32(static_cast<std::uint32_t>(flags))),
+		Glib::VariantBase(::g_variant_new_string(name.c_str())),
+		Glib::VariantBase(::g_variant_new_string(type.c_str())),
+		Glib::VariantBase(::g_variant_new_string(domain.c_str())),
+	};
+
+	return PreparedTxtUpdate(*this, state);
+}
+
+EntryGroup::PreparedTxtUpdate::PreparedTxtUpdate(EntryGroup &group, std::shared_ptr<State> const &state)
+: m_group(group)
+, m_state(state)
+{
+}
+
+Glib::RefPtr<Gio::Cancellable> EntryGroup::PreparedTxtUpdate::async_update(TxtRecord const &txt, SlotUpdate const &completion)
+{
+	auto cancellable = Gio::Cancellable::create();
+
+	if (m_state->lastTxt && m_state->generation == m_group.m_txtGeneration && *m_state->lastTxt == txt)
+	{
+		/* unchanged, but the completion must not be invoked from here */
+		Glib::MainContext::get_thread_default()->signal_idle().connect([cancellable, completion]
+		{
+			if (cancellable->is_cancelled())
+				completion(Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled"));
+			else
+				completion(Glib::Error());
+			return false;  // disconnect
+		});
+		return cancellable;
+	}
+
+	/* The identity children are shared (only referenced) by all updates. */
+	auto txtVariant = txt.toVariant();
+	GVariant *children[] = {
+		const_cast<GVariant *>(m_state->identity[0].gobj()),
+		const_cast<GVariant *>(m_state->identity[1].gobj()),
+		const_cast<GVariant *>(m_state->identity[2].gobj()),
+		const_cast<GVariant *>(m_state->identity[3].gobj()),
+		const_cast<GVariant *>(m_state->identity[4].gobj()),
+		const_cast<GVariant *>(m_state->identity[5].gobj()),
+		const_cast<GVariant *>(txtVariant.gobj()),
+	};
+	Glib::VariantContainerBase variant(::g_variant_new_tuple(children, G_N_ELEMENTS(children)));
+
+	m_group.remember({Client::Operation::UpdateServiceTxt, "UpdateServiceTxt", variant});
+	m_state->lastTxt = txt;
+	m_state->generation = m_group.m_txtGeneration;
+
+	auto const &connection = m_group.m_client.getConnection();
+	m_group.m_client.call(
+		Client::Operation::UpdateServiceTxt, m_group.m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "UpdateServiceTxt",
+		variant,
+		[weak = std::weak_ptr<State>(m_state), connection, completion](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			try
+			{
+				connection->call_finish(result);
+				completion(Glib::Error());
+			}
+			catch (Glib::Error const &e)
+			{
+				/* the next update must be sent, even if unchanged */
+				if (auto state = weak.lock())
+					state->lastTxt.reset();
+				completion(e);
+			}
+		},
+		cancellable
+	);
+
+	return cancellable;
+}
+
+EntryGroup::Transaction::Transaction(EntryGroup &group)
+: m_group(group)
+{
+}
+
+EntryGroup::Transaction &EntryGroup::Transaction::addService(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
+        Host const &host, Port port, TxtRecord const &txt)
+{
+	m_entries.push_back({Client::Operation::AddService, "AddService",
+	                     addServiceParameters(interface, protocol, flags, name, type, domain, host, port, txt)});
+	return *this;
+}
+
+EntryGroup::Transaction &EntryGroup::Transaction::addServiceSubtype(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
+        Subtype const &subtype)
+{
+	auto parameters = std::make_tuple(interface, protocol, static_cast<std::uint32_t>(flags), name, type, domain, subtype);
+	m_entries.push_back({Client::Operation::AddServiceSubtype, "AddServiceSubtype", Glib::Variant<decltype(parameters)>::create(parameters)});
+	return *this;
+}
+
+EntryGroup::Transaction &EntryGroup::Transaction::updateServiceTxt(Interface interface, Protocol protocol,
+        ::AvahiPublishFlags flags, ServiceName const &name, ServiceType const &type, Domain const &domain,
+        TxtRecord const &txt)
+{
+	m_entries.push_back({Client::Operation::UpdateServiceTxt, "UpdateServiceTxt",
+	                     updateServiceTxtParameters(interface, protocol, flags, name, type, domain, txt)});
+	return *this;
+}
+
+Glib::RefPtr<Gio::Cancellable> EntryGroup::Transaction::async_commit(SlotCommit const &completion)
+{
+	/* Shared between the completion handlers of all pipelined calls */
+	struct State
+	{
+		SlotCommit completion;
+		std::vector<Glib::Error> entryErrors;
+		Glib::Error commitError;
+		std::size_t pending;
+
+		void finish()
+		{
+			if (--pending)
+				return;
+
+			for (auto const &error : entryErrors)
+			{
+				if (error)
+				{
+					completion(error, entryErrors);
+					return;
+				}
+			}
+			completion(commitError, entryErrors);
+		}
+	};
+
+	auto state = std::make_shared<State>();
+	state->completion = completion;
+	state->entryErrors.resize(m_entries.size());
+	state->pending = m_entries.size() + 1;  // entries + "Commit"
+
+	auto &client = m_group.m_client;
+	auto const &connection = client.getConnection();
+	auto cancellable = Gio::Cancellable::create();
+	for (std::size_t index = 0; index < m_entries.size(); index++)
+	{
+		client.call(
+			m_entries[index].operation, m_group.m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, m_entries[index].method,
+			m_entries[index].parameters,
+			[connection, state, index](Glib::RefPtr<Gio::AsyncResult> &result)
+			{
+				try
+				{
+					connection->call_finish(result);
+				}
+				catch (Glib::Error const &e)
+				{
+					state->entryErrors[index] = e;
+				}
+				state->finish();
+			},
+			cancellable
+		);
+	}
+
+	client.call(
+		Client::Operation::Commit, m_group.m_objectPath, AVAHI_DBUS_INTERFACE_ENTRY_GROUP, "Commit",
+		Glib::VariantContainerBase(),
+		[connection, state](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			try
+			{
+				connection->call_finish(result);
+			}
+			catch (Glib::Error const &e)
+			{
+				state->commitError = e;
+			}
+			state->finish();
+		},
+		cancellable
+	);
+
+	for (auto const &entry : m_entries)
+		m_group.remember(entry);
+	m_group.m_committed = true;
+	m_group.m_txtGeneration++;
+	m_entries.clear();
+
+	return cancellable;
 }
 
 } /* namespace Avahi */
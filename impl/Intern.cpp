@@ -0,0 +1,40 @@
+/**
+ *  \file
+ *  \brief Interning of frequently repeated strings
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include "../Intern.hpp"               // IWYU pragma: associated
+
+namespace Avahi {
+
+std::string const &Atom::str() const
+{
+	static std::string const empty;
+
+	return m_string ? *m_string : empty;
+}
+
+Atom InternTable::intern(std::string_view string)
+{
+	if (string.empty())
+		return Atom();
+
+	auto it = m_index.find(string);
+	if (it != m_index.end())
+		return Atom(it->second);
+
+	auto const &stored = m_strings.emplace_back(string);
+	m_index.emplace(stored, &stored);
+
+	return Atom(&stored);
+}
+
+Atom InternTable::find(std::string_view string) const
+{
+	auto it = m_index.find(string);
+	return it != m_index.end() ? Atom(it->second) : Atom();
+}
+
+} /* namespace Avahi */
@@ -0,0 +1,150 @@
+/**
+ *  \file
+ *  \brief Batch of coalesced item events of a browser
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Internal header, not part of the public API.
+ */
+
+#ifndef SRC_AVAHI_IMPL_ITEMBATCH_HPP_
+#define SRC_AVAHI_IMPL_ITEMBATCH_HPP_
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glibmm/main.h>
+#include <sigc++/connection.h>
+#include <sigc++/functors/slot.h>
+
+#include <glib.h>                      // G_PRIORITY_DEFAULT
+
+namespace Avahi {
+
+/** Items added/removed since the last on_itemsChanged of a browser (see
+ *  ServiceBrowser::setCoalescing()).  \a Item is the persistent item type
+ *  of the browser.
+ *
+ *  A removal of an item which has been added within the same batch is
+ *  looked up via a hash index and leaves a tombstone, so every event costs
+ *  O(1), also during a flap storm.  The batch is flushed from an idle
+ *  handler at default priority (i.e. once per main loop iteration, also
+ *  while D-Bus signals keep arriving) or as soon as #MaxSize events have
+ *  been buffered.
+ */
+template <typename Item>
+class ItemBatch
+{
+public:   // types
+	/** Invoked when the batch shall be delivered (see take()). */
+	using SlotFlush = sigc::slot<void()>;
+
+	/** Number of buffered events after which push() requests a flush. */
+	static constexpr std::size_t MaxSize = 256;
+
+public:   // methods
+	explicit ItemBatch(SlotFlush const &flush)
+	: m_flush(flush)
+	, m_size(0)
+	{}
+	~ItemBatch() { m_idle.disconnect(); }
+	ItemBatch(ItemBatch const &other) = delete;
+	ItemBatch& operator=(ItemBatch const &other) = delete;
+
+	/** Cancels a pending addition with \a hash for which \a equal returns
+	 *  true.  Returns false if there is none. */
+	template <typename Equal>
+	bool cancelAdded(std::size_t hash, Equal const &equal)
+	{
+		auto [first, last] = m_index.equal_range(hash);
+		for (auto it = first; it != last; ++it)
+		{
+			auto &slot = m_added[it->second];
+			if (!equal(slot.item))
+				continue;
+
+			slot.valid = false;  // tombstone
+			m_index.erase(it);
+			m_size--;
+			return true;
+		}
+		return false;
+	}
+
+	/** Adds an event and schedules the flush.  Returns true if the batch
+	 *  is full and should be delivered at once. */
+	bool push(bool isNew, std::size_t hash, Item &&item)
+	{
+		if (isNew)
+		{
+			m_index.emplace(hash, m_added.size());
+			m_added.push_back(Slot{std::move(item), true});
+		}
+		else
+		{
+			m_removed.push_back(std::move(item));
+		}
+		m_size++;
+
+		if (!m_idle.connected())
+		{
+			m_idle = Glib::MainContext::get_thread_default()->signal_idle().connect([this]
+			{
+				/* release the connection without disconnecting the running handler */
+				m_idle = sigc::connection();
+				m_flush();
+				return false;  // disconnect
+			}, G_PRIORITY_DEFAULT);
+		}
+		return m_size >= MaxSize;
+	}
+
+	/** Moves the current batch to \a added and \a removed and starts a new
+	 *  one.  Returns false if the batch contains no events. */
+	bool take(std::vector<Item> &added, std::vector<Item> &removed)
+	{
+		m_idle.disconnect();
+
+		if (m_size)
+		{
+			added.reserve(m_added.size());
+			for (auto &slot : m_added)
+			{
+				if (slot.valid)
+					added.push_back(std::move(slot.item));
+			}
+			removed = std::move(m_removed);
+		}
+
+		bool const result = m_size;
+		m_added.clear();
+		m_removed.clear();
+		m_index.clear();
+		m_size = 0;
+		return result;
+	}
+
+private:  // types
+	struct Slot
+	{
+		Item item;
+		/** Cleared when removed within the same batch. */
+		bool valid;
+	};
+
+private:  // members
+	SlotFlush m_flush;
+	sigc::connection m_idle;
+	std::vector<Slot> m_added;
+	std::vector<Item> m_removed;
+	/** Indices in #m_added of the valid slots by hash. */
+	std::unordered_multimap<std::size_t, std::size_t> m_index;
+	/** Number of events (without tombstones). */
+	std::size_t m_size;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_IMPL_ITEMBATCH_HPP_ */
@@ -0,0 +1,84 @@
+/**
+ *  \file
+ *  \brief Counters and latency histograms for Client instrumentation
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+
+#include "../Metrics.hpp"              // IWYU pragma: associated
+
+namespace Avahi {
+
+namespace {
+
+std::size_t bucketOf(std::uint64_t usec)
+{
+	std::size_t bucket = 0;
+
+	while (usec > 1 && bucket < Histogram::Buckets - 1)
+	{
+		usec >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+}  // namespace
+
+std::uint64_t Histogram::Snapshot::percentile(double p) const
+{
+	/* the buckets may not add up to count (see Snapshot) */
+	std::uint64_t total = 0;
+	for (auto const bucket : buckets)
+		total += bucket;
+	if (!total)
+		return 0;
+
+	auto const rank = static_cast<std::uint64_t>(std::clamp(p, 0.0, 1.0) * (total - 1)) + 1;
+	std::uint64_t seen = 0;
+
+	for (std::size_t bucket = 0; bucket < Buckets; bucket++)
+	{
+		seen += buckets[bucket];
+		if (seen >= rank)
+			return std::min<std::uint64_t>((std::uint64_t(2) << bucket) - 1, max_usec);
+	}
+	return max_usec;
+}
+
+void Histogram::record(std::uint64_t usec) noexcept
+{
+	m_buckets[bucketOf(usec)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(usec, std::memory_order_relaxed);
+
+	auto max = m_max.load(std::memory_order_relaxed);
+	while (usec > max && !m_max.compare_exchange_weak(max, usec, std::memory_order_relaxed))
+		;
+}
+
+Histogram::Snapshot Histogram::snapshot() const noexcept
+{
+	Snapshot snapshot;
+
+	for (std::size_t bucket = 0; bucket < Buckets; bucket++)
+		snapshot.buckets[bucket] = m_buckets[bucket].load(std::memory_order_relaxed);
+	snapshot.count    = m_count.load(std::memory_order_relaxed);
+	snapshot.sum_usec = m_sum.load(std::memory_order_relaxed);
+	snapshot.max_usec = m_max.load(std::memory_order_relaxed);
+
+	return snapshot;
+}
+
+void Histogram::reset() noexcept
+{
+	for (auto &bucket : m_buckets)
+		bucket.store(0, std::memory_order_relaxed);
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+} /* namespace Avahi */
@@ -0,0 +1,253 @@
+/**
+ *  \file
+ *  \brief Aggregated browsing of many service types
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include <giomm/cancellable.h>
+#include <glibmm/error.h>
+
+#include "../Client.hpp"
+#include "../MultiServiceBrowser.hpp"  // IWYU pragma: associated
+#include "../ServiceBrowser.hpp"
+
+namespace Avahi {
+
+/** Owned by the MultiServiceBrowser; the creation completion only holds a
+ *  weak reference. */
+struct MultiServiceBrowser::Browse
+{
+	Browse(MultiServiceBrowser &owner, TypeId typeId, ServiceType const &type)
+	: owner(owner)
+	, typeId(typeId)
+	, type(type)
+	, allForNow(false)
+	{}
+
+	MultiServiceBrowser &owner;
+	TypeId typeId;
+	ServiceType type;
+	Glib::RefPtr<Gio::Cancellable> creating;
+	std::shared_ptr<ServiceBrowser> browser;
+	bool allForNow;
+};
+
+MultiServiceBrowser::MultiServiceBrowser(Client &client, Interface interface, Protocol protocol,
+        Domain const &domain, ::AvahiLookupFlags flags)
+: m_client(client)
+, m_interface(interface)
+, m_protocol(protocol)
+, m_domain(domain)
+, m_flags(flags)
+, m_allForNow(false)
+{
+}
+
+MultiServiceBrowser::~MultiServiceBrowser()
+{
+	/* the completions of pending creations only hold weak references */
+	for (auto const &browse : m_types)
+	{
+		if (browse->creating)
+			browse->creating->cancel();
+	}
+	if (m_discovery && m_discovery->creating)
+		m_discovery->creating->cancel();
+}
+
+MultiServiceBrowser::TypeId MultiServiceBrowser::addType(ServiceType const &type)
+{
+	auto it = m_typeIds.find(type.raw());
+	if (it != m_typeIds.end())
+		return it->second;
+
+	if (m_types.size() >= std::numeric_limits<TypeId>::max())
+	{
+		on_errorLog("MultiServiceBrowser: Too many service types");
+		return std::numeric_limits<TypeId>::max();
+	}
+
+	auto const typeId = static_cast<TypeId>(m_types.size());
+	auto browse = std::make_shared<Browse>(*this, typeId, type);
+	m_types.push_back(browse);
+	m_typeIds.emplace(type.raw(), typeId);
+	m_allForNow = false;
+
+	create(browse);
+	on_typeAdded(typeId, type);
+	return typeId;
+}
+
+void MultiServiceBrowser::addTypes(std::vector<ServiceType> const &types)
+{
+	/* The "ServiceBrowserPrepare" calls are sent without waiting for the
+	 * responses. */
+	for (auto const &type : types)
+		addType(type);
+}
+
+void MultiServiceBrowser::discover()
+{
+	if (m_discovery)
+		return;
+
+	m_discovery = std::make_shared<Browse>(*this, std::numeric_limits<TypeId>::max(), ServiceType());
+	m_allForNow = false;
+	create(m_discovery);
+}
+
+ServiceType const &MultiServiceBrowser::getType(TypeId typeId) const
+{
+	return m_types.at(typeId)->type;
+}
+
+std::optional<MultiServiceBrowser::TypeId> MultiServiceBrowser::findType(StringView type) const
+{
+	auto it = m_typeIds.find(std::string(type));
+	if (it == m_typeIds.end())
+		return std::nullopt;
+	return it->second;
+}
+
+std::size_t MultiServiceBrowser::typeCount() const
+{
+	return m_types.size();
+}
+
+std::vector<MultiServiceBrowser::Item const *> MultiServiceBrowser::items() const
+{
+	std::vector<Item const *> result;
+
+	result.reserve(m_items.size());
+	for (auto const &[key, item] : m_items)
+		result.push_back(&item);
+	return result;
+}
+
+std::vector<MultiServiceBrowser::Item const *> MultiServiceBrowser::items(TypeId typeId) const
+{
+	std::vector<Item const *> result;
+
+	/* the index is ordered by type id first */
+	auto it = m_items.lower_bound(ItemKey{typeId, std::numeric_limits<Interface>::min(), std::numeric_limits<Protocol>::min(), std::string()});
+	for (; it != m_items.end() && std::get<0>(it->first) == typeId; ++it)
+		result.push_back(&it->second);
+	return result;
+}
+
+bool MultiServiceBrowser::allForNow() const
+{
+	return m_allForNow;
+}
+
+void MultiServiceBrowser::create(std::shared_ptr<Browse> const &browse)
+{
+	browse->creating = m_client.async_createServiceBrowser(m_interface, m_protocol, browse->type, m_domain, m_flags,
+		[weak = std::weak_ptr<Browse>(browse)](std::shared_ptr<ServiceBrowser> const &browser, Glib::Error const &error)
+		{
+			auto browse = weak.lock();
+			if (!browse)
+				return;  // owner has been destroyed in the meantime
+
+			auto &owner = browse->owner;
+			browse->creating.reset();
+			if (error)
+			{
+				std::stringstream ss;
+
+				ss << "MultiServiceBrowser: Cannot create service browser for \"" << browse->type << "\": " << error.what();
+				owner.on_errorLog(ss.str().c_str());
+				owner.on_failure(browse->typeId, error.what());
+				owner.onAllForNow(*browse);  // nothing more to wait for
+				return;
+			}
+
+			/* The browser is owned by 'browse', which is owned by the owner,
+			 * so capturing raw pointers is safe. */
+			auto *raw = browse.get();
+			browser->on_errorLog.connect([raw](char const *message)
+			{
+				raw->owner.on_errorLog(message);
+			});
+			browser->on_itemNewView.connect([raw](ServiceBrowser::ItemView const &item)
+			{
+				raw->owner.onItem(*raw, true, item);
+			});
+			browser->on_itemRemoveView.connect([raw](ServiceBrowser::ItemView const &item)
+			{
+				raw->owner.onItem(*raw, false, item);
+			});
+			browser->on_allForNow.connect([raw]
+			{
+				raw->owner.onAllForNow(*raw);
+			});
+			browser->on_failure.connect([raw](Error const &message)
+			{
+				raw->owner.on_failure(raw->typeId, message);
+				raw->owner.onAllForNow(*raw);
+			});
+			browse->browser = browser;
+		});
+}
+
+void MultiServiceBrowser::onItem(Browse &browse, bool isNew, ServiceBrowser::ItemView const &item)
+{
+	if (&browse == m_discovery.get())
+	{
+		/* only the types are of interest */
+		if (isNew && !item.type.empty())
+			addType(ServiceType(item.type.begin(), item.type.end()));
+		return;
+	}
+
+	ItemKey key{browse.typeId, item.interface, item.protocol, std::string(item.name)};
+	if (isNew)
+	{
+		auto [it, inserted] = m_items.try_emplace(std::move(key));
+		if (!inserted)
+			return;
+
+		it->second = Item{browse.typeId, item.interface, item.protocol,
+		                  ServiceName(item.name.begin(), item.name.end()), item.flags};
+		on_item(true, browse.typeId, item);
+	}
+	else
+	{
+		auto it = m_items.find(key);
+		if (it == m_items.end())
+			return;
+
+		on_item(false, browse.typeId, item);
+		m_items.erase(key);  // 'it' may have been invalidated by the handler
+	}
+}
+
+void MultiServiceBrowser::onAllForNow(Browse &browse)
+{
+	browse.allForNow = true;
+	checkAllForNow();
+}
+
+void MultiServiceBrowser::checkAllForNow()
+{
+	if (m_allForNow)
+		return;
+
+	if (m_discovery && !m_discovery->allForNow)
+		return;
+	for (auto const &browse : m_types)
+	{
+		if (!browse->allForNow)
+			return;
+	}
+
+	m_allForNow = true;
+	on_allForNow();
+}
+
+} /* namespace Avahi */
@@ -0,0 +1,371 @@
+/**
+ *  \file
+ *  \brief Bulk reconfirmation of all records of a service or host
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <iterator>                    // std::back_inserter
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <giomm/cancellable.h>
+#include <glibmm/error.h>
+#include <glibmm/main.h>
+#include <glibmm/refptr.h>
+#include <glibmm/ustring.h>
+#include <sigc++/connection.h>
+#include <sigc++/functors/mem_fun.h>
+
+#include <avahi-common/address.h>      // AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC
+#include <avahi-common/defs.h>         // AVAHI_DNS_*
+#include <avahi-common/domain.h>       // ::avahi_service_name_join()
+#include <avahi-common/error.h>        // ::avahi_strerror()
+#include <glib.h>                      // G_IO_ERROR
+
+#include "../RecordBrowser.hpp"
+#include "../RecordDecoder.hpp"
+#include "../Client.hpp"               // IWYU pragma: associated
+
+namespace Avahi {
+
+namespace {
+
+/** Name of the reverse lookup PTR record for \a address (e.g.
+ *  "1.0.168.192.in-addr.arpa"). */
+std::string reverseName(AddressView const &address)
+{
+	static char const hex[] = "0123456789abcdef";
+	std::string result;
+
+	if (address.aprotocol == AVAHI_PROTO_INET)
+	{
+		for (std::size_t i = address.bytes.size(); i-- > 0;)
+			result += std::to_string(address.bytes[i]) + '.';
+		result += "in-addr.arpa";
+	}
+	else
+	{
+		for (std::size_t i = address.bytes.size(); i-- > 0;)
+		{
+			result += hex[address.bytes[i] & 0x0f];
+			result += '.';
+			result += hex[address.bytes[i] >> 4];
+			result += '.';
+		}
+		result += "ip6.arpa";
+	}
+	return result;
+}
+
+}  // namespace
+
+class Client::Reconfirm : public std::enable_shared_from_this<Reconfirm>
+{
+public:   // methods
+	Reconfirm(Client &client, SlotReconfirm const &completion, Glib::RefPtr<Gio::Cancellable> const &cancellable);
+	~Reconfirm();
+	Reconfirm(Reconfirm const &other) = delete;
+	Reconfirm& operator=(Reconfirm const &other) = delete;
+
+	/** Also reconfirms the reverse lookup PTR records (pointing to \a host)
+	 *  of all found A/AAAA records. */
+	void setHost(std::string const &host) { m_host = host; }
+
+	/** Starts browsing all records \a name / \a type.  If \a target is not
+	 *  empty, only name records pointing to \a target are reconfirmed. */
+	void browse(std::string const &name, RecordType type, std::string const &target = {});
+
+	/** Must be called after the initial browse() calls.  A non-empty \a error
+	 *  is reported to the completion handler. */
+	void start(Glib::Error const &error = Glib::Error());
+
+private:  // types
+	/** Identity of a record (for reconfirming it only once). */
+	using RecordKey = std::tuple<Interface, Protocol, std::string, RecordClass, RecordType, RecordData>;
+
+private:  // methods
+	void onCreated(std::shared_ptr<RecordBrowser> const &browser, std::string const &target);
+	void onItem(RecordBrowser::ItemView const &item, std::string const &target);
+	/** Stops waiting for \a browser (its records have all been seen). */
+	void retire(RecordBrowser const *browser);
+	void onCancelled();
+	void onSession(bool available);
+	/** Records the first error. */
+	void fail(Glib::Error const &error);
+	void done();
+	void checkDone();
+
+private:  // members
+	Client &m_client;
+	SlotReconfirm m_completion;
+	Glib::RefPtr<Gio::Cancellable> m_cancellable;
+	gulong m_cancelHandler;
+	std::string m_host;
+
+	/** (name, type) of all started browsers. */
+	std::set<std::pair<std::string, RecordType>> m_browsed;
+	std::set<RecordKey> m_records;
+	/** Cancellables of all own calls (for forwarding cancellation). */
+	std::vector<Glib::RefPtr<Gio::Cancellable>> m_calls;
+	std::vector<std::shared_ptr<RecordBrowser>> m_browsers;
+	/** Browsers which are done (they cannot be destroyed from within their
+	 *  own signal handlers). */
+	std::vector<std::shared_ptr<RecordBrowser>> m_retired;
+	/** Browsers being created or browsing plus reconfirmations in flight. */
+	std::size_t m_pending;
+	Glib::Error m_error;
+	sigc::connection m_done;
+};
+
+Client::Reconfirm::Reconfirm(Client &client, SlotReconfirm const &completion, Glib::RefPtr<Gio::Cancellable> const &cancellable)
+: m_client(client)
+, m_completion(completion)
+, m_cancellable(cancellable)
+, m_cancelHandler(0)
+, m_pending(0)
+{
+	m_client.registerSession(this, sigc::mem_fun(*this, &Reconfirm::onSession));
+}
+
+Client::Reconfirm::~Reconfirm()
+{
+	m_done.disconnect();
+	if (m_cancelHandler)
+		m_cancellable->disconnect(m_cancelHandler);
+	for (auto const &call : m_calls)
+		call->cancel();
+	m_client.unregisterSession(this);
+}
+
+void Client::Reconfirm::start(Glib::Error const &error)
+{
+	if (error)
+		fail(error);
+
+	/* connecting invokes the handler at once if already cancelled */
+	m_cancelHandler = m_cancellable->connect(sigc::mem_fun(*this, &Reconfirm::onCancelled));
+	checkDone();
+}
+
+void Client::Reconfirm::browse(std::string const &name, RecordType type, std::string const &target)
+{
+	if (!m_client.getConnection())
+	{
+		fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_NOT_CONNECTED, "Client: Not connected to Avahi daemon"));
+		return;
+	}
+	if (m_cancellable->is_cancelled())
+		return;
+	if (!m_browsed.emplace(name, type).second)
+		return;  // already browsing
+
+	m_pending++;
+	m_calls.push_back(m_client.async_createRecordBrowser(AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC,
+		name, AVAHI_DNS_CLASS_IN, type, static_cast<::AvahiLookupFlags>(0),
+		[weak = weak_from_this(), target](std::shared_ptr<RecordBrowser> const &browser, Glib::Error const &error)
+		{
+			auto self = weak.lock();
+			if (!self)
+				return;
+
+			if (error)
+			{
+				self->fail(error);
+				self->m_pending--;
+				self->checkDone();
+				return;
+			}
+			self->onCreated(browser, target);
+		}));
+}
+
+void Client::Reconfirm::onCreated(std::shared_ptr<RecordBrowser> const &browser, std::string const &target)
+{
+	auto const *key = browser.get();
+
+	browser->on_itemNewView.connect([this, target](RecordBrowser::ItemView const &item)
+	{
+		onItem(item, target);
+	});
+	/* All records to reconfirm are cached ones, so waiting for
+	 * "AllForNow" is only required if the cache is not used. */
+	browser->on_cacheExhausted.connect([this, key] { retire(key); });
+	browser->on_allForNow.connect([this, key] { retire(key); });
+	browser->on_failure.connect([this, key](Error const &error)
+	{
+		fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_FAILED, "Client: Record browser failed: " + error));
+		retire(key);
+	});
+
+	if (m_cancellable->is_cancelled())
+	{
+		/* cancelled after the browser has been created */
+		m_retired.push_back(browser);
+		m_pending--;
+		checkDone();
+		return;
+	}
+	m_browsers.push_back(browser);
+}
+
+void Client::Reconfirm::onItem(RecordBrowser::ItemView const &item, std::string const &target)
+{
+	if (m_cancellable->is_cancelled() || !m_client.getConnection())
+		return;
+
+	if (!target.empty())
+	{
+		auto const name = decodeName(item.rdata);
+		if (!name || !name->equals(target))
+			return;
+	}
+
+	if (!m_records.emplace(item.interface, item.protocol, std::string(item.name), item.clazz, item.type, item.rdata.toVector()).second)
+		return;  // already reconfirmed (e.g. reported by several browsers)
+
+	if (!m_host.empty())
+	{
+		if (auto const address = decodeAddress(item.type, item.rdata))
+			browse(reverseName(*address), AVAHI_DNS_TYPE_PTR, m_host);
+	}
+
+	m_pending++;
+	m_calls.push_back(m_client.async_reconfirmRecord(item.interface, item.protocol,
+		RecordName(item.name.begin(), item.name.end()), item.clazz, item.type, item.rdata.toVector(),
+		[weak = weak_from_this()](Glib::Error const &error)
+		{
+			auto self = weak.lock();
+			if (!self)
+				return;
+
+			if (error)
+				self->fail(error);
+			self->m_pending--;
+			self->checkDone();
+		}));
+}
+
+void Client::Reconfirm::retire(RecordBrowser const *browser)
+{
+	auto it = std::find_if(m_browsers.begin(), m_browsers.end(), [browser](auto const &candidate)
+	{
+		return candidate.get() == browser;
+	});
+	if (it == m_browsers.end())
+		return;  // already done
+
+	m_retired.push_back(std::move(*it));
+	m_browsers.erase(it);
+	m_pending--;
+	checkDone();
+}
+
+void Client::Reconfirm::onCancelled()
+{
+	m_cancelHandler = 0;
+	m_error = Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Operation was cancelled");
+
+	/* pending calls complete (with an error) later on */
+	for (auto const &call : m_calls)
+		call->cancel();
+
+	m_pending -= m_browsers.size();
+	std::move(m_browsers.begin(), m_browsers.end(), std::back_inserter(m_retired));
+	m_browsers.clear();
+	checkDone();
+}
+
+void Client::Reconfirm::onSession(bool available)
+{
+	if (available)
+		return;
+
+	/* the browsers will not report anything anymore, pending calls fail */
+	if (m_client.getConnection())
+		fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_CANCELLED, "Client: All objects have been released"));
+	else
+		fail(Glib::Error(G_IO_ERROR, G_IO_ERROR_FAILED, "Client: Avahi daemon has vanished"));
+	m_pending -= m_browsers.size();
+	std::move(m_browsers.begin(), m_browsers.end(), std::back_inserter(m_retired));
+	m_browsers.clear();
+	checkDone();
+}
+
+void Client::Reconfirm::fail(Glib::Error const &error)
+{
+	if (!m_error)
+		m_error = error;
+}
+
+void Client::Reconfirm::checkDone()
+{
+	if (m_pending || m_done.connected())
+		return;
+
+	m_done = Glib::MainContext::get_thread_default()->signal_idle().connect([this]
+	{
+		done();
+		return false;  // disconnect
+	});
+}
+
+void Client::Reconfirm::done()
+{
+	/* release the connection without disconnecting the running handler */
+	m_done = sigc::connection();
+	if (m_pending)
+		return;  // new work has been started in the meantime
+
+	auto const completion = m_completion;
+	auto const error = m_error;
+	auto const records = m_records.size();
+
+	m_client.m_reconfirms.erase(this);  // destroys this object
+	completion(records, error);
+}
+
+Glib::RefPtr<Gio::Cancellable> Client::async_reconfirmService(ServiceName const &name, ServiceType const &type,
+        Domain const &domain, SlotReconfirm const &completion)
+{
+	auto const &domainName = domain.empty() ? Domain("local") : domain;
+	auto cancellable = Gio::Cancellable::create();
+	auto reconfirm = std::make_shared<Reconfirm>(*this, completion, cancellable);
+	m_reconfirms.emplace(reconfirm.get(), reconfirm);
+
+	char service[AVAHI_DOMAIN_NAME_MAX];
+	auto const result = ::avahi_service_name_join(service, sizeof(service), name.c_str(), type.c_str(), domainName.c_str());
+	if (result < 0)
+	{
+		reconfirm->start(Glib::Error(G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+			Glib::ustring("Client: Invalid service: ") + ::avahi_strerror(result)));
+		return cancellable;
+	}
+
+	reconfirm->browse(type + "." + domainName, AVAHI_DNS_TYPE_PTR, service);
+	reconfirm->browse(service, AVAHI_DNS_TYPE_SRV);
+	reconfirm->browse(service, AVAHI_DNS_TYPE_TXT);
+	reconfirm->start();
+
+	return cancellable;
+}
+
+Glib::RefPtr<Gio::Cancellable> Client::async_reconfirmHost(Host const &host, SlotReconfirm const &completion)
+{
+	auto cancellable = Gio::Cancellable::create();
+	auto reconfirm = std::make_shared<Reconfirm>(*this, completion, cancellable);
+	m_reconfirms.emplace(reconfirm.get(), reconfirm);
+
+	reconfirm->setHost(host);
+	reconfirm->browse(host, AVAHI_DNS_TYPE_ANY);
+	reconfirm->start();
+
+	return cancellable;
+}
+
+} /* namespace Avahi */
@@ -5,196 +5,248 @@
  *  \copyright 2023 ARRI Lighting Stephanskirchen
  */
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <sstream>
-#include <tuple>
-#include <typeinfo>                    // std::bad_cast
+#include <string_view>
 
-#include <giomm/dbusconnection.h>
 #include <glibmm/error.h>
+#include <glibmm/main.h>
 #include <glibmm/refptr.h>
 #include <glibmm/variant.h>
+#include <sigc++/functors/mem_fun.h>
 
-#include <avahi-common/dbus.h>
-#include <glib.h>                      // G_MAXINT
+#include <avahi-common/defs.h>         // AVAHI_DNS_TYPE_*
 
 #include "../Client.hpp"
 #include "../RecordBrowser.hpp"        // IWYU pragma: associated
-
-namespace Gio { class AsyncResult; }
+#include "ItemBatch.hpp"
+#include "SharedBrowser.hpp"
+#include "SignalTable.hpp"
 
 namespace Avahi {
 
-RecordBrowser::RecordBrowser(Token, Client &client, Glib::ustring const &objectPath)
+namespace {
+
+std::size_t itemHash(Interface interface, Protocol protocol, std::string_view name, RecordClass clazz,
+                     RecordType type, ByteView rdata)
+{
+	std::hash<std::string_view> const hash;
+	std::string_view const data(reinterpret_cast<char const *>(rdata.data()), rdata.size());
+
+	return hash(name) ^ (hash(data) * 31) ^ (std::hash<int>()(interface) << 1) ^
+	       (std::hash<int>()(protocol) << 3) ^ (std::size_t(clazz) << 5) ^ (std::size_t(type) << 21);
+}
+
+}  // namespace
+
+RecordBrowser::RecordBrowser(Token, Client &client, std::shared_ptr<SharedBrowser> const &shared, BrowseFilter const &filter)
 : m_client(client)
-, m_objectPath(objectPath)
+, m_shared(shared)
+, m_filter(filter)
+, m_coalescing(false)
 {
-	auto const &connection = m_client.getConnection();
-
-	m_itemNew = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Flags = std::uint32_t;
-			using Params = std::tuple<Interface, Protocol, RecordName, RecordClass, RecordType, RecordData, Flags>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[interface, protocol, name, clazz, type, rdata, flags] = params.get();
-
-				on_itemNew(interface, protocol, name, static_cast<RecordClass>(clazz), static_cast<RecordType>(type), rdata, static_cast<::AvahiLookupResultFlags>(flags));
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("RecordBrowser: Cannot parse \"ItemNew\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
-		"ItemNew",
-		m_objectPath);
-
-	m_itemRemove = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Flags = std::uint32_t;
-			using Params = std::tuple<Interface, Protocol, RecordName, RecordClass, RecordType, RecordData, Flags>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[interface, protocol, name, clazz, type, rdata, flags] = params.get();
-
-				on_itemRemove(interface, protocol, name, static_cast<RecordClass>(clazz), static_cast<RecordType>(type), rdata, static_cast<::AvahiLookupResultFlags>(flags));
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("RecordBrowser: Cannot parse \"ItemRemove\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
-		"ItemRemove",
-		m_objectPath);
-
-	m_failure = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
+	m_shared->subscribe(this, sigc::mem_fun(*this, &RecordBrowser::onSignal), [this](char const *error)
+	{
+		on_errorLog(error);
+	});
+}
+
+RecordBrowser::~RecordBrowser()
+{
+	m_shared->unsubscribe(this);
+	m_client.releaseBrowser(m_shared);
+}
+
+void RecordBrowser::setCoalescing(bool enable)
+{
+	m_coalescing = enable;
+	if (enable && !m_batch)
+		m_batch = std::make_unique<ItemBatch<Item>>([this] { flushItems(); });
+	if (!enable)
+		flushItems();
+}
+
+void RecordBrowser::onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	static constexpr SignalHandler<RecordBrowser> handlers[] = {
+		signalHandler<&RecordBrowser::onItemNew>("ItemNew"),
+		signalHandler<&RecordBrowser::onItemRemove>("ItemRemove"),
+		signalHandler<&RecordBrowser::onFailure>("Failure"),
+		signalHandler<&RecordBrowser::onAllForNow>("AllForNow"),
+		signalHandler<&RecordBrowser::onCacheExhausted>("CacheExhausted"),
+	};
+
+	if (dispatchSignal(handlers, *this, signalName, parameters) == SignalResult::ParseError)
+	{
+		std::stringstream ss;
+
+		ss << "RecordBrowser: Cannot parse \"" << signalName << "\" parameters";
+		m_client.parseError();
+		on_errorLog(ss.str().c_str());
+	}
+}
+
+void RecordBrowser::onItemNew(Interface interface, Protocol protocol, StringView name, RecordClass clazz,
+                              RecordType type, ByteView rdata, std::uint32_t flags)
+{
+	onItem(true, ItemView{interface, protocol, name, clazz, type, rdata, static_cast<::AvahiLookupResultFlags>(flags)});
+}
+
+void RecordBrowser::onItemRemove(Interface interface, Protocol protocol, StringView name, RecordClass clazz,
+                                 RecordType type, ByteView rdata, std::uint32_t flags)
+{
+	onItem(false, ItemView{interface, protocol, name, clazz, type, rdata, static_cast<::AvahiLookupResultFlags>(flags)});
+}
+
+void RecordBrowser::onItem(bool isNew, ItemView const &item)
+{
+	/* several signals are emitted, a handler may release the last handle */
+	auto const self = shared_from_this();
+
+	/* Name and rdata point into the received message; they are only copied
+	 * if someone is connected to the non-view signals. */
+	if (!m_filter.empty())
+	{
+		if (!m_filter.matchItem(item.interface, item.protocol, item.name))
+			return;
+
+		/* TXT conditions only apply to TXT records */
+		if (m_filter.hasTxtConditions() && item.type == AVAHI_DNS_TYPE_TXT)
 		{
-			using Params = std::tuple<Error>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[error] = params.get();
-
-				on_failure(error);
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("RecordBrowser: Cannot parse \"Failure\" parameters");
+			auto const txt = decodeTxt(item.rdata);
+			if (!txt || !m_filter.matchTxt(*txt))
 				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
-		"Failure",
-		m_objectPath);
-
-	m_allForNow = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &/*parameters*/)
-		{
-			on_allForNow();
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
-		"AllForNow",
-		m_objectPath);
-
-	m_cacheExhausted = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &/*parameters*/)
-		{
-			on_cacheExhausted();
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_RECORD_BROWSER,
-		"CacheExhausted",
-		m_objectPath);
-
-	/* Start service browser after registering all signals handlers */
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_RECORD_BROWSER, "Start",
-		Glib::VariantContainerBase(),
-		[this,connection](Glib::RefPtr<Gio::AsyncResult> &result)
-		{
-			try
-			{
-				connection->call_finish(result);
-			}
-			catch (Glib::Error const &e)
-			{
-				std::stringstream ss;
-
-				ss << "RecordBrowser: D-Bus call \"Start\" failed: " << e.what();
-				on_errorLog(ss.str().c_str());
-			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+		}
+	}
+	if (m_coalescing)
+		coalesce(isNew, item);
+
+	auto &viewSignal = isNew ? on_itemNewView : on_itemRemoveView;
+	auto &signal = isNew ? on_itemNew : on_itemRemove;
+
+	viewSignal(item);
+	emitDecoded(isNew, item);
+	if (!signal.empty())
+		signal(item.interface, item.protocol,
+		       RecordName(item.name.begin(), item.name.end()),
+		       item.clazz, item.type, item.rdata.toVector(), item.flags);
 }
 
-RecordBrowser::~RecordBrowser()
+void RecordBrowser::onFailure(StringView error)
 {
-	auto const &connection = m_client.getConnection();
+	on_failure(Error(error.data(), error.size()));
+}
 
-	if (connection)
+void RecordBrowser::onAllForNow()
+{
+	if (m_coalescing)
 	{
-		connection->signal_unsubscribe(m_itemNew);
-		connection->signal_unsubscribe(m_itemRemove);
-		connection->signal_unsubscribe(m_failure);
-		connection->signal_unsubscribe(m_allForNow);
-		connection->signal_unsubscribe(m_cacheExhausted);
-		connection->call(
-			m_objectPath, AVAHI_DBUS_INTERFACE_RECORD_BROWSER, "Free",
-			Glib::VariantContainerBase(),
-			[](Glib::RefPtr<Gio::AsyncResult> &/*result*/)
-			{
-				/* we are not interested in the result, so there's no need to
-				 * run call_finish() */
-			},
-			/*bus_name*/ AVAHI_DBUS_NAME,
-			/*timeout_msec*/G_MAXINT,
-			Gio::DBus::CALL_FLAGS_NO_AUTO_START
-		);
+		auto weak = weak_from_this();
+
+		/* on_itemsChanged handler may destroy this object */
+		flushItems();
+		if (weak.expired())
+			return;
 	}
+	on_allForNow();
+}
+
+void RecordBrowser::onCacheExhausted()
+{
+	on_cacheExhausted();
+}
+
+void RecordBrowser::emitDecoded(bool isNew, ItemView const &item)
+{
+	/* a handler may release the last handle */
+	auto const self = shared_from_this();
+	bool decoded = true;
+
+	switch (item.type)
+	{
+		case AVAHI_DNS_TYPE_A:
+		case AVAHI_DNS_TYPE_AAAA:
+			if (on_addressView.empty())
+				return;
+			if (auto const address = decodeAddress(item.type, item.rdata))
+				on_addressView(isNew, item, *address);
+			else
+				decoded = false;
+			break;
+
+		case AVAHI_DNS_TYPE_PTR:
+		case AVAHI_DNS_TYPE_CNAME:
+		case AVAHI_DNS_TYPE_NS:
+			if (on_nameView.empty())
+				return;
+			if (auto const name = decodeName(item.rdata))
+				on_nameView(isNew, item, *name);
+			else
+				decoded = false;
+			break;
+
+		case AVAHI_DNS_TYPE_SRV:
+			if (on_srvView.empty())
+				return;
+			if (auto const srv = decodeSrv(item.rdata))
+				on_srvView(isNew, item, *srv);
+			else
+				decoded = false;
+			break;
+
+		case AVAHI_DNS_TYPE_TXT:
+			if (on_txtView.empty())
+				return;
+			if (auto const txt = decodeTxt(item.rdata))
+				on_txtView(isNew, item, *txt);
+			else
+				decoded = false;
+			break;
+
+		default:
+			break;
+	}
+
+	if (!decoded)
+	{
+		std::stringstream ss;
+
+		ss << "RecordBrowser: Cannot decode rdata of record \"" << item.name << "\" (type " << item.type << ")";
+		m_client.parseError();
+		on_errorLog(ss.str().c_str());
+	}
+}
+
+void RecordBrowser::coalesce(bool isNew, ItemView const &item)
+{
+	auto const hash = itemHash(item.interface, item.protocol, item.name, item.clazz, item.type, item.rdata);
+	auto const sameItem = [&item](Item const &added)
+	{
+		return added.interface == item.interface && added.protocol == item.protocol &&
+		       added.clazz == item.clazz && added.type == item.type &&
+		       added.name.raw() == item.name &&
+		       std::equal(added.rdata.begin(), added.rdata.end(), item.rdata.begin(), item.rdata.end());
+	};
+
+	if (!isNew && m_batch->cancelAdded(hash, sameItem))
+		return;  // added and removed within the same batch
+
+	bool const full = m_batch->push(isNew, hash, Item{item.interface, item.protocol,
+		RecordName(item.name.begin(), item.name.end()),
+		item.clazz, item.type, item.rdata.toVector(), item.flags});
+	if (full)
+		flushItems();
+}
+
+void RecordBrowser::flushItems()
+{
+	std::vector<Item> added, removed;
+
+	if (m_batch && m_batch->take(added, removed))
+		on_itemsChanged(added, removed);
 }
 
 } /* namespace Avahi */
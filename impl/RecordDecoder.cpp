@@ -0,0 +1,269 @@
+/**
+ *  \file
+ *  \brief Allocation free decoders for DNS record data
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <avahi-common/defs.h>         // AVAHI_DNS_TYPE_*
+
+#include "../RecordDecoder.hpp"        // IWYU pragma: associated
+#include "../TxtRecord.hpp"
+
+namespace Avahi {
+
+namespace {
+
+/** Maximum size of a domain name in wire format (RFC 1035, 3.1). */
+constexpr std::size_t maxNameSize = 255;
+/** Maximum size of a single label (RFC 1035, 2.3.4). */
+constexpr std::size_t maxLabelSize = 63;
+
+/** Results of unescapeNext() which are not a character. */
+constexpr int labelEnd = -1;
+constexpr int invalidEscape = -2;
+
+int toLower(int c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/** Returns the next (unescaped) character of the textual name \a name, or
+ *  labelEnd at a label separator / the end of \a name. */
+int unescapeNext(std::string_view name, std::size_t &pos)
+{
+	if (pos == name.size())
+		return labelEnd;
+
+	char c = name[pos++];
+	if (c == '.')
+		return labelEnd;
+	if (c != '\\')
+		return static_cast<unsigned char>(c);
+
+	if (pos == name.size())
+		return invalidEscape;
+
+	c = name[pos++];
+	if (!isDigit(c))
+		return static_cast<unsigned char>(c);
+
+	/* \DDD */
+	if (pos + 2 > name.size() || !isDigit(name[pos]) || !isDigit(name[pos + 1]))
+		return invalidEscape;
+
+	int const value = (c - '0') * 100 + (name[pos] - '0') * 10 + (name[pos + 1] - '0');
+	pos += 2;
+	return value <= 255 ? value : invalidEscape;
+}
+
+/** Same escaping as avahi_escape_label(). */
+template <typename Put>
+void escapeLabel(StringView label, Put &&put)
+{
+	for (char c : label)
+	{
+		auto const u = static_cast<unsigned char>(c);
+
+		if (c == '.' || c == '\\')
+		{
+			put('\\');
+			put(c);
+		}
+		else if (c == '_' || c == '-' || isDigit(c) ||
+		         (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+			put(c);
+		else
+		{
+			put('\\');
+			put(static_cast<char>('0' + u / 100));
+			put(static_cast<char>('0' + u / 10 % 10));
+			put(static_cast<char>('0' + u % 10));
+		}
+	}
+}
+
+std::uint16_t readUint16(ByteView data, std::size_t offset)
+{
+	return static_cast<std::uint16_t>(data[offset] << 8 | data[offset + 1]);
+}
+
+}  // namespace
+
+::AvahiAddress AddressView::toAvahiAddress() const
+{
+	::AvahiAddress address;
+
+	std::memset(&address, 0, sizeof(address));
+	address.proto = aprotocol;
+	std::memcpy(&address.data, bytes.data(), std::min(bytes.size(), sizeof(address.data)));
+
+	return address;
+}
+
+char const *AddressView::format(char *buffer, std::size_t size) const
+{
+	auto const address = toAvahiAddress();
+
+	if (!::avahi_address_snprint(buffer, size, &address) && size)
+		buffer[0] = '\0';
+	return buffer;
+}
+
+std::string AddressView::toString() const
+{
+	char buffer[AVAHI_ADDRESS_STR_MAX];
+
+	return format(buffer, sizeof(buffer));
+}
+
+std::size_t NameView::parse(ByteView data)
+{
+	std::size_t pos = 0;
+
+	while (pos < data.size() && pos < maxNameSize)
+	{
+		std::size_t const length = data[pos];
+
+		if (length == 0)
+			return pos + 1;
+		/* also rejects compression pointers (0xC0) and extended label types */
+		if (length > maxLabelSize)
+			return 0;
+		pos += 1 + length;
+	}
+	return 0;  // truncated or too long
+}
+
+bool NameView::equals(std::string_view name) const
+{
+	std::size_t pos = 0;
+
+	for (auto label : *this)
+	{
+		for (char c : label)
+		{
+			int const u = unescapeNext(name, pos);
+			if (u < 0 || toLower(u) != toLower(static_cast<unsigned char>(c)))
+				return false;
+		}
+
+		if (unescapeNext(name, pos) != labelEnd)
+			return false;
+	}
+
+	return pos == name.size() || (empty() && name == ".");
+}
+
+std::size_t NameView::format(char *buffer, std::size_t size) const
+{
+	std::size_t length = 0;
+	auto put = [buffer, size, &length](char c)
+	{
+		if (length + 1 < size)
+			buffer[length] = c;
+		length++;
+	};
+
+	bool first = true;
+	for (auto label : *this)
+	{
+		if (!first)
+			put('.');
+		first = false;
+		escapeLabel(label, put);
+	}
+
+	if (size)
+		buffer[std::min(length, size - 1)] = '\0';
+	return length;
+}
+
+std::string NameView::toString() const
+{
+	std::string result(format(nullptr, 0), '\0');
+
+	format(result.data(), result.size() + 1);
+	return result;
+}
+
+Txt TxtDataView::toTxt() const
+{
+	Txt result;
+
+	for (auto string : *this)
+		result.push_back(string.toVector());
+	return result;
+}
+
+TxtRecord TxtDataView::toTxtRecord() const
+{
+	TxtRecord result;
+
+	for (auto string : *this)
+		result.add(string);
+	return result;
+}
+
+std::optional<AddressView> decodeAddress(RecordType type, ByteView rdata)
+{
+	switch (type)
+	{
+		case AVAHI_DNS_TYPE_A:
+			if (rdata.size() != 4)
+				return std::nullopt;
+			return AddressView{AVAHI_PROTO_INET, rdata};
+
+		case AVAHI_DNS_TYPE_AAAA:
+			if (rdata.size() != 16)
+				return std::nullopt;
+			return AddressView{AVAHI_PROTO_INET6, rdata};
+
+		default:
+			return std::nullopt;
+	}
+}
+
+std::optional<NameView> decodeName(ByteView rdata)
+{
+	if (rdata.empty() || NameView::parse(rdata) != rdata.size())
+		return std::nullopt;
+
+	return NameView(rdata);
+}
+
+std::optional<SrvView> decodeSrv(ByteView rdata)
+{
+	constexpr std::size_t headerSize = 6;  // priority, weight, port
+
+	if (rdata.size() <= headerSize)
+		return std::nullopt;
+
+	ByteView const target(rdata.data() + headerSize, rdata.size() - headerSize);
+	if (NameView::parse(target) != target.size())
+		return std::nullopt;
+
+	return SrvView{readUint16(rdata, 0), readUint16(rdata, 2), readUint16(rdata, 4), NameView(target)};
+}
+
+std::optional<TxtDataView> decodeTxt(ByteView rdata)
+{
+	std::size_t pos = 0;
+
+	while (pos < rdata.size())
+		pos += 1 + rdata[pos];
+	if (pos != rdata.size())
+		return std::nullopt;
+
+	return TxtDataView(rdata);
+}
+
+} /* namespace Avahi */
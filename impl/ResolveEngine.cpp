@@ -0,0 +1,360 @@
+/**
+ *  \file
+ *  \brief Bulk resolving of browsed services with bounded concurrency
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include <giomm/cancellable.h>
+#include <glibmm/error.h>
+#include <sigc++/adaptors/bind.h>
+#include <sigc++/functors/mem_fun.h>
+
+#include "../Client.hpp"
+#include "../ServiceBrowser.hpp"
+#include "../ServiceResolver.hpp"
+#include "../ResolveEngine.hpp"        // IWYU pragma: associated
+
+namespace Avahi {
+
+/** State of a single service (name, type, domain). */
+struct ResolveEngine::Service
+{
+	enum class State
+	{
+		Queued,     /**< waiting in m_queue */
+		Creating,   /**< in flight, resolver is being created */
+		Resolving,  /**< in flight, waiting for first result */
+		Done,       /**< first result has been delivered */
+	};
+
+	ServiceName name;
+	Atom type;
+	Atom domain;
+	/** All (interface, protocol) pairs on which the service has been seen.
+	 *  The first one is used for resolving. */
+	std::vector<std::pair<Interface, Protocol>> instances;
+	int priority;
+	QueueKey queueKey;
+	State state;
+	Glib::RefPtr<Gio::Cancellable> cancellable;
+	std::shared_ptr<ServiceResolver> resolver;
+	/** Instance of the current resolver (valid unless Queued). */
+	std::pair<Interface, Protocol> resolving;
+	/** Incremented on each start(), completions of earlier attempts are
+	 *  ignored. */
+	unsigned int attempt;
+};
+
+ResolveEngine::ResolveEngine(Client &client, Mode mode, std::size_t maxInFlight, Protocol aprotocol)
+: m_client(client)
+, m_mode(mode)
+, m_maxInFlight(std::max<std::size_t>(maxInFlight, 1))
+, m_aprotocol(aprotocol)
+, m_batchDelay(0)
+, m_context(Glib::MainContext::get_thread_default())
+, m_sequence(0)
+, m_inFlight(0)
+{
+}
+
+ResolveEngine::~ResolveEngine()
+{
+	m_flush.disconnect();
+
+	/* Pending completions will find their service expired */
+	for (auto const &[key, service] : m_services)
+	{
+		if (service->cancellable)
+			service->cancellable->cancel();
+	}
+}
+
+void ResolveEngine::setMaxInFlight(std::size_t maxInFlight)
+{
+	m_maxInFlight = std::max<std::size_t>(maxInFlight, 1);
+	startPending();
+}
+
+void ResolveEngine::setBatchDelay(unsigned int delay_msec)
+{
+	m_batchDelay = delay_msec;
+}
+
+void ResolveEngine::attach(ServiceBrowser &browser, int priority)
+{
+	browser.on_itemNewView.connect(sigc::bind(sigc::mem_fun(*this, &ResolveEngine::onItemNew), priority));
+	browser.on_itemRemoveView.connect(sigc::mem_fun(*this, &ResolveEngine::onItemRemove));
+}
+
+void ResolveEngine::add(Interface interface, Protocol protocol, ServiceName const &name,
+        ServiceType const &type, Domain const &domain, int priority)
+{
+	addService(interface, protocol, name.raw(), m_client.intern(type.raw()), m_client.intern(domain.raw()), priority);
+}
+
+void ResolveEngine::remove(Interface interface, Protocol protocol, ServiceName const &name,
+        ServiceType const &type, Domain const &domain)
+{
+	removeService(interface, protocol, name.raw(), m_client.intern(type.raw()), m_client.intern(domain.raw()));
+}
+
+void ResolveEngine::addService(Interface interface, Protocol protocol, std::string_view name,
+        Atom type, Atom domain, int priority)
+{
+	auto it = m_services.find(std::make_tuple(name, type, domain));
+	if (it == m_services.end())
+	{
+		auto service = std::make_shared<Service>(Service{ServiceName(name.begin(), name.end()), type, domain,
+		                                                 {{interface, protocol}}, priority, {},
+		                                                 Service::State::Queued, {}, {}, {}, 0});
+		m_services.emplace(ServiceKey{std::string(name), type, domain}, service);
+		enqueue(*service);
+		startPending();
+		return;
+	}
+
+	auto &service = it->second;
+
+	auto const instance = std::make_pair(interface, protocol);
+	if (std::find(service->instances.begin(), service->instances.end(), instance) == service->instances.end())
+		service->instances.push_back(instance);
+
+	if (service->state == Service::State::Queued && priority > service->priority)
+	{
+		m_queue.erase(service->queueKey);
+		service->priority = priority;
+		enqueue(*service);
+	}
+}
+
+void ResolveEngine::removeService(Interface interface, Protocol protocol, std::string_view name,
+        Atom type, Atom domain)
+{
+	auto it = m_services.find(std::make_tuple(name, type, domain));
+	if (it == m_services.end())
+		return;
+
+	auto &service = *it->second;
+	auto const instance = std::make_pair(interface, protocol);
+	auto &instances = service.instances;
+	instances.erase(std::remove(instances.begin(), instances.end(), instance), instances.end());
+	if (instances.empty())
+	{
+		drop(it);
+		startPending();
+		return;
+	}
+
+	/* the resolver is bound to the vanished interface, continue on the next
+	 * instance (a finished one-shot resolver is not needed anymore) */
+	if (service.state != Service::State::Queued && service.resolving == instance &&
+	    (service.state != Service::State::Done || m_mode == Mode::KeepAlive))
+		restart(service);
+}
+
+void ResolveEngine::flush()
+{
+	m_flush.disconnect();
+	m_retired.clear();
+
+	if (m_results.empty())
+		return;
+
+	auto const results = std::move(m_results);
+	m_results.clear();
+	on_results.emit(results);
+}
+
+void ResolveEngine::onItemNew(ServiceBrowser::ItemView const &item, int priority)
+{
+	addService(item.interface, item.protocol, item.name,
+	           m_client.intern(item.type), m_client.intern(item.domain), priority);
+}
+
+void ResolveEngine::onItemRemove(ServiceBrowser::ItemView const &item)
+{
+	removeService(item.interface, item.protocol, item.name,
+	              m_client.intern(item.type), m_client.intern(item.domain));
+}
+
+void ResolveEngine::enqueue(Service &service)
+{
+	service.queueKey = QueueKey{-service.priority, m_sequence++};
+	m_queue.emplace(service.queueKey, m_services.find(std::make_tuple(std::string_view(service.name.raw()), service.type, service.domain))->second);
+}
+
+void ResolveEngine::drop(ServiceMap::iterator it)
+{
+	auto &service = *it->second;
+
+	switch (service.state)
+	{
+		case Service::State::Queued:
+			m_queue.erase(service.queueKey);
+			break;
+
+		case Service::State::Creating:
+		case Service::State::Resolving:
+			m_inFlight--;
+			break;
+
+		case Service::State::Done:
+			break;
+	}
+
+	if (service.cancellable)
+		service.cancellable->cancel();
+	if (service.resolver)
+		m_retired.push_back(std::move(service.resolver));
+
+	m_services.erase(it);
+	scheduleFlush();
+}
+
+void ResolveEngine::restart(Service &service)
+{
+	if (service.state == Service::State::Creating || service.state == Service::State::Resolving)
+		m_inFlight--;
+
+	if (service.cancellable)
+	{
+		service.cancellable->cancel();
+		service.cancellable.reset();
+	}
+	if (service.resolver)
+	{
+		m_retired.push_back(std::move(service.resolver));
+		scheduleFlush();
+	}
+
+	service.state = Service::State::Queued;
+	enqueue(service);
+	startPending();
+}
+
+void ResolveEngine::startPending()
+{
+	while (m_inFlight < m_maxInFlight && !m_queue.empty())
+	{
+		auto service = m_queue.begin()->second.lock();
+
+		m_queue.erase(m_queue.begin());
+		if (service)
+			start(service);
+	}
+}
+
+void ResolveEngine::start(std::shared_ptr<Service> const &service)
+{
+	auto const [interface, protocol] = service->instances.front();
+
+	service->state = Service::State::Creating;
+	service->resolving = service->instances.front();
+	service->attempt++;
+	m_inFlight++;
+
+	service->cancellable = m_client.async_createServiceResolver(interface, protocol,
+		service->name, ServiceType(service->type.str()), Domain(service->domain.str()), m_aprotocol, {},
+		[this, weak = std::weak_ptr<Service>(service), attempt = service->attempt](std::shared_ptr<ServiceResolver> const &resolver, Glib::Error const &error)
+		{
+			auto service = weak.lock();
+			if (!service || service->attempt != attempt)
+				return;  // service (or the whole engine) is gone, or restarted
+
+			service->cancellable.reset();
+
+			if (error)
+			{
+				auto const [interface, protocol] = service->resolving;
+
+				deliver(Result{interface, protocol, service->name, service->type, service->domain,
+				               {}, {}, {}, {}, {}, {}, error.what()});
+				finishFirst(*service);
+				return;
+			}
+
+			/* Retired resolvers may still emit signals until the next flush,
+			 * so the service is looked up again and the resolver is compared. */
+			auto lookup = [weak, current = resolver.get()]() -> std::shared_ptr<Service>
+			{
+				auto service = weak.lock();
+				return (service && service->resolver.get() == current) ? service : nullptr;
+			};
+
+			resolver->on_errorLog.connect([this](char const *message)
+			{
+				on_errorLog(message);
+			});
+			resolver->on_foundView.connect([this, lookup](ServiceResolver::FoundView const &found)
+			{
+				auto service = lookup();
+				if (!service)
+					return;
+
+				deliver(Result{found.interface, found.protocol, service->name, service->type, service->domain,
+				               Host(found.host.begin(), found.host.end()), found.aprotocol,
+				               ServiceResolver::Address(found.address.begin(), found.address.end()),
+				               found.port, TxtRecord(found.txt), found.flags, {}});
+				if (service->state == Service::State::Resolving)
+					finishFirst(*service);
+			});
+			resolver->on_failure.connect([this, lookup](Error const &message)
+			{
+				auto service = lookup();
+				if (!service)
+					return;
+
+				auto const [interface, protocol] = service->resolving;
+
+				deliver(Result{interface, protocol, service->name, service->type, service->domain,
+				               {}, {}, {}, {}, {}, {}, message});
+				if (service->resolver)
+					m_retired.push_back(std::move(service->resolver));
+				if (service->state == Service::State::Resolving)
+					finishFirst(*service);
+			});
+
+			service->resolver = resolver;
+			service->state = Service::State::Resolving;
+		});
+}
+
+void ResolveEngine::finishFirst(Service &service)
+{
+	service.state = Service::State::Done;
+	m_inFlight--;
+
+	if (m_mode == Mode::OneShot && service.resolver)
+		m_retired.push_back(std::move(service.resolver));
+
+	startPending();
+}
+
+void ResolveEngine::deliver(Result &&result)
+{
+	m_results.push_back(std::move(result));
+	scheduleFlush();
+}
+
+void ResolveEngine::scheduleFlush()
+{
+	if (m_flush.connected())
+		return;
+
+	if (m_batchDelay)
+		m_flush = m_context->signal_timeout().connect(sigc::mem_fun(*this, &ResolveEngine::onFlush), m_batchDelay);
+	else
+		m_flush = m_context->signal_idle().connect(sigc::mem_fun(*this, &ResolveEngine::onFlush));
+}
+
+bool ResolveEngine::onFlush()
+{
+	flush();
+	return false;  // disconnect
+}
+
+} /* namespace Avahi */
@@ -5,196 +5,178 @@
  *  \copyright 2022 ARRI Lighting Stephanskirchen
  */
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <sstream>
-#include <tuple>
-#include <typeinfo>                    // std::bad_cast
+#include <string_view>
 
-#include <giomm/dbusconnection.h>
 #include <glibmm/error.h>
+#include <glibmm/main.h>
 #include <glibmm/refptr.h>
 #include <glibmm/variant.h>
-
-#include <avahi-common/dbus.h>
-#include <glib.h>                      // G_MAXINT
+#include <sigc++/functors/mem_fun.h>
 
 #include "../Client.hpp"
 #include "../ServiceBrowser.hpp"       // IWYU pragma: associated
-
-namespace Gio { class AsyncResult; }
+#include "ItemBatch.hpp"
+#include "SharedBrowser.hpp"
+#include "SignalTable.hpp"
 
 namespace Avahi {
 
-ServiceBrowser::ServiceBrowser(Token, Client &client, Glib::ustring const &objectPath)
+namespace {
+
+std::size_t itemHash(Interface interface, Protocol protocol, std::string_view name, std::string_view type,
+                     std::string_view domain)
+{
+	std::hash<std::string_view> const hash;
+
+	return hash(name) ^ (hash(type) * 31) ^ (hash(domain) * 961) ^
+	       (std::hash<int>()(interface) << 1) ^ (std::hash<int>()(protocol) << 3);
+}
+
+}  // namespace
+
+ServiceBrowser::ServiceBrowser(Token, Client &client, std::shared_ptr<SharedBrowser> const &shared, BrowseFilter const &filter)
 : m_client(client)
-, m_objectPath(objectPath)
+, m_shared(shared)
+, m_filter(filter)
+, m_coalescing(false)
 {
-	auto const &connection = m_client.getConnection();
-
-	m_itemNew = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Flags = std::uint32_t;
-			using Params = std::tuple<Interface, Protocol, ServiceName, ServiceType, Domain, Flags>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[interface, protocol, name, type, domain, flags] = params.get();
-
-				on_itemNew(interface, protocol, name, type, domain, static_cast<::AvahiLookupResultFlags>(flags));
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("ServiceBrowser: Cannot parse \"ItemNew\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
-		"ItemNew",
-		m_objectPath);
-
-	m_itemRemove = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Flags = std::uint32_t;
-			using Params = std::tuple<Interface, Protocol, ServiceName, ServiceType, Domain, Flags>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[interface, protocol, name, type, domain, flags] = params.get();
-
-				on_itemRemove(interface, protocol, name, type, domain, static_cast<::AvahiLookupResultFlags>(flags));
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("ServiceBrowser: Cannot parse \"ItemRemove\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
-		"ItemRemove",
-		m_objectPath);
-
-	m_failure = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Params = std::tuple<Error>;
-
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[error] = params.get();
-
-				on_failure(error);
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("ServiceBrowser: Cannot parse \"Failure\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
-		"Failure",
-		m_objectPath);
-
-	m_allForNow = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &/*parameters*/)
-		{
-			on_allForNow();
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
-		"AllForNow",
-		m_objectPath);
-
-	m_cacheExhausted = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &/*parameters*/)
-		{
-			on_cacheExhausted();
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_BROWSER,
-		"CacheExhausted",
-		m_objectPath);
-
-	/* Start service browser after registering all signals handlers */
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_BROWSER, "Start",
-		Glib::VariantContainerBase(),
-		[this,connection](Glib::RefPtr<Gio::AsyncResult> &result)
-		{
-			try
-			{
-				connection->call_finish(result);
-			}
-			catch (Glib::Error const &e)
-			{
-				std::stringstream ss;
-
-				ss << "ServiceBrowser: D-Bus call \"Start\" failed: " << e.what();
-				on_errorLog(ss.str().c_str());
-			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
-	);
+	m_shared->subscribe(this, sigc::mem_fun(*this, &ServiceBrowser::onSignal), [this](char const *error)
+	{
+		on_errorLog(error);
+	});
 }
 
 ServiceBrowser::~ServiceBrowser()
 {
-	auto const &connection = m_client.getConnection();
+	m_shared->unsubscribe(this);
+	m_client.releaseBrowser(m_shared);
+}
 
-	if (connection)
+void ServiceBrowser::setCoalescing(bool enable)
+{
+	m_coalescing = enable;
+	if (enable && !m_batch)
+		m_batch = std::make_unique<ItemBatch<Item>>([this] { flushItems(); });
+	if (!enable)
+		flushItems();
+}
+
+void ServiceBrowser::onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	static constexpr SignalHandler<ServiceBrowser> handlers[] = {
+		signalHandler<&ServiceBrowser::onItemNew>("ItemNew"),
+		signalHandler<&ServiceBrowser::onItemRemove>("ItemRemove"),
+		signalHandler<&ServiceBrowser::onFailure>("Failure"),
+		signalHandler<&ServiceBrowser::onAllForNow>("AllForNow"),
+		signalHandler<&ServiceBrowser::onCacheExhausted>("CacheExhausted"),
+	};
+
+	if (dispatchSignal(handlers, *this, signalName, parameters) == SignalResult::ParseError)
 	{
-		connection->signal_unsubscribe(m_itemNew);
-		connection->signal_unsubscribe(m_itemRemove);
-		connection->signal_unsubscribe(m_failure);
-		connection->signal_unsubscribe(m_allForNow);
-		connection->signal_unsubscribe(m_cacheExhausted);
-		connection->call(
-			m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_BROWSER, "Free",
-			Glib::VariantContainerBase(),
-			[](Glib::RefPtr<Gio::AsyncResult> &/*result*/)
-			{
-				/* we are not interested in the result, so there's no need to
-				 * run call_finish() */
-			},
-			/*bus_name*/ AVAHI_DBUS_NAME,
-			/*timeout_msec*/G_MAXINT,
-			Gio::DBus::CALL_FLAGS_NO_AUTO_START
-		);
+		std::stringstream ss;
+
+		ss << "ServiceBrowser: Cannot parse \"" << signalName << "\" parameters";
+		m_client.parseError();
+		on_errorLog(ss.str().c_str());
 	}
 }
 
+void ServiceBrowser::onItemNew(Interface interface, Protocol protocol, StringView name, StringView type,
+                               StringView domain, std::uint32_t flags)
+{
+	onItem(true, ItemView{interface, protocol, name, type, domain, static_cast<::AvahiLookupResultFlags>(flags)});
+}
+
+void ServiceBrowser::onItemRemove(Interface interface, Protocol protocol, StringView name, StringView type,
+                                  StringView domain, std::uint32_t flags)
+{
+	onItem(false, ItemView{interface, protocol, name, type, domain, static_cast<::AvahiLookupResultFlags>(flags)});
+}
+
+void ServiceBrowser::onItem(bool isNew, ItemView const &item)
+{
+	/* several signals are emitted, a handler may release the last handle */
+	auto const self = shared_from_this();
+
+	/* The strings point into the received message; they are only copied if
+	 * someone is connected to the non-view signals. */
+	if (!m_filter.matchItem(item.interface, item.protocol, item.name))
+		return;
+
+	if (!on_event.empty())
+		on_event.emit(ServiceEvent{isNew, item.interface, item.protocol, item.name, item.type, item.domain, item.flags});
+	if (m_coalescing)
+		coalesce(isNew, item);
+
+	auto &viewSignal = isNew ? on_itemNewView : on_itemRemoveView;
+	auto &signal = isNew ? on_itemNew : on_itemRemove;
+
+	viewSignal(item);
+	if (!signal.empty())
+		signal(item.interface, item.protocol,
+		       ServiceName(item.name.begin(), item.name.end()),
+		       ServiceType(item.type.begin(), item.type.end()),
+		       Domain(item.domain.begin(), item.domain.end()),
+		       item.flags);
+}
+
+void ServiceBrowser::onFailure(StringView error)
+{
+	on_failure(Error(error.data(), error.size()));
+}
+
+void ServiceBrowser::onAllForNow()
+{
+	if (m_coalescing)
+	{
+		auto weak = weak_from_this();
+
+		/* on_itemsChanged handler may destroy this object */
+		flushItems();
+		if (weak.expired())
+			return;
+	}
+	on_allForNow();
+}
+
+void ServiceBrowser::onCacheExhausted()
+{
+	on_cacheExhausted();
+}
+
+void ServiceBrowser::coalesce(bool isNew, ItemView const &item)
+{
+	auto const hash = itemHash(item.interface, item.protocol, item.name, item.type, item.domain);
+
+	auto const sameItem = [&item](Item const &added)
+	{
+		return added.interface == item.interface && added.protocol == item.protocol &&
+		       added.name.raw() == item.name && added.type.view() == item.type &&
+		       added.domain.view() == item.domain;
+	};
+
+	if (!isNew && m_batch->cancelAdded(hash, sameItem))
+		return;  // added and removed within the same batch
+
+	bool const full = m_batch->push(isNew, hash, Item{item.interface, item.protocol,
+		ServiceName(item.name.begin(), item.name.end()),
+		m_client.intern(item.type),
+		m_client.intern(item.domain),
+		item.flags});
+	if (full)
+		flushItems();
+}
+
+void ServiceBrowser::flushItems()
+{
+	std::vector<Item> added, removed;
+
+	if (m_batch && m_batch->take(added, removed))
+		on_itemsChanged(added, removed);
+}
+
 } /* namespace Avahi */
@@ -0,0 +1,722 @@
+/**
+ *  \file
+ *  \brief Shared cache of browsed and resolved Avahi services
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+#include <glibmm/error.h>
+#include <glibmm/main.h>
+#include <sigc++/connection.h>
+
+#include <glib.h>                      // g_mapped_file_new(), g_file_set_contents()
+
+#include "../Client.hpp"
+#include "../ServiceBrowser.hpp"
+#include "../ServiceResolver.hpp"
+#include "../ServiceCache.hpp"         // IWYU pragma: associated
+
+namespace Avahi {
+
+namespace {
+
+/* Snapshot file format (all integers little endian):
+ *
+ *   "AVSC" u32:version u32:count
+ *   count * record:
+ *     i32:queryInterface i32:queryProtocol str:queryType str:queryDomain
+ *     i32:interface i32:protocol u32:flags str:name str:type str:domain
+ *     u8:resolved str:host i32:aprotocol str:address u16:port
+ *     u16:txtCount txtCount * str
+ *
+ *   str: u16:length + bytes (no terminating NUL)
+ *
+ * The file is mapped and decoded without reading it into a buffer first;
+ * the strings are copied into the restored entries. */
+constexpr char snapshotMagic[4] = {'A', 'V', 'S', 'C'};
+constexpr std::uint32_t snapshotVersion = 1;
+
+/** Encoder, ok() becomes false if a value cannot be encoded. */
+class SnapshotWriter
+{
+public:   // methods
+	bool ok() const { return m_ok; }
+
+	void bytes(void const *data, std::size_t size) { m_data.append(static_cast<char const *>(data), size); }
+	void u8(std::uint8_t value) { m_data.push_back(static_cast<char>(value)); }
+	void u16(std::uint16_t value) { u8(value & 0xff); u8(value >> 8); }
+	void u32(std::uint32_t value) { u16(value & 0xffff); u16(value >> 16); }
+	void i32(std::int32_t value) { u32(static_cast<std::uint32_t>(value)); }
+	/** Writes a u16 count, fails if \a value does not fit. */
+	void count(std::size_t value)
+	{
+		if (value > UINT16_MAX)
+			m_ok = false;
+		u16(static_cast<std::uint16_t>(value));
+	}
+	void str(std::string const &value)
+	{
+		count(value.size());
+		if (m_ok)
+			bytes(value.data(), value.size());
+	}
+
+	std::string const &data() const { return m_data; }
+
+private:  // members
+	std::string m_data;
+	bool m_ok = true;
+};
+
+/** Bounds checked decoder, all reads fail after the first error. */
+class SnapshotReader
+{
+public:   // methods
+	SnapshotReader(char const *data, std::size_t size)
+	: m_data(reinterpret_cast<std::uint8_t const *>(data))
+	, m_size(size)
+	, m_pos(0)
+	, m_ok(true)
+	{}
+
+	bool ok() const { return m_ok; }
+	bool atEnd() const { return m_pos == m_size; }
+
+	bool bytes(void *data, std::size_t size)
+	{
+		if (!take(size))
+			return false;
+		std::memcpy(data, m_data + m_pos - size, size);
+		return true;
+	}
+	std::uint8_t u8() { return take(1) ? m_data[m_pos - 1] : 0; }
+	std::uint16_t u16() { std::uint16_t const low = u8(); return static_cast<std::uint16_t>(low | u8() << 8); }
+	std::uint32_t u32() { std::uint32_t const low = u16(); return low | static_cast<std::uint32_t>(u16()) << 16; }
+	std::int32_t i32() { return static_cast<std::int32_t>(u32()); }
+	std::string str()
+	{
+		std::size_t const length = u16();
+		if (!take(length))
+			return {};
+		return std::string(reinterpret_cast<char const *>(m_data + m_pos - length), length);
+	}
+
+private:  // methods
+	bool take(std::size_t size)
+	{
+		if (!m_ok || size > m_size - m_pos)
+		{
+			m_ok = false;
+			return false;
+		}
+		m_pos += size;
+		return true;
+	}
+
+private:  // members
+	std::uint8_t const *m_data;
+	std::size_t m_size;
+	std::size_t m_pos;
+	bool m_ok;
+};
+
+}  // namespace
+
+/** State of a single browse query, shared by all of its subscriptions. */
+struct ServiceCache::Browse : public std::enable_shared_from_this<Browse>
+{
+	using EntryKey = std::tuple<Interface, Protocol, std::string, std::string, std::string>;
+
+	struct Record
+	{
+		~Record() { retry.disconnect(); }
+
+		Entry entry;
+		std::shared_ptr<ServiceResolver> resolver;
+		/** Number of failed resolve attempts in a row. */
+		unsigned int failures = 0;
+		/** Pending retry after a failed resolve attempt. */
+		sigc::connection retry;
+	};
+
+	/** Number of retries before an entry is left unresolved. */
+	static constexpr unsigned int MaxResolveRetries = 4;
+
+	Browse(ServiceCache &cache, QueryKey const &key)
+	: cache(cache)
+	, key(key)
+	, allForNow(false)
+	{}
+
+	~Browse()
+	{
+		for (auto const &[entryKey, record] : records)
+			cache.unindex(record.entry);
+
+		/* the entry may already refer to a newer query (see forget()) */
+		auto it = cache.m_browses.find(key);
+		if (it != cache.m_browses.end() && it->second.expired())
+			cache.m_browses.erase(it);
+	}
+
+	/** Removes this query from the cache, so that the next subscribe()
+	 *  creates a new one.  Existing subscriptions keep this object. */
+	void forget()
+	{
+		auto it = cache.m_browses.find(key);
+		if (it != cache.m_browses.end() && it->second.lock().get() == this)
+			cache.m_browses.erase(it);
+	}
+
+	/** Invokes \a func for all subscriptions.  Subscriptions (and this
+	 *  object) may be destroyed from within \a func. */
+	template <typename Func>
+	void forEachSubscriber(Func func)
+	{
+		auto self = shared_from_this();
+		auto const snapshot = subscribers;
+
+		for (auto *subscriber : snapshot)
+		{
+			if (std::find(subscribers.begin(), subscribers.end(), subscriber) != subscribers.end())
+				func(*subscriber);
+		}
+	}
+
+	void attach(std::shared_ptr<ServiceBrowser> const &serviceBrowser);
+	void resolve(EntryKey const &entryKey);
+	/** Drops the resolver of a failed attempt and retries with exponential
+	 *  backoff; finally reports \a error to the subscriptions. */
+	void resolveFailed(EntryKey const &entryKey, Error const &error);
+	/** Adds an entry restored from a snapshot. */
+	void restore(Entry &&entry);
+	/** Removes all entries restored from a snapshot which have not been
+	 *  reported by the browser. */
+	void evictUnverified();
+
+	ServiceCache &cache;
+	QueryKey key;
+	std::shared_ptr<ServiceBrowser> browser;
+	std::map<EntryKey, Record> records;
+	std::vector<Subscription *> subscribers;
+	bool allForNow;
+};
+
+void ServiceCache::Browse::attach(std::shared_ptr<ServiceBrowser> const &serviceBrowser)
+{
+	browser = serviceBrowser;
+
+	/* The browser is owned by this object, so capturing 'this' is safe */
+	browser->on_errorLog.connect([this](char const *error)
+	{
+		cache.on_errorLog(error);
+	});
+
+	browser->on_itemNew.connect([this](Interface interface, Protocol protocol,
+	        ServiceName const &name, ServiceType const &type, Domain const &domain,
+	        ::AvahiLookupResultFlags flags)
+	{
+		EntryKey entryKey{interface, protocol, name.raw(), type.raw(), domain.raw()};
+		auto [it, inserted] = records.try_emplace(entryKey);
+		if (!inserted)
+		{
+			auto &entry = it->second.entry;
+			if (entry.verified)
+				return;
+
+			/* restored from a snapshot, resolve again for TXT updates */
+			entry.verified = true;
+			entry.flags = flags;
+			resolve(entryKey);
+
+			forEachSubscriber([&entry](Subscription &subscriber)
+			{
+				subscriber.on_updated(entry);
+			});
+			return;
+		}
+
+		it->second.entry = Entry{interface, protocol, name, type, domain, flags, true,
+		                         false, {}, {}, {}, {}, {}};
+		cache.index(it->second.entry);
+		resolve(entryKey);
+
+		auto const &entry = it->second.entry;
+		forEachSubscriber([&entry](Subscription &subscriber)
+		{
+			subscriber.on_added(entry);
+		});
+	});
+
+	browser->on_itemRemove.connect([this](Interface interface, Protocol protocol,
+	        ServiceName const &name, ServiceType const &type, Domain const &domain,
+	        ::AvahiLookupResultFlags /*flags*/)
+	{
+		auto it = records.find(EntryKey{interface, protocol, name.raw(), type.raw(), domain.raw()});
+		if (it == records.end())
+			return;
+
+		auto self = shared_from_this();
+		auto const &entry = it->second.entry;
+		forEachSubscriber([&entry](Subscription &subscriber)
+		{
+			subscriber.on_removed(entry);
+		});
+
+		cache.unindex(entry);
+		records.erase(it);
+	});
+
+	browser->on_cacheExhausted.connect([this]
+	{
+		evictUnverified();
+	});
+
+	browser->on_allForNow.connect([this]
+	{
+		evictUnverified();
+		allForNow = true;
+		forEachSubscriber([](Subscription &subscriber)
+		{
+			subscriber.on_allForNow();
+		});
+	});
+
+	browser->on_failure.connect([this](Error const &error)
+	{
+		forEachSubscriber([&error](Subscription &subscriber)
+		{
+			subscriber.on_failure(error);
+		});
+	});
+}
+
+void ServiceCache::Browse::resolve(EntryKey const &entryKey)
+{
+	auto const &entry = records.at(entryKey).entry;
+
+	cache.m_client.async_createServiceResolver(entry.interface, entry.protocol,
+		entry.name, entry.type, entry.domain, cache.m_aprotocol, {},
+		[weak = weak_from_this(), entryKey](std::shared_ptr<ServiceResolver> const &resolver, Glib::Error const &error)
+		{
+			auto self = weak.lock();
+			if (!self)
+				return;  // query has been released in the meantime
+
+			auto it = self->records.find(entryKey);
+			if (it == self->records.end())
+				return;  // service has disappeared in the meantime
+
+			if (error)
+			{
+				self->resolveFailed(entryKey, error.what());
+				return;
+			}
+
+			/* The resolver is owned by the record, which is owned by this
+			 * object, so capturing the raw pointer is safe. */
+			auto *browse = self.get();
+			resolver->on_errorLog.connect([browse](char const *message)
+			{
+				browse->cache.on_errorLog(message);
+			});
+			resolver->on_foundView.connect([browse, entryKey](ServiceResolver::FoundView const &found)
+			{
+				auto it = browse->records.find(entryKey);
+				if (it == browse->records.end())
+					return;
+
+				auto &entry = it->second.entry;
+				it->second.failures = 0;
+				browse->cache.unindex(entry);
+				entry.verified  = true;
+				entry.resolved  = true;
+				entry.host      = Host(found.host.begin(), found.host.end());
+				entry.aprotocol = found.aprotocol;
+				entry.address   = ServiceResolver::Address(found.address.begin(), found.address.end());
+				entry.port      = found.port;
+				entry.txt       = found.txt.toTxt();
+				browse->cache.index(entry);
+
+				browse->forEachSubscriber([&entry](Subscription &subscriber)
+				{
+					subscriber.on_updated(entry);
+				});
+			});
+			resolver->on_failure.connect([browse, entryKey](Error const &error)
+			{
+				browse->resolveFailed(entryKey, error);
+			});
+
+			it->second.resolver = resolver;
+		});
+}
+
+void ServiceCache::Browse::resolveFailed(EntryKey const &entryKey, Error const &error)
+{
+	auto it = records.find(entryKey);
+	if (it == records.end() || it->second.retry.connected())
+		return;
+
+	auto &record = it->second;
+	bool const retry = record.failures++ < MaxResolveRetries;
+	{
+		std::stringstream ss;
+
+		ss << "ServiceCache: Cannot resolve \"" << std::get<2>(entryKey) << "\": " << error
+		   << (retry ? " (retrying)" : "");
+		cache.on_errorLog(ss.str().c_str());
+	}
+
+	/* The resolver may be emitting this failure, so it is dropped later.
+	 * The timer is owned by the record, so capturing 'this' is safe. */
+	unsigned int const delay_msec = retry ? 1000u << (record.failures - 1) : 0;
+	record.retry = Glib::MainContext::get_thread_default()->signal_timeout().connect([this, entryKey, retry, error]
+	{
+		auto &record = records.at(entryKey);
+
+		/* release the connection without disconnecting the running handler */
+		record.retry = sigc::connection();
+		record.resolver.reset();
+		if (retry)
+		{
+			resolve(entryKey);
+			return false;  // disconnect
+		}
+
+		/* give up, the entry stays unresolved */
+		forEachSubscriber([&error](Subscription &subscriber)
+		{
+			subscriber.on_failure(error);
+		});
+		return false;  // disconnect
+	}, delay_msec);
+}
+
+void ServiceCache::Browse::restore(Entry &&entry)
+{
+	EntryKey entryKey{entry.interface, entry.protocol, entry.name.raw(), entry.type.raw(), entry.domain.raw()};
+	auto [it, inserted] = records.try_emplace(entryKey);
+	if (!inserted)
+		return;
+
+	it->second.entry = std::move(entry);
+	it->second.entry.verified = false;
+	cache.index(it->second.entry);
+}
+
+void ServiceCache::Browse::evictUnverified()
+{
+	auto self = shared_from_this();
+
+	for (auto it = records.begin(); it != records.end();)
+	{
+		auto const &entry = it->second.entry;
+		if (entry.verified)
+		{
+			++it;
+			continue;
+		}
+
+		forEachSubscriber([&entry](Subscription &subscriber)
+		{
+			subscriber.on_removed(entry);
+		});
+
+		cache.unindex(entry);
+		it = records.erase(it);
+	}
+}
+
+ServiceCache::Subscription::Subscription(Token, std::shared_ptr<Browse> browse)
+: m_browse(std::move(browse))
+{
+	m_browse->subscribers.push_back(this);
+}
+
+ServiceCache::Subscription::~Subscription()
+{
+	auto &subscribers = m_browse->subscribers;
+	subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), this), subscribers.end());
+}
+
+std::vector<ServiceCache::Entry const *> ServiceCache::Subscription::snapshot() const
+{
+	std::vector<Entry const *> entries;
+
+	entries.reserve(m_browse->records.size());
+	for (auto const &[entryKey, record] : m_browse->records)
+		entries.push_back(&record.entry);
+
+	return entries;
+}
+
+bool ServiceCache::Subscription::allForNow() const
+{
+	return m_browse->allForNow;
+}
+
+ServiceCache::ServiceCache(Client &client, Protocol aprotocol)
+: m_client(client)
+, m_aprotocol(aprotocol)
+{
+}
+
+ServiceCache::~ServiceCache() = default;
+
+std::shared_ptr<ServiceCache::Subscription> ServiceCache::subscribe(Interface interface, Protocol protocol,
+        ServiceType const &type, Domain const &domain)
+{
+	QueryKey key{interface, protocol, type.raw(), domain.raw()};
+
+	auto browse = m_browses[key].lock();
+	if (!browse)
+	{
+		browse = std::make_shared<Browse>(*this, key);
+		m_browses[key] = browse;
+
+		auto restored = m_snapshot.find(key);
+		if (restored != m_snapshot.end())
+		{
+			for (auto &entry : restored->second)
+				browse->restore(std::move(entry));
+			m_snapshot.erase(restored);
+		}
+
+		m_client.async_createServiceBrowser(interface, protocol, type, domain, {},
+			[weak = std::weak_ptr<Browse>(browse)](std::shared_ptr<ServiceBrowser> const &browser, Glib::Error const &error)
+			{
+				auto browse = weak.lock();
+				if (!browse)
+					return;  // all subscriptions have been released in the meantime
+
+				if (error)
+				{
+					/* later subscriptions retry instead of waiting forever */
+					browse->forget();
+					browse->forEachSubscriber([&error](Subscription &subscriber)
+					{
+						subscriber.on_failure(error.what());
+					});
+					return;
+				}
+
+				browse->attach(browser);
+			});
+	}
+
+	return std::make_shared<Subscription>(Subscription::Token{}, browse);
+}
+
+std::vector<ServiceCache::Entry const *> ServiceCache::lookup(ServiceName const &name,
+        ServiceType const &type, Domain const &domain) const
+{
+	std::vector<Entry const *> entries;
+
+	auto [first, last] = m_serviceIndex.equal_range(ServiceKey{name.raw(), type.raw(), domain.raw()});
+	for (auto it = first; it != last; ++it)
+		entries.push_back(it->second);
+
+	return entries;
+}
+
+std::vector<ServiceCache::Entry const *> ServiceCache::lookupHost(Host const &host) const
+{
+	std::vector<Entry const *> entries;
+
+	auto [first, last] = m_hostIndex.equal_range(host.raw());
+	for (auto it = first; it != last; ++it)
+		entries.push_back(it->second);
+
+	return entries;
+}
+
+bool ServiceCache::saveSnapshot(std::string const &path) const
+{
+	SnapshotWriter writer;
+	std::uint32_t count = 0;
+	std::size_t skipped = 0;
+
+	writer.bytes(snapshotMagic, sizeof(snapshotMagic));
+	writer.u32(snapshotVersion);
+	writer.u32(0);  // count, patched below
+
+	for (auto const &[key, weak] : m_browses)
+	{
+		auto browse = weak.lock();
+		if (!browse)
+			continue;
+
+		auto const &[queryInterface, queryProtocol, queryType, queryDomain] = key;
+		for (auto const &[entryKey, record] : browse->records)
+		{
+			auto const &entry = record.entry;
+			SnapshotWriter encoded;
+
+			encoded.i32(queryInterface);
+			encoded.i32(queryProtocol);
+			encoded.str(queryType);
+			encoded.str(queryDomain);
+			encoded.i32(entry.interface);
+			encoded.i32(entry.protocol);
+			encoded.u32(static_cast<std::uint32_t>(entry.flags));
+			encoded.str(entry.name.raw());
+			encoded.str(entry.type.raw());
+			encoded.str(entry.domain.raw());
+			encoded.u8(entry.resolved);
+			encoded.str(entry.host.raw());
+			encoded.i32(entry.aprotocol);
+			encoded.str(entry.address.raw());
+			encoded.u16(entry.port);
+			encoded.count(entry.txt.size());
+			for (auto const &string : entry.txt)
+				encoded.str(std::string(string.begin(), string.end()));
+
+			/* a truncated length would corrupt the rest of the file */
+			if (!encoded.ok())
+			{
+				skipped++;
+				continue;
+			}
+			writer.bytes(encoded.data().data(), encoded.data().size());
+			count++;
+		}
+	}
+
+	std::string data = writer.data();
+	for (std::size_t i = 0; i < 4; i++)
+		data[sizeof(snapshotMagic) + 4 + i] = static_cast<char>(count >> (8 * i));
+
+	GError *error = nullptr;
+	if (!::g_file_set_contents(path.c_str(), data.data(), static_cast<gssize>(data.size()), &error))
+	{
+		std::stringstream ss;
+
+		ss << "ServiceCache: Cannot write snapshot \"" << path << "\": " << error->message;
+		::g_error_free(error);
+		on_errorLog(ss.str().c_str());
+		return false;
+	}
+
+	if (skipped)
+	{
+		std::stringstream ss;
+
+		ss << "ServiceCache: Snapshot \"" << path << "\": Skipped " << skipped << " entries with oversized strings";
+		on_errorLog(ss.str().c_str());
+	}
+	return true;
+}
+
+bool ServiceCache::loadSnapshot(std::string const &path)
+{
+	GError *error = nullptr;
+	GMappedFile *file = ::g_mapped_file_new(path.c_str(), FALSE, &error);
+	if (!file)
+	{
+		std::stringstream ss;
+
+		ss << "ServiceCache: Cannot read snapshot \"" << path << "\": " << error->message;
+		::g_error_free(error);
+		on_errorLog(ss.str().c_str());
+		return false;
+	}
+
+	SnapshotReader reader(::g_mapped_file_get_contents(file), ::g_mapped_file_get_length(file));
+	std::map<QueryKey, std::vector<Entry>> snapshot;
+	char magic[sizeof(snapshotMagic)];
+
+	bool valid = reader.bytes(magic, sizeof(magic)) && std::memcmp(magic, snapshotMagic, sizeof(magic)) == 0 &&
+	             reader.u32() == snapshotVersion;
+	std::uint32_t const count = valid ? reader.u32() : 0;
+
+	for (std::uint32_t i = 0; valid && i < count; i++)
+	{
+		Interface const queryInterface = reader.i32();
+		Protocol const queryProtocol = reader.i32();
+		std::string queryType = reader.str();
+		std::string queryDomain = reader.str();
+
+		Entry entry{};
+		entry.interface = reader.i32();
+		entry.protocol  = reader.i32();
+		entry.flags     = static_cast<::AvahiLookupResultFlags>(reader.u32());
+		entry.name      = reader.str();
+		entry.type      = reader.str();
+		entry.domain    = reader.str();
+		entry.verified  = false;
+		entry.resolved  = reader.u8() != 0;
+		entry.host      = reader.str();
+		entry.aprotocol = reader.i32();
+		entry.address   = reader.str();
+		entry.port      = reader.u16();
+
+		std::size_t const txtCount = reader.u16();
+		for (std::size_t j = 0; reader.ok() && j < txtCount; j++)
+		{
+			auto const string = reader.str();
+			entry.txt.emplace_back(string.begin(), string.end());
+		}
+
+		valid = reader.ok();
+		if (valid)
+			snapshot[QueryKey{queryInterface, queryProtocol, std::move(queryType), std::move(queryDomain)}].push_back(std::move(entry));
+	}
+	valid = valid && reader.atEnd();
+	::g_mapped_file_unref(file);
+
+	if (!valid)
+	{
+		std::stringstream ss;
+
+		ss << "ServiceCache: Snapshot \"" << path << "\" is malformed";
+		on_errorLog(ss.str().c_str());
+		return false;
+	}
+
+	for (auto &[key, entries] : snapshot)
+	{
+		if (m_browses.count(key))
+			continue;  // query already active
+
+		auto &pending = m_snapshot[key];
+		std::move(entries.begin(), entries.end(), std::back_inserter(pending));
+	}
+	return true;
+}
+
+void ServiceCache::index(Entry const &entry)
+{
+	m_serviceIndex.emplace(ServiceKey{entry.name.raw(), entry.type.raw(), entry.domain.raw()}, &entry);
+	if (entry.resolved)
+		m_hostIndex.emplace(entry.host.raw(), &entry);
+}
+
+void ServiceCache::unindex(Entry const &entry)
+{
+	auto eraseFrom = [&entry](auto &index, auto const &key)
+	{
+		auto [first, last] = index.equal_range(key);
+		for (auto it = first; it != last; ++it)
+		{
+			if (it->second == &entry)
+			{
+				index.erase(it);
+				return;
+			}
+		}
+	};
+
+	eraseFrom(m_serviceIndex, ServiceKey{entry.name.raw(), entry.type.raw(), entry.domain.raw()});
+	if (entry.resolved)
+		eraseFrom(m_hostIndex, entry.host.raw());
+}
+
+} /* namespace Avahi */
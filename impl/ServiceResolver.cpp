@@ -5,93 +5,90 @@
  *  \copyright 2022 ARRI Lighting Stephanskirchen
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <sstream>
-#include <tuple>
-#include <typeinfo>                    // std::bad_cast
+#include <utility>
 
 #include <giomm/dbusconnection.h>
 #include <glibmm/error.h>
 #include <glibmm/refptr.h>
 #include <glibmm/variant.h>
+#include <sigc++/functors/mem_fun.h>
 
 #include <avahi-common/dbus.h>
-#include <glib.h>                      // G_MAXINT
 
 #include "../Client.hpp"
 #include "../ServiceResolver.hpp"      // IWYU pragma: associated
+#include "SignalTable.hpp"
 
 namespace Gio { class AsyncResult; }
 
 namespace Avahi {
 
-ServiceResolver::ServiceResolver(Token, Client &client, Glib::ustring const &objectPath)
+namespace {
+
+/** Appends the keys (first occurrence only, see RFC 6763, 6.4) of \a record
+ *  which are missing in \a other (or, unless \a missingOnly, have another
+ *  value there). */
+void diffKeys(TxtRecord const &record, TxtRecord const &other, bool missingOnly, std::vector<StringView> &keys)
+{
+	for (auto const &entry : record)
+	{
+		if (entry.key.empty())
+			continue;
+
+		auto const first = record.find(entry.key);
+		if (first->raw.data() != entry.raw.data())
+			continue;  // duplicate key
+
+		auto const otherEntry = other.find(entry.key);
+		if (!otherEntry)
+			keys.push_back(entry.key);
+		else if (!missingOnly && (otherEntry->hasValue != entry.hasValue ||
+		    otherEntry->valueString() != entry.valueString()))
+			keys.push_back(entry.key);
+	}
+}
+
+}  // namespace
+
+ServiceResolver::ServiceResolver(Token, Client &client, Glib::ustring const &objectPath, Glib::VariantContainerBase const &parameters)
 : m_client(client)
 , m_objectPath(objectPath)
+, m_parameters(parameters)
+, m_changes{0, {}}
 {
-	auto const &connection = m_client.getConnection();
+	m_client.registerSession(this, sigc::mem_fun(*this, &ServiceResolver::onSession));
+	m_client.registerObject(m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, sigc::mem_fun(*this, &ServiceResolver::onSignal));
 
-	m_found = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Flags = std::uint32_t;
-			using Params = std::tuple<Interface, Protocol, ServiceName, ServiceType, Domain, Host, AProtocol, Address, Port, Txt, Flags>;
+	/* started by Client after construction, when weak_from_this() is valid */
+}
 
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[interface, protocol, name, type, domain, host, aprotocol, address, port, txt, flags] = params.get();
+ServiceResolver::~ServiceResolver()
+{
+	m_client.unregisterSession(this);
 
-				on_found(/*interface, protocol, */name, /*type, domain, */host, aprotocol, address, port, txt, static_cast<::AvahiLookupResultFlags>(flags));
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("ServiceResolver: Cannot parse \"Found\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER,
-		"Found",
-		m_objectPath);
-
-	m_failure = connection->signal_subscribe(
-		[this](Glib::RefPtr<Gio::DBus::Connection> const &/*connection*/,
-		       Glib::ustring const &/*senderName*/,
-		       Glib::ustring const &/*objectPath*/,
-		       Glib::ustring const &/*interfaceName*/,
-		       Glib::ustring const &/*signalName*/,
-		       Glib::VariantContainerBase const &parameters)
-		{
-			using Params = std::tuple<Error>;
+	if (m_objectPath.empty())
+		return;  // detached
 
-			try
-			{
-				auto params = Glib::VariantBase::cast_dynamic<Glib::Variant<Params>>(parameters);
-				const auto &[error] = params.get();
+	m_client.releaseObject(m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER);
+}
 
-				on_failure(error);
-			}
-			catch (std::bad_cast const &e)
-			{
-				on_errorLog("ServiceResolver: Cannot parse \"Failure\" parameters");
-				return;
-			}
-		},
-		AVAHI_DBUS_NAME,
-		AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER,
-		"Failure",
-		m_objectPath);
-
-	/* Start service resolver after registering all signals handlers */
-	connection->call(
-		m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, "Start",
+void ServiceResolver::setFilter(BrowseFilter const &filter)
+{
+	m_filter = filter;
+}
+
+void ServiceResolver::start()
+{
+	auto const &connection = m_client.getConnection();
+
+	m_client.call(
+		Client::Operation::Start, m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, "Start",
 		Glib::VariantContainerBase(),
-		[this,connection](Glib::RefPtr<Gio::AsyncResult> &result)
+		[weak = weak_from_this(), connection](Glib::RefPtr<Gio::AsyncResult> &result)
 		{
 			try
 			{
@@ -99,39 +96,161 @@ ServiceResolver::ServiceResolver(Token, Client &client, Glib::ustring const &obj
 			}
 			catch (Glib::Error const &e)
 			{
+				auto self = weak.lock();
+				if (!self)
+					return;
+
 				std::stringstream ss;
 
 				ss << "ServiceResolver: D-Bus call \"Start\" failed: " << e.what();
-				on_errorLog(ss.str().c_str());
+				self->on_errorLog(ss.str().c_str());
 			}
-		},
-		/*bus_name*/ AVAHI_DBUS_NAME,
-		/*timeout_msec*/G_MAXINT,
-		Gio::DBus::CALL_FLAGS_NO_AUTO_START
+		}
 	);
 }
 
-ServiceResolver::~ServiceResolver()
+void ServiceResolver::onSession(bool available)
 {
-	auto const &connection = m_client.getConnection();
+	if (!available)
+	{
+		/* daemon side object is gone (Client has already dropped the
+		 * signal routing) */
+		m_objectPath.clear();
+		return;
+	}
 
-	if (connection)
+	m_client.restoreObject(Client::Operation::ServiceResolverPrepare, "ServiceResolverPrepare",
+		m_parameters, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, weak_from_this(),
+		sigc::mem_fun(*this, &ServiceResolver::rebind));
+}
+
+void ServiceResolver::rebind(Glib::ustring const &objectPath, Glib::Error const &error)
+{
+	if (error)
 	{
-		connection->signal_unsubscribe(m_found);
-		connection->signal_unsubscribe(m_failure);
-		connection->call(
-			m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, "Free",
-			Glib::VariantContainerBase(),
-			[](Glib::RefPtr<Gio::AsyncResult> &/*result*/)
-			{
-				/* we are not interested in the result, so there's no need to
-				 * run call_finish() */
-			},
-			/*bus_name*/ AVAHI_DBUS_NAME,
-			/*timeout_msec*/G_MAXINT,
-			Gio::DBus::CALL_FLAGS_NO_AUTO_START
-		);
+		std::stringstream ss;
+
+		ss << "ServiceResolver: Cannot re-create service resolver: " << error.what();
+		on_errorLog(ss.str().c_str());
+		return;
 	}
 
+	m_objectPath = objectPath;
+	m_client.registerObject(m_objectPath, AVAHI_DBUS_INTERFACE_SERVICE_RESOLVER, sigc::mem_fun(*this, &ServiceResolver::onSignal));
+	start();
 }
+
+void ServiceResolver::emitChanged(FoundView const &found)
+{
+	auto it = std::find_if(m_seen.begin(), m_seen.end(), [&found](Seen const &seen)
+	{
+		return seen.interface == found.interface && seen.protocol == found.protocol;
+	});
+
+	m_changes.fields = 0;
+	m_changes.txtKeys.clear();
+
+	if (it == m_seen.end())
+	{
+		TxtRecord txt(found.txt);
+
+		diffKeys(txt, TxtRecord(), true, m_changes.txtKeys);
+		m_changes.fields = ChangedAll;
+		m_seen.push_back(Seen{found.interface, found.protocol, Host(found.host.begin(), found.host.end()),
+		                      found.aprotocol, Address(found.address.begin(), found.address.end()),
+		                      found.port, std::move(txt), found.flags});
+		on_changed(found, m_changes);
+		return;
+	}
+
+	auto &seen = *it;
+	if (StringView(seen.host.data(), seen.host.bytes()) != found.host)
+	{
+		seen.host = Host(found.host.begin(), found.host.end());
+		m_changes.fields |= ChangedHost;
+	}
+	if (seen.aprotocol != found.aprotocol)
+	{
+		seen.aprotocol = found.aprotocol;
+		m_changes.fields |= ChangedAProtocol;
+	}
+	if (StringView(seen.address.data(), seen.address.bytes()) != found.address)
+	{
+		seen.address = Address(found.address.begin(), found.address.end());
+		m_changes.fields |= ChangedAddress;
+	}
+	if (seen.port != found.port)
+	{
+		seen.port = found.port;
+		m_changes.fields |= ChangedPort;
+	}
+	if (seen.flags != found.flags)
+	{
+		seen.flags = found.flags;
+		m_changes.fields |= ChangedFlags;
+	}
+
+	/* The previous TXT data must stay alive during the emission, as the
+	 * keys of removed entries refer to it. */
+	TxtRecord previous;
+	if (!seen.txt.equals(found.txt))
+	{
+		previous = std::exchange(seen.txt, TxtRecord(found.txt));
+		diffKeys(seen.txt, previous, false, m_changes.txtKeys);
+		diffKeys(previous, seen.txt, true, m_changes.txtKeys);
+		m_changes.fields |= ChangedTxt;  // also for reordered strings
+	}
+
+	if (m_changes.fields)
+		on_changed(found, m_changes);
+}
+
+void ServiceResolver::onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	static constexpr SignalHandler<ServiceResolver> handlers[] = {
+		signalHandler<&ServiceResolver::onFound>("Found"),
+		signalHandler<&ServiceResolver::onFailure>("Failure"),
+	};
+
+	if (dispatchSignal(handlers, *this, signalName, parameters) == SignalResult::ParseError)
+	{
+		std::stringstream ss;
+
+		ss << "ServiceResolver: Cannot parse \"" << signalName << "\" parameters";
+		m_client.parseError();
+		on_errorLog(ss.str().c_str());
+	}
+}
+
+void ServiceResolver::onFound(Interface interface, Protocol protocol, StringView name, StringView type,
+                              StringView domain, StringView host, AProtocol aprotocol, StringView address,
+                              Port port, TxtView txt, std::uint32_t flags)
+{
+	/* Strings and TXT data point into the received message; they are only
+	 * copied if someone is connected to on_found. */
+	if (!m_filter.empty() &&
+	    (!m_filter.matchItem(interface, protocol, name) || !m_filter.matchTxt(txt)))
+		return;
+
+	FoundView const found{interface, protocol, name, type, domain, host, aprotocol, address, port, txt, static_cast<::AvahiLookupResultFlags>(flags)};
+
+	/* several signals are emitted, a handler may release the last handle */
+	auto const self = shared_from_this();
+
+	on_event.emit(found);
+	on_foundView(found);
+	if (!on_changed.empty())
+		emitChanged(found);
+	if (!on_found.empty())
+		on_found(/*interface, protocol, */ServiceName(found.name.begin(), found.name.end()),
+		         /*type, domain, */Host(found.host.begin(), found.host.end()),
+		         found.aprotocol, Address(found.address.begin(), found.address.end()),
+		         found.port, found.txt.toTxt(), found.flags);
+}
+
+void ServiceResolver::onFailure(StringView error)
+{
+	on_failure(Error(error.data(), error.size()));
+}
+
 } /* namespace Avahi */
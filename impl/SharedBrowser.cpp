@@ -0,0 +1,395 @@
+/**
+ *  \file
+ *  \brief Daemon side browser object shared by identical browser requests
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+
+#include <giomm/dbusconnection.h>
+#include <glibmm/error.h>
+#include <glibmm/main.h>
+#include <glibmm/refptr.h>
+#include <sigc++/functors/mem_fun.h>
+
+#include <glib.h>                      // g_variant_get_child_value(), g_variant_equal(), g_variant_new_tuple()
+
+#include "SharedBrowser.hpp"           // IWYU pragma: associated
+
+namespace Gio { class AsyncResult; }
+
+namespace Avahi {
+
+SharedBrowser::SharedBrowser(Client &client, std::string const &key, Client::Operation operation,
+        char const *methodName, char const *interfaceName,
+        Glib::VariantContainerBase const &parameters)
+: m_client(client)
+, m_key(key)
+, m_operation(operation)
+, m_methodName(methodName)
+, m_interfaceName(interfaceName)
+, m_parameters(parameters)
+, m_logPrefix((operation == Client::Operation::RecordBrowserPrepare) ? "RecordBrowser" : "ServiceBrowser")
+, m_prepared(false)
+, m_started(false)
+, m_defunct(false)
+, m_subscriberCount(0)
+, m_dispatching(0)
+, m_sequence(0)
+, m_recording(true)
+, m_pendingHandles(0)
+, m_cacheExhausted(false)
+, m_allForNow(false)
+{
+	m_client.registerSession(this, sigc::mem_fun(*this, &SharedBrowser::onSession));
+}
+
+SharedBrowser::~SharedBrowser()
+{
+	m_linger.disconnect();
+	m_client.unregisterSession(this);
+
+	/* drop the (expired) entry, unless it has already been replaced */
+	auto it = m_client.m_browsers.find(m_key);
+	if (it != m_client.m_browsers.end() && it->second.expired())
+		m_client.m_browsers.erase(it);
+
+	if (m_objectPath.empty())
+		return;  // detached (or never prepared)
+
+	m_client.releaseObject(m_objectPath, m_interfaceName);
+}
+
+void SharedBrowser::bind(Glib::ustring const &objectPath)
+{
+	m_prepared = true;
+	m_objectPath = objectPath;
+	m_client.registerObject(m_objectPath, m_interfaceName, sigc::mem_fun(*this, &SharedBrowser::onSignal));
+}
+
+void SharedBrowser::addWaiter(Glib::RefPtr<Gio::Cancellable> const &cancellable, Client::SlotAcquireBrowser const &completion)
+{
+	m_waiters.push_back(Waiter{cancellable, completion});
+}
+
+std::vector<SharedBrowser::Waiter> SharedBrowser::takeWaiters()
+{
+	auto waiters = std::move(m_waiters);
+	m_waiters.clear();
+	return waiters;
+}
+
+void SharedBrowser::activate()
+{
+	if (!m_started && m_subscriberCount && !m_objectPath.empty())
+		start();
+}
+
+void SharedBrowser::subscribe(void const *handle, SlotSignal const &signal, SlotErrorLog const &errorLog)
+{
+	if (m_linger.connected())
+	{
+		/* the subscribing handle already holds a reference */
+		m_linger.disconnect();
+		m_client.m_lingeringBrowsers.erase(this);
+	}
+
+	m_subscribers.push_back(Subscriber{handle, signal, errorLog});
+	m_subscriberCount++;
+}
+
+void SharedBrowser::unsubscribe(void const *handle)
+{
+	auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(), [handle](Subscriber const &subscriber)
+	{
+		return subscriber.handle == handle;
+	});
+	if (it == m_subscribers.end())
+		return;
+
+	m_subscriberCount--;
+	if (m_dispatching)
+		it->handle = nullptr;  // removed after dispatching
+	else
+		m_subscribers.erase(it);
+}
+
+void SharedBrowser::replay(void const *handle)
+{
+	auto const self = shared_from_this();
+
+	m_dispatching++;
+	for (auto const &[sequence, parameters] : m_items)
+	{
+		auto *subscriber = find(handle);
+		if (!subscriber)
+			break;  // handle has been destroyed by one of its handlers
+		subscriber->signal("ItemNew", parameters);
+	}
+
+	/* both signals have no parameters ("()") */
+	if (m_cacheExhausted)
+	{
+		if (auto *subscriber = find(handle))
+			subscriber->signal("CacheExhausted", Glib::VariantContainerBase(::g_variant_new_tuple(nullptr, 0)));
+	}
+	if (m_allForNow)
+	{
+		if (auto *subscriber = find(handle))
+			subscriber->signal("AllForNow", Glib::VariantContainerBase(::g_variant_new_tuple(nullptr, 0)));
+	}
+	finishDispatch();
+}
+
+void SharedBrowser::linger(unsigned int linger_msec)
+{
+	if (m_linger.connected())
+		return;
+
+	m_client.m_lingeringBrowsers.emplace(this, shared_from_this());
+	m_linger = Glib::MainContext::get_thread_default()->signal_timeout().connect([this]
+	{
+		/* release the connection without disconnecting the running handler */
+		m_linger = sigc::connection();
+		m_client.m_lingeringBrowsers.erase(this);  // may destroy this object
+		return false;  // disconnect
+	}, linger_msec);
+}
+
+void SharedBrowser::retire()
+{
+	m_defunct = true;
+
+	auto it = m_client.m_browsers.find(m_key);
+	if (it != m_client.m_browsers.end() && it->second.lock().get() == this)
+		m_client.m_browsers.erase(it);
+}
+
+void SharedBrowser::start()
+{
+	auto const &connection = m_client.getConnection();
+
+	m_started = true;
+	m_client.call(
+		Client::Operation::Start, m_objectPath, m_interfaceName, "Start",
+		Glib::VariantContainerBase(),
+		[weak = weak_from_this(), connection](Glib::RefPtr<Gio::AsyncResult> &result)
+		{
+			try
+			{
+				connection->call_finish(result);
+			}
+			catch (Glib::Error const &e)
+			{
+				auto self = weak.lock();
+				if (!self)
+					return;
+
+				std::stringstream ss;
+
+				ss << self->m_logPrefix << ": D-Bus call \"Start\" failed: " << e.what();
+				self->errorLog(ss.str().c_str());
+			}
+		}
+	);
+}
+
+void SharedBrowser::onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	if (signalName == "ItemNew")
+		recordItem(parameters, /*added*/true);
+	else if (signalName == "ItemRemove")
+		recordItem(parameters, /*added*/false);
+	else if (signalName == "CacheExhausted")
+		m_cacheExhausted = true;
+	else if (signalName == "AllForNow")
+		m_allForNow = true;
+	else if (signalName == "Failure")
+		retire();
+
+	/* a handler may release the last handle */
+	auto const self = shared_from_this();
+
+	m_dispatching++;
+	for (std::size_t i = 0; i < m_subscribers.size(); i++)
+	{
+		if (m_subscribers[i].handle)
+			m_subscribers[i].signal(signalName, parameters);
+	}
+	finishDispatch();
+}
+
+void SharedBrowser::onSession(bool available)
+{
+	if (!available)
+	{
+		/* daemon side object is gone (Client has already dropped the
+		 * signal routing).  A re-created one reports all items again. */
+		m_objectPath.clear();
+		m_started = false;
+		m_items.clear();
+		m_itemIndex.clear();
+		m_recording = true;
+		m_cacheExhausted = false;
+		m_allForNow = false;
+
+		/* A still existing connection means Client::releaseAll(): this
+		 * object will not be re-created. */
+		if (!m_client.m_persistentSession || m_client.getConnection())
+			retire();
+		return;
+	}
+
+	if (m_defunct || !m_prepared)
+		return;
+
+	m_client.restoreObject(m_operation, m_methodName, m_parameters, m_interfaceName,
+		weak_from_this(), sigc::mem_fun(*this, &SharedBrowser::rebind));
+}
+
+void SharedBrowser::rebind(Glib::ustring const &objectPath, Glib::Error const &error)
+{
+	if (error)
+	{
+		std::stringstream ss;
+
+		ss << m_logPrefix << ": Cannot re-create " << (m_operation == Client::Operation::RecordBrowserPrepare ? "record" : "service")
+		   << " browser: " << error.what();
+		retire();
+		errorLog(ss.str().c_str());
+		return;
+	}
+
+	m_objectPath = objectPath;
+	m_client.registerObject(m_objectPath, m_interfaceName, sigc::mem_fun(*this, &SharedBrowser::onSignal));
+	activate();
+}
+
+void SharedBrowser::errorLog(char const *error)
+{
+	auto const self = shared_from_this();
+
+	m_dispatching++;
+	for (std::size_t i = 0; i < m_subscribers.size(); i++)
+	{
+		if (m_subscribers[i].handle)
+			m_subscribers[i].errorLog(error);
+	}
+	finishDispatch();
+}
+
+void SharedBrowser::finishDispatch()
+{
+	if (--m_dispatching)
+		return;
+
+	m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(), [](Subscriber const &subscriber)
+	{
+		return subscriber.handle == nullptr;
+	}), m_subscribers.end());
+}
+
+SharedBrowser::Subscriber *SharedBrowser::find(void const *handle)
+{
+	auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(), [handle](Subscriber const &subscriber)
+	{
+		return subscriber.handle == handle;
+	});
+	return it != m_subscribers.end() ? &*it : nullptr;
+}
+
+bool SharedBrowser::mayReplay() const
+{
+	return m_client.m_browserLinger || !m_waiters.empty() || m_pendingHandles || m_subscriberCount > 1;
+}
+
+void SharedBrowser::recordItem(Glib::VariantContainerBase const &parameters, bool added)
+{
+	if (!m_recording)
+		return;
+	if (!mayReplay())
+	{
+		/* nobody can subscribe later, filtered out traffic should not cost
+		 * any allocations */
+		m_recording = false;
+		m_items.clear();
+		m_itemIndex.clear();
+		return;
+	}
+
+	auto const hash = itemHash(parameters);
+	auto [first, last] = m_itemIndex.equal_range(hash);
+	auto it = std::find_if(first, last, [this, &parameters](auto const &entry)
+	{
+		return sameItem(m_items.at(entry.second), parameters);
+	});
+
+	if (it != last)
+	{
+		/* removed or reported again (e.g. with other flags) */
+		m_items.erase(it->second);
+		m_itemIndex.erase(it);
+	}
+	if (added)
+	{
+		auto const sequence = m_sequence++;
+		m_itemIndex.emplace(hash, sequence);
+		m_items.emplace(sequence, parameters);
+	}
+}
+
+std::uint64_t SharedBrowser::itemHash(Glib::VariantContainerBase const &parameters)
+{
+	auto *variant = const_cast<GVariant *>(parameters.gobj());
+	auto const children = ::g_variant_n_children(variant);
+	std::uint64_t hash = 14695981039346656037u;  // FNV-1a
+
+	auto const add = [&hash](void const *data, std::size_t size)
+	{
+		for (std::size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<std::uint8_t const *>(data)[i];
+			hash *= 1099511628211u;
+		}
+	};
+
+	/* all children except the trailing flags, each prefixed by its size */
+	for (gsize i = 0; i + 1 < children; i++)
+	{
+		auto *child = ::g_variant_get_child_value(variant, i);
+		auto const size = static_cast<std::uint32_t>(::g_variant_get_size(child));
+
+		add(&size, sizeof(size));
+		add(::g_variant_get_data(child), size);
+		::g_variant_unref(child);
+	}
+	return hash;
+}
+
+bool SharedBrowser::sameItem(Glib::VariantContainerBase const &a, Glib::VariantContainerBase const &b)
+{
+	auto *variantA = const_cast<GVariant *>(a.gobj());
+	auto *variantB = const_cast<GVariant *>(b.gobj());
+	auto const children = ::g_variant_n_children(variantA);
+
+	if (children != ::g_variant_n_children(variantB))
+		return false;
+
+	bool same = true;
+	for (gsize i = 0; same && i + 1 < children; i++)
+	{
+		auto *childA = ::g_variant_get_child_value(variantA, i);
+		auto *childB = ::g_variant_get_child_value(variantB, i);
+
+		same = ::g_variant_equal(childA, childB);
+		::g_variant_unref(childA);
+		::g_variant_unref(childB);
+	}
+	return same;
+}
+
+} /* namespace Avahi */
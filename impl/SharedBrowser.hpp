@@ -0,0 +1,196 @@
+/**
+ *  \file
+ *  \brief Daemon side browser object shared by identical browser requests
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Internal header, not part of the public API.
+ */
+
+#ifndef SRC_AVAHI_IMPL_SHAREDBROWSER_HPP_
+#define SRC_AVAHI_IMPL_SHAREDBROWSER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <giomm/cancellable.h>
+#include <glibmm/refptr.h>
+#include <glibmm/ustring.h>
+#include <glibmm/variant.h>
+#include <sigc++/connection.h>
+#include <sigc++/functors/slot.h>
+
+#include "../Client.hpp"
+
+namespace Glib {
+	class Error;
+}  // namespace Glib
+
+namespace Avahi {
+
+/** Daemon side record/service browser, shared by all RecordBrowser or
+ *  ServiceBrowser handles which have been created with identical
+ *  parameters (see Client::acquireBrowser()).
+ *
+ *  All D-Bus signals are forwarded to every subscribed handle.  While
+ *  another handle may subscribe (see isReplayable()), the currently known
+ *  items are recorded, so a handle which subscribes later can be brought up
+ *  to date via replay().  The daemon side object is
+ *  started when the first handle is active and freed when this object is
+ *  destroyed (i.e. when the last handle has been released and the linger
+ *  time has elapsed).
+ */
+class SharedBrowser : public std::enable_shared_from_this<SharedBrowser>
+{
+public:   // types
+	/** Receives the D-Bus signals (like Client::SlotSignal). */
+	using SlotSignal   = sigc::slot<void(std::string_view signalName, Glib::VariantContainerBase const &parameters)>;
+	/** Receives error messages for the application's log file. */
+	using SlotErrorLog = sigc::slot<void(char const *error)>;
+
+	/** Request which waits for the daemon side object being prepared. */
+	struct Waiter
+	{
+		Glib::RefPtr<Gio::Cancellable> cancellable;
+		Client::SlotAcquireBrowser completion;
+	};
+
+public:   // methods
+	/** \param[in]  client         Owning client.
+	 *  \param[in]  key            Key in Client::m_browsers.
+	 *  \param[in]  operation      "*Prepare" operation (for re-creating the
+	 *                             daemon side object).
+	 *  \param[in]  methodName     Name of the D-Bus method for \a operation.
+	 *  \param[in]  interfaceName  D-Bus interface of the daemon side object.
+	 *  \param[in]  parameters     Parameters of \a methodName.
+	 */
+	SharedBrowser(Client &client, std::string const &key, Client::Operation operation,
+	              char const *methodName, char const *interfaceName,
+	              Glib::VariantContainerBase const &parameters);
+	~SharedBrowser();
+	SharedBrowser(SharedBrowser const &other) = delete;
+	SharedBrowser& operator=(SharedBrowser const &other) = delete;
+
+	/** Attaches this object to the (prepared, not yet started) daemon side
+	 *  object. */
+	void bind(Glib::ustring const &objectPath);
+	/** Whether bind() has been called (the daemon side object may still be
+	 *  gone temporarily after the daemon has vanished). */
+	bool isPrepared() const { return m_prepared; }
+	/** Whether this object must not be used for new handles (the daemon
+	 *  side object has failed or is gone for good). */
+	bool isDefunct() const { return m_defunct; }
+
+	/** Whether a new handle can be brought up to date via replay().  The
+	 *  items are only recorded while another handle may subscribe (linger
+	 *  enabled, requests waiting or more than one handle); once an item has
+	 *  been missed, new requests create a new daemon side object. */
+	bool isReplayable() const { return m_recording; }
+	/** Announces (resp. revokes) a request which will subscribe a new
+	 *  handle soon, so that no items are missed in the meantime. */
+	void addPendingHandle() { m_pendingHandles++; }
+	void removePendingHandle() { m_pendingHandles--; }
+
+	/** Removes this object from Client::m_browsers (new requests will
+	 *  create a new daemon side object). */
+	void retire();
+
+	void addWaiter(Glib::RefPtr<Gio::Cancellable> const &cancellable, Client::SlotAcquireBrowser const &completion);
+	/** Returns (and removes) all waiting requests. */
+	std::vector<Waiter> takeWaiters();
+
+	/** Starts the daemon side object (if not already done and at least one
+	 *  handle is subscribed). */
+	void activate();
+
+	void subscribe(void const *handle, SlotSignal const &signal, SlotErrorLog const &errorLog);
+	void unsubscribe(void const *handle);
+	std::size_t subscribers() const { return m_subscriberCount; }
+
+	/** Reports all currently known items (and "CacheExhausted"/"AllForNow"
+	 *  if already received) to \a handle. */
+	void replay(void const *handle);
+
+	/** Keeps this object alive (in Client::m_lingeringBrowsers) until
+	 *  \a linger_msec have elapsed or a new handle subscribes. */
+	void linger(unsigned int linger_msec);
+
+private:  // types
+	struct Subscriber
+	{
+		void const *handle;
+		SlotSignal signal;
+		SlotErrorLog errorLog;
+	};
+
+private:  // methods
+	/** Starts the daemon side object. */
+	void start();
+	/** Handler for all D-Bus signals of the daemon side object. */
+	void onSignal(std::string_view signalName, Glib::VariantContainerBase const &parameters);
+	void onSession(bool available);
+	void rebind(Glib::ustring const &objectPath, Glib::Error const &error);
+	/** Forwards \a error to the on_errorLog handlers of all handles. */
+	void errorLog(char const *error);
+	/** Removes the entries of handles which have unsubscribed during
+	 *  dispatching (after the outermost dispatch). */
+	void finishDispatch();
+	Subscriber *find(void const *handle);
+	/** Whether a handle may subscribe later (see isReplayable()). */
+	bool mayReplay() const;
+	/** Records or removes the item of an "ItemNew"/"ItemRemove" signal. */
+	void recordItem(Glib::VariantContainerBase const &parameters, bool added);
+	/** Hash of an item's identity (all parameters of "ItemNew"/"ItemRemove"
+	 *  except the flags), computed on the borrowed child data. */
+	static std::uint64_t itemHash(Glib::VariantContainerBase const &parameters);
+	/** Whether \a a and \a b describe the same item (flags are ignored). */
+	static bool sameItem(Glib::VariantContainerBase const &a, Glib::VariantContainerBase const &b);
+
+private:  // members
+	Client &m_client;
+	std::string m_key;
+	Client::Operation m_operation;
+	char const *m_methodName;
+	char const *m_interfaceName;
+	Glib::VariantContainerBase m_parameters;
+	/** For log messages ("ServiceBrowser"/"RecordBrowser"). */
+	char const *m_logPrefix;
+	/** Empty while detached from the daemon side object. */
+	Glib::ustring m_objectPath;
+	bool m_prepared;
+	bool m_started;
+	bool m_defunct;
+
+	/** Entries of handles which unsubscribe while a signal is being
+	 *  dispatched are only cleared (handle == nullptr) and removed after
+	 *  dispatching. */
+	std::vector<Subscriber> m_subscribers;
+	std::size_t m_subscriberCount;
+	std::vector<Waiter> m_waiters;
+	unsigned int m_dispatching;
+
+	/** Parameters of the "ItemNew" signals of all known items, in order of
+	 *  arrival. */
+	std::map<std::uint64_t, Glib::VariantContainerBase> m_items;
+	/** Sequence numbers in #m_items by itemHash(). */
+	std::unordered_multimap<std::uint64_t, std::uint64_t> m_itemIndex;
+	std::uint64_t m_sequence;
+	/** See isReplayable(). */
+	bool m_recording;
+	/** See addPendingHandle(). */
+	std::size_t m_pendingHandles;
+	bool m_cacheExhausted;
+	bool m_allForNow;
+
+	sigc::connection m_linger;
+};
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_IMPL_SHAREDBROWSER_HPP_ */
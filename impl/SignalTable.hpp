@@ -0,0 +1,243 @@
+/**
+ *  \file
+ *  \brief Compile-time tables for decoding and dispatching D-Bus signals
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ *
+ *  Internal header, not part of the public API.
+ *
+ *  A proxy class describes its D-Bus signals by a constexpr table of
+ *  SignalHandler entries, each made of the signal name and a member
+ *  function taking the decoded parameters:
+ *
+ *  \code
+ *  static constexpr SignalHandler<ServiceBrowser> handlers[] = {
+ *      signalHandler<&ServiceBrowser::onItemNew>("ItemNew"),
+ *      signalHandler<&ServiceBrowser::onFailure>("Failure"),
+ *  };
+ *  \endcode
+ *
+ *  The GVariant type string (e.g. "(iisssu)") and the g_variant_get() format
+ *  string (e.g. "(ii&s&s&su)") are generated at compile time from the
+ *  parameter types of the member function.  On dispatch, the type of the
+ *  received parameters is checked once; afterwards the values are taken
+ *  without further checks, RTTI or exceptions.  Strings and byte arrays are
+ *  passed as views into the received message (valid during the call only).
+ */
+
+#ifndef SRC_AVAHI_IMPL_SIGNALTABLE_HPP_
+#define SRC_AVAHI_IMPL_SIGNALTABLE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <glibmm/variant.h>
+
+#include <glib.h>                      // G_VARIANT_TYPE
+
+#include "../Views.hpp"
+
+namespace Avahi {
+
+/** Describes how a handler parameter of type \a T is decoded.  Only the
+ *  types specialized below are supported. */
+template <typename T>
+struct SignalArg;
+
+template <>
+struct SignalArg<std::int32_t>
+{
+	static constexpr std::string_view type = "i";
+	static constexpr std::string_view format = "i";
+	using Raw = gint32;
+	static std::int32_t get(Raw raw) { return raw; }
+	static void release(Raw /*raw*/) {}
+};
+
+template <>
+struct SignalArg<std::uint32_t>
+{
+	static constexpr std::string_view type = "u";
+	static constexpr std::string_view format = "u";
+	using Raw = guint32;
+	static std::uint32_t get(Raw raw) { return raw; }
+	static void release(Raw /*raw*/) {}
+};
+
+template <>
+struct SignalArg<std::uint16_t>
+{
+	static constexpr std::string_view type = "q";
+	static constexpr std::string_view format = "q";
+	using Raw = guint16;
+	static std::uint16_t get(Raw raw) { return raw; }
+	static void release(Raw /*raw*/) {}
+};
+
+/** Points into the message, no copy. */
+template <>
+struct SignalArg<StringView>
+{
+	static constexpr std::string_view type = "s";
+	static constexpr std::string_view format = "&s";
+	using Raw = gchar const *;
+	static StringView get(Raw raw) { return StringView(raw); }
+	static void release(Raw /*raw*/) {}
+};
+
+/** Points into the message, no copy. */
+template <>
+struct SignalArg<ByteView>
+{
+	static constexpr std::string_view type = "ay";
+	static constexpr std::string_view format = "@ay";
+	using Raw = GVariant *;
+	static ByteView get(Raw raw)
+	{
+		gsize size = 0;
+		auto const *data = static_cast<std::uint8_t const *>(::g_variant_get_fixed_array(raw, &size, sizeof(std::uint8_t)));
+		return ByteView(data, size);
+	}
+	static void release(Raw raw) { if (raw) ::g_variant_unref(raw); }
+};
+
+/** Views the child variant, which is released after the handler returns. */
+template <>
+struct SignalArg<TxtView>
+{
+	static constexpr std::string_view type = "aay";
+	static constexpr std::string_view format = "@aay";
+	using Raw = GVariant *;
+	static TxtView get(Raw raw) { return TxtView(raw); }
+	static void release(Raw raw) { if (raw) ::g_variant_unref(raw); }
+};
+
+/** Returns "(" + \a parts + ")" as NUL terminated string of \a Size chars. */
+template <std::size_t Size>
+constexpr std::array<char, Size> makeTupleString(std::initializer_list<std::string_view> parts)
+{
+	std::array<char, Size> result{};
+	std::size_t i = 0;
+
+	result[i++] = '(';
+	for (auto const part : parts)
+	{
+		for (auto const c : part)
+			result[i++] = c;
+	}
+	result[i++] = ')';
+	return result;
+}
+
+/** Type and format strings for parameters of types \a Args. */
+template <typename... Args>
+struct SignalSignature
+{
+	/** GVariant type string, e.g. "(iisssu)". */
+	static constexpr auto type = makeTupleString<(SignalArg<Args>::type.size() + ... + 0) + 3>({SignalArg<Args>::type...});
+	/** Format string for g_variant_get(), e.g. "(ii&s&s&su)". */
+	static constexpr auto format = makeTupleString<(SignalArg<Args>::format.size() + ... + 0) + 3>({SignalArg<Args>::format...});
+};
+
+/** Raw values returned by g_variant_get(); releases child variants on
+ *  destruction. */
+template <typename... Args>
+struct SignalValues
+{
+	~SignalValues()
+	{
+		std::apply([](auto &...values) { (SignalArg<Args>::release(values), ...); }, raw);
+	}
+
+	std::tuple<typename SignalArg<Args>::Raw...> raw{};
+};
+
+/** Entry of a signal table (see signalHandler()). */
+template <typename Receiver>
+struct SignalHandler
+{
+	std::string_view name;
+	/** GVariant type string of the parameters. */
+	char const *type;
+	/** Decodes the (already type checked) parameters and invokes the
+	 *  member function. */
+	void (*invoke)(Receiver &receiver, GVariant *parameters);
+};
+
+template <typename Method>
+struct SignalMethod;
+
+template <typename Receiver_, typename... Args>
+struct SignalMethod<void (Receiver_::*)(Args...)>
+{
+	using Receiver = Receiver_;
+	using Signature = SignalSignature<std::decay_t<Args>...>;
+
+	template <void (Receiver::*Method)(Args...)>
+	static void invoke(Receiver &receiver, GVariant *parameters)
+	{
+		decode<Method>(receiver, parameters, std::index_sequence_for<Args...>());
+	}
+
+	template <void (Receiver::*Method)(Args...), std::size_t... Index>
+	static void decode(Receiver &receiver, GVariant *parameters, std::index_sequence<Index...>)
+	{
+		SignalValues<std::decay_t<Args>...> values;
+
+		if constexpr (sizeof...(Args) > 0)
+			::g_variant_get(parameters, Signature::format.data(), &std::get<Index>(values.raw)...);
+		else
+			static_cast<void>(parameters);
+		(receiver.*Method)(SignalArg<std::decay_t<Args>>::get(std::get<Index>(values.raw))...);
+	}
+};
+
+/** Creates the table entry for signal \a name handled by \a Method. */
+template <auto Method>
+constexpr SignalHandler<typename SignalMethod<decltype(Method)>::Receiver> signalHandler(std::string_view name)
+{
+	using Traits = SignalMethod<decltype(Method)>;
+
+	return {name, Traits::Signature::type.data(), &Traits::template invoke<Method>};
+}
+
+enum class SignalResult
+{
+	Handled,
+	/** Not contained in the table (ignored). */
+	Unknown,
+	/** Parameters have an unexpected type (handler not invoked). */
+	ParseError,
+};
+
+/** Invokes the handler for \a signalName from \a handlers. */
+template <typename Receiver, std::size_t Count>
+SignalResult dispatchSignal(SignalHandler<Receiver> const (&handlers)[Count], Receiver &receiver,
+                            std::string_view signalName, Glib::VariantContainerBase const &parameters)
+{
+	for (auto const &handler : handlers)
+	{
+		if (handler.name != signalName)
+			continue;
+
+		/* missing parameters are accepted for signals without parameters */
+		auto *variant = const_cast<GVariant *>(parameters.gobj());
+		if (variant ? !::g_variant_is_of_type(variant, G_VARIANT_TYPE(handler.type))
+		            : std::string_view(handler.type) != "()")
+			return SignalResult::ParseError;
+
+		handler.invoke(receiver, variant);
+		return SignalResult::Handled;
+	}
+	return SignalResult::Unknown;
+}
+
+} /* namespace Avahi */
+
+#endif /* SRC_AVAHI_IMPL_SIGNALTABLE_HPP_ */
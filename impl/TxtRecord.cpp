@@ -0,0 +1,289 @@
+/**
+ *  \file
+ *  \brief Compact TXT record with case-insensitive key lookup
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <glibmm/variant.h>
+
+#include <glib.h>
+
+#include "../TxtRecord.hpp"            // IWYU pragma: associated
+
+namespace Avahi {
+
+namespace {
+
+std::uint8_t toLower(std::uint8_t c)
+{
+	return (c >= 'A' && c <= 'Z') ? static_cast<std::uint8_t>(c - 'A' + 'a') : c;
+}
+
+/** Length of the key of a TXT string (up to the first '='). */
+std::size_t keyLength(std::uint8_t const *data, std::size_t size)
+{
+	if (!size)
+		return 0;
+
+	auto const *separator = static_cast<std::uint8_t const *>(std::memchr(data, '=', size));
+	return separator ? static_cast<std::size_t>(separator - data) : size;
+}
+
+/** FNV-1a over the lower-cased key. */
+std::uint32_t hashKey(std::uint8_t const *key, std::size_t size)
+{
+	std::uint32_t hash = 2166136261u;
+
+	for (std::size_t i = 0; i < size; i++)
+	{
+		hash ^= toLower(key[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool equalKeys(std::uint8_t const *a, std::uint8_t const *b, std::size_t size)
+{
+	for (std::size_t i = 0; i < size; i++)
+		if (toLower(a[i]) != toLower(b[i]))
+			return false;
+	return true;
+}
+
+}  // namespace
+
+TxtRecord::TxtRecord(Txt const &txt)
+{
+	std::size_t total = 0;
+	for (auto const &entry : txt)
+		total += entry.size();
+
+	m_data.reserve(total);
+	m_ends.reserve(txt.size());
+	for (auto const &entry : txt)
+		append(entry.data(), entry.size());
+}
+
+TxtRecord::TxtRecord(std::initializer_list<std::string_view> entries)
+{
+	std::size_t total = 0;
+	for (auto const &entry : entries)
+		total += entry.size();
+
+	m_data.reserve(total);
+	m_ends.reserve(entries.size());
+	for (auto const &entry : entries)
+		append(reinterpret_cast<std::uint8_t const *>(entry.data()), entry.size());
+}
+
+TxtRecord::TxtRecord(TxtView const &view)
+{
+	/* The serialized size of the variant (strings + framing offsets) is
+	 * an upper bound for the required buffer. */
+	if (view.gobj())
+		m_data.reserve(::g_variant_get_size(view.gobj()));
+	m_ends.reserve(view.size());
+
+	for (auto const &entry : view)
+		append(entry.data(), entry.size());
+}
+
+bool TxtRecord::equals(TxtView const &view) const
+{
+	if (view.size() != size())
+		return false;
+
+	std::size_t begin = 0;
+	for (std::size_t i = 0; i < size(); i++)
+	{
+		auto const string = view[i];
+		std::size_t const end = m_ends[i];
+
+		if (string.size() != end - begin)
+			return false;
+		if (string.size() && std::memcmp(string.data(), m_data.data() + begin, string.size()) != 0)
+			return false;
+		begin = end;
+	}
+	return true;
+}
+
+TxtRecord::Entry TxtRecord::operator[](std::size_t index) const
+{
+	std::size_t const begin = index ? m_ends[index - 1] : 0;
+	std::size_t const size = m_ends[index] - begin;
+	auto const *data = m_data.data() + begin;
+	std::size_t const keySize = keyLength(data, size);
+	bool const hasValue = keySize < size;
+
+	return Entry{
+		ByteView(data, size),
+		StringView(reinterpret_cast<char const *>(data), keySize),
+		hasValue ? ByteView(data + keySize + 1, size - keySize - 1) : ByteView(),
+		hasValue
+	};
+}
+
+std::optional<TxtRecord::Entry> TxtRecord::find(std::string_view key) const
+{
+	auto const index = lookup(key);
+	if (index == npos)
+		return std::nullopt;
+
+	return (*this)[index];
+}
+
+TxtRecord &TxtRecord::add(ByteView entry)
+{
+	append(entry.data(), entry.size());
+	return *this;
+}
+
+TxtRecord &TxtRecord::add(std::string_view key, std::string_view value)
+{
+	m_data.insert(m_data.end(), key.begin(), key.end());
+	m_data.push_back('=');
+	m_data.insert(m_data.end(), value.begin(), value.end());
+	m_ends.push_back(static_cast<std::uint32_t>(m_data.size()));
+	index(m_ends.size() - 1);
+
+	return *this;
+}
+
+TxtRecord &TxtRecord::add(std::string_view key)
+{
+	append(reinterpret_cast<std::uint8_t const *>(key.data()), key.size());
+	return *this;
+}
+
+void TxtRecord::clear()
+{
+	m_data.clear();
+	m_ends.clear();
+	m_index.clear();
+}
+
+Txt TxtRecord::toTxt() const
+{
+	Txt txt;
+
+	txt.reserve(size());
+	for (auto const &entry : *this)
+		txt.emplace_back(entry.raw.toVector());
+
+	return txt;
+}
+
+Glib::VariantBase TxtRecord::toVariant() const
+{
+	/* Serialized "aay" (see GVariant specification, "Arrays" of non-fixed
+	 * width elements): the concatenated elements (alignment 1, so no
+	 * padding) followed by the little endian end offset of each element.
+	 * The width of the offsets depends on the total size. */
+	std::size_t const body = m_data.size();
+	std::size_t const count = m_ends.size();
+	std::size_t width = 8;
+
+	if (body + count * 1 <= G_MAXUINT8)
+		width = 1;
+	else if (body + count * 2 <= G_MAXUINT16)
+		width = 2;
+	else if (body + count * 4 <= G_MAXUINT32)
+		width = 4;
+
+	std::size_t const total = count ? body + count * width : 0;
+	auto *buffer = static_cast<std::uint8_t *>(::g_malloc(std::max<std::size_t>(total, 1)));
+
+	std::copy(m_data.begin(), m_data.end(), buffer);
+	auto *offset = buffer + body;
+	for (std::uint64_t end : m_ends)
+	{
+		for (std::size_t byte = 0; byte < width; byte++)
+			*offset++ = static_cast<std::uint8_t>(end >> (8 * byte));
+	}
+
+	return Glib::VariantBase(::g_variant_new_from_data(G_VARIANT_TYPE("aay"), buffer, total, TRUE, &::g_free, buffer));
+}
+
+void TxtRecord::append(std::uint8_t const *data, std::size_t size)
+{
+	m_data.insert(m_data.end(), data, data + size);
+	m_ends.push_back(static_cast<std::uint32_t>(m_data.size()));
+	index(m_ends.size() - 1);
+}
+
+std::size_t TxtRecord::lookup(std::string_view key) const
+{
+	if (m_index.empty() || key.empty())
+		return npos;
+
+	auto const *keyData = reinterpret_cast<std::uint8_t const *>(key.data());
+	std::size_t const mask = m_index.size() - 1;
+
+	for (std::size_t slot = hashKey(keyData, key.size()) & mask; m_index[slot]; slot = (slot + 1) & mask)
+	{
+		std::size_t const entry = m_index[slot] - 1;
+		std::size_t const begin = entry ? m_ends[entry - 1] : 0;
+		auto const *data = m_data.data() + begin;
+
+		if (keyLength(data, m_ends[entry] - begin) == key.size() && equalKeys(data, keyData, key.size()))
+			return entry;
+	}
+	return npos;
+}
+
+void TxtRecord::index(std::size_t entry)
+{
+	std::size_t const begin = entry ? m_ends[entry - 1] : 0;
+	auto const *data = m_data.data() + begin;
+	std::size_t const keySize = keyLength(data, m_ends[entry] - begin);
+
+	if (!keySize)
+		return;  // RFC 6763, 6.4: strings without key are silently ignored
+
+	/* keep the load factor below 1/2 */
+	if ((entry + 1) * 2 > m_index.size())
+		rehash(std::max<std::size_t>(8, m_index.size() * 2));
+
+	std::size_t const mask = m_index.size() - 1;
+	std::size_t slot = hashKey(data, keySize) & mask;
+	for (; m_index[slot]; slot = (slot + 1) & mask)
+	{
+		std::size_t const other = m_index[slot] - 1;
+		std::size_t const otherBegin = other ? m_ends[other - 1] : 0;
+		auto const *otherData = m_data.data() + otherBegin;
+
+		if (keyLength(otherData, m_ends[other] - otherBegin) == keySize && equalKeys(otherData, data, keySize))
+			return;  // RFC 6763, 6.4: only the first occurrence counts
+	}
+	m_index[slot] = static_cast<std::uint32_t>(entry + 1);
+}
+
+void TxtRecord::rehash(std::size_t buckets)
+{
+	std::vector<std::uint32_t> index(buckets, 0);
+	std::size_t const mask = buckets - 1;
+
+	for (auto const slot : m_index)
+	{
+		if (!slot)
+			continue;
+
+		std::size_t const entry = slot - 1;
+		std::size_t const begin = entry ? m_ends[entry - 1] : 0;
+		auto const *data = m_data.data() + begin;
+		std::size_t position = hashKey(data, keyLength(data, m_ends[entry] - begin)) & mask;
+
+		while (index[position])
+			position = (position + 1) & mask;
+		index[position] = slot;
+	}
+
+	m_index.swap(index);
+}
+
+} /* namespace Avahi */
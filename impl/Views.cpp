@@ -0,0 +1,44 @@
+/**
+ *  \file
+ *  \brief Non-owning views on data inside received D-Bus messages
+ *  \author Christian Eggers
+ *  \copyright 2026 ARRI Lighting Stephanskirchen
+ */
+
+#include <glib.h>
+
+#include "../Views.hpp"                // IWYU pragma: associated
+
+namespace Avahi {
+
+TxtView::TxtView(GVariant *variant)
+: m_variant(variant)
+, m_size(variant ? ::g_variant_n_children(variant) : 0)
+{
+}
+
+ByteView TxtView::operator[](std::size_t index) const
+{
+	/* For serialized variants (as received from D-Bus), the child shares the
+	 * buffer of its parent, so the returned pointer stays valid after
+	 * releasing the child. */
+	GVariant *child = ::g_variant_get_child_value(m_variant, index);
+	gsize size = 0;
+	auto const *data = static_cast<std::uint8_t const *>(::g_variant_get_fixed_array(child, &size, sizeof(std::uint8_t)));
+	::g_variant_unref(child);
+
+	return ByteView(data, size);
+}
+
+Txt TxtView::toTxt() const
+{
+	Txt txt;
+
+	txt.reserve(m_size);
+	for (auto const &entry : *this)
+		txt.emplace_back(entry.toVector());
+
+	return txt;
+}
+
+} /* namespace Avahi */